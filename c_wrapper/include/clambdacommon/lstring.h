@@ -91,14 +91,76 @@ bool lc_str_ends_with(const char* str, const char* suffix);
 
 bool lc_str_starts_with(const char* str, const char* prefix);
 
+/*!
+ * Parses the integer at the beginning of a string, like std::stoi: leading whitespaces, a sign and a base prefix are accepted, the trailing characters are ignored.
+ * @param integer The string to parse.
+ * @return The parsed integer, or 0 if the parse failed.
+ */
 int lc_str_parse_int(const char* integer);
 
 int lc_str_parse_int_base(const char* integer, int base);
 
+/*!
+ * Parses the integer at the beginning of a string, like std::stol, see lc_str_parse_int.
+ * @param longNumber The string to parse.
+ * @return The parsed integer, or 0 if the parse failed.
+ */
 long lc_str_parse_long(const char* longNumber);
 
 long lc_str_parse_long_base(const char* longNumber, int base);
 
+/*!
+ * Parses a 32-bit signed integer from a string, leading and trailing whitespaces are allowed.
+ * @param str The string to parse.
+ * @param base The base of the integer.
+ * @param value The parsed integer, left untouched if the parse failed.
+ * @return True if the string is a valid integer which fits in 32 bits, else false.
+ */
+bool lc_str_try_parse_i32(const char* str, int base, int32_t* value);
+
+/*!
+ * Parses a 64-bit signed integer from a string, leading and trailing whitespaces are allowed.
+ * @param str The string to parse.
+ * @param base The base of the integer.
+ * @param value The parsed integer, left untouched if the parse failed.
+ * @return True if the string is a valid integer which fits in 64 bits, else false.
+ */
+bool lc_str_try_parse_i64(const char* str, int base, int64_t* value);
+
+/*!
+ * Parses a 32-bit unsigned integer from a string, leading and trailing whitespaces are allowed.
+ * @param str The string to parse.
+ * @param base The base of the integer.
+ * @param value The parsed integer, left untouched if the parse failed.
+ * @return True if the string is a valid integer which fits in 32 bits, else false.
+ */
+bool lc_str_try_parse_u32(const char* str, int base, uint32_t* value);
+
+/*!
+ * Parses a 64-bit unsigned integer from a string, leading and trailing whitespaces are allowed.
+ * @param str The string to parse.
+ * @param base The base of the integer.
+ * @param value The parsed integer, left untouched if the parse failed.
+ * @return True if the string is a valid integer which fits in 64 bits, else false.
+ */
+bool lc_str_try_parse_u64(const char* str, int base, uint64_t* value);
+
+/*!
+ * Parses a float from a string, leading and trailing whitespaces are allowed.
+ * @param str The string to parse.
+ * @param value The parsed float, left untouched if the parse failed.
+ * @return True if the string is a valid float, else false.
+ */
+bool lc_str_try_parse_float(const char* str, float* value);
+
+/*!
+ * Parses a double from a string, leading and trailing whitespaces are allowed.
+ * @param str The string to parse.
+ * @param value The parsed double, left untouched if the parse failed.
+ * @return True if the string is a valid double, else false.
+ */
+bool lc_str_try_parse_double(const char* str, double* value);
+
 #ifdef __cplusplus
 }
 #endif
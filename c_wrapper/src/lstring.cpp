@@ -46,6 +46,9 @@ int lc_str_parse_int(const char* integer) {
 }
 
 int lc_str_parse_int_base(const char* integer, int base) {
+    // Keeps the std::stoi-like prefix parsing of the previous versions, see lc_str_try_parse_i32 for a whole string parse.
+    if (!integer)
+        return 0;
     return lambdacommon::lstring::parse_int(integer, base).value_or(0);
 }
 
@@ -54,5 +57,45 @@ long lc_str_parse_long(const char* longNumber) {
 }
 
 long lc_str_parse_long_base(const char* longNumber, int base) {
+    if (!longNumber)
+        return 0;
     return lambdacommon::lstring::parse_long(longNumber, base).value_or(0);
 }
+
+template<typename T>
+static bool try_parse(const char* str, int base, T* value) {
+    if (!str || !value)
+        return false;
+    return lambdacommon::lstring::parse(str, *value, base, lambdacommon::lstring::PARSE_LENIENT) == std::errc();
+}
+
+template<typename T>
+static bool try_parse_float(const char* str, T* value) {
+    if (!str || !value)
+        return false;
+    return lambdacommon::lstring::parse(str, *value, lambdacommon::lstring::PARSE_LENIENT) == std::errc();
+}
+
+bool lc_str_try_parse_i32(const char* str, int base, int32_t* value) {
+    return try_parse(str, base, value);
+}
+
+bool lc_str_try_parse_i64(const char* str, int base, int64_t* value) {
+    return try_parse(str, base, value);
+}
+
+bool lc_str_try_parse_u32(const char* str, int base, uint32_t* value) {
+    return try_parse(str, base, value);
+}
+
+bool lc_str_try_parse_u64(const char* str, int base, uint64_t* value) {
+    return try_parse(str, base, value);
+}
+
+bool lc_str_try_parse_float(const char* str, float* value) {
+    return try_parse_float(str, value);
+}
+
+bool lc_str_try_parse_double(const char* str, double* value) {
+    return try_parse_float(str, value);
+}
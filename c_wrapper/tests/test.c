@@ -85,6 +85,21 @@ int main() {
 
     TEST("lc_maths_clamp(32.f, 0.f, 1.f)", tests_count, tests_passed, lc_maths_clamp(32.f, 0.f, 1.f) == 1.f);
 
+    printf("Tests results: %u/%u\n", tests_passed, tests_count);
+    if (tests_passed != tests_count)
+        return 1;
+
+    printf("===== STRING SECTION =====\n");
+    tests_count = 0;
+    tests_passed = 0;
+
+    TEST("lc_str_parse_int(\"42abc\")", tests_count, tests_passed, lc_str_parse_int("42abc") == 42);
+
+    TEST("lc_str_parse_long_base(\"  -0x1F\", 16)", tests_count, tests_passed, lc_str_parse_long_base("  -0x1F", 16) == -31);
+
+    int32_t parsed = 0;
+    TEST("lc_str_try_parse_i32(\"42abc\", 10, &parsed)", tests_count, tests_passed, !lc_str_try_parse_i32("42abc", 10, &parsed) && parsed == 0);
+
     printf("Tests results: %u/%u\n", tests_passed, tests_count);
     if (tests_passed != tests_count)
         return 1;
@@ -0,0 +1,325 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef LAMBDACOMMON_BUFFER_H
+#define LAMBDACOMMON_BUFFER_H
+
+#include "lambdacommon.h"
+#include "types.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef LAMBDA_WINDOWS
+#  pragma warning(push)
+#  pragma warning(disable:4251)
+#else
+struct iovec;
+#endif
+
+namespace lambdacommon
+{
+    /*!
+     * BufferBlock
+     *
+     * Represents a fixed-size memory block of a pool, filled from the beginning.
+     * The filled bytes are immutable and may be shared by several chains, the free bytes are claimed atomically by the chain appending to the block.
+     */
+    class LAMBDACOMMON_API BufferBlock
+    {
+        friend class BlockPool;
+        friend class BufferChain;
+
+    private:
+        std::unique_ptr<char[]> _data;
+        size_t _capacity;
+        std::atomic<size_t> _used{0};
+
+        /*!
+         * Claims the free bytes following the specified offset.
+         * @param offset The offset, the end of the filled bytes.
+         * @param count The maximum number of bytes to claim.
+         * @return The number of claimed bytes, 0 if the bytes following the offset are already claimed.
+         */
+        size_t claim(size_t offset, size_t count);
+
+    public:
+        explicit BufferBlock(size_t capacity);
+
+        [[nodiscard]] char* data() const;
+
+        [[nodiscard]] size_t capacity() const;
+    };
+
+    /*!
+     * BlockPool
+     *
+     * Represents a thread-safe pool of fixed-size memory blocks, a block is given back to the pool once no chain references it.
+     * The blocks and the chains using the pool may outlive it.
+     */
+    class LAMBDACOMMON_API BlockPool
+    {
+        friend class BufferChain;
+
+    private:
+        struct State
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<BufferBlock>> free;
+            size_t block_size;
+            size_t max_free;
+            std::atomic<u64> allocations{0};
+        };
+
+        std::shared_ptr<State> _state;
+
+        static std::shared_ptr<BufferBlock> acquire(const std::shared_ptr<State>& state);
+
+    public:
+        /*!
+         * Creates a block pool.
+         * @param block_size The size of the blocks.
+         * @param max_free The maximum number of free blocks kept for reuse.
+         */
+        explicit BlockPool(size_t block_size = 16384, size_t max_free = 256);
+
+        /*!
+         * Acquires an empty block, a free block if any.
+         * @return The block.
+         */
+        std::shared_ptr<BufferBlock> acquire();
+
+        [[nodiscard]] size_t get_block_size() const;
+
+        /*!
+         * Gets the number of free blocks waiting for reuse.
+         * @return The number of free blocks.
+         */
+        [[nodiscard]] size_t get_free_count() const;
+
+        /*!
+         * Gets the number of blocks allocated by the pool since its creation.
+         * @return The number of allocations.
+         */
+        [[nodiscard]] u64 get_allocation_count() const;
+
+        /*!
+         * Gets the pool used by default by the buffer chains.
+         * @return The default pool.
+         */
+        static BlockPool& get_default();
+    };
+
+    /*!
+     * BufferChain
+     *
+     * Represents a sequence of bytes stored as a chain of slices, which reference either pooled blocks or bytes owned by another object
+     * (a mapped file for example). The slices are reference-counted: copying, splitting or appending chains shares the bytes instead of copying them,
+     * only appending raw bytes copies them, into the free bytes of the last block when possible.
+     *
+     * A chain is not thread-safe, but different chains sharing bytes may be used by different threads.
+     */
+    class LAMBDACOMMON_API BufferChain
+    {
+    private:
+        struct Slice
+        {
+            std::shared_ptr<const void> owner;
+            const char* data;
+            size_t size;
+            // The pooled block of the slice, null if the bytes are owned by another object.
+            BufferBlock* block;
+        };
+
+        // The state of the pool, shared so the chain can outlive the pool.
+        std::shared_ptr<BlockPool::State> _pool;
+        std::vector<Slice> _slices;
+        // The index of the first slice, the consumed slices are removed lazily.
+        size_t _first = 0;
+        size_t _size = 0;
+        std::vector<std::shared_ptr<BufferBlock>> _reserved;
+        size_t _reserved_tail = 0;
+
+        void push(Slice slice);
+
+        void pop_front();
+
+        explicit BufferChain(std::shared_ptr<BlockPool::State> pool);
+
+    public:
+        /*!
+         * Creates an empty chain using the default pool.
+         */
+        BufferChain();
+
+        /*!
+         * Creates an empty chain.
+         * @param pool The pool of the blocks of the appended bytes.
+         */
+        explicit BufferChain(BlockPool& pool);
+
+        /*!
+         * Creates a chain sharing the bytes of another chain.
+         * @param other The other chain.
+         */
+        BufferChain(const BufferChain& other);
+
+        BufferChain(BufferChain&& other) noexcept;
+
+        BufferChain& operator=(const BufferChain& other);
+
+        BufferChain& operator=(BufferChain&& other) noexcept;
+
+        /*!
+         * Appends a copy of bytes.
+         * @param data The bytes.
+         */
+        void append(std::string_view data);
+
+        /*!
+         * Appends the bytes of another chain, without copying them.
+         * @param other The other chain.
+         */
+        void append(const BufferChain& other);
+
+        void append(BufferChain&& other);
+
+        /*!
+         * Appends bytes owned by another object, without copying them.
+         * @param owner The owner of the bytes, which keeps them valid and immutable.
+         * @param bytes The bytes.
+         */
+        void append_shared(std::shared_ptr<const void> owner, std::string_view bytes);
+
+        /*!
+         * Removes the first bytes of the chain, without copying them.
+         * @param count The number of bytes.
+         * @return The removed bytes.
+         */
+        BufferChain split(size_t count);
+
+        /*!
+         * Removes the first bytes of the chain.
+         * @param count The number of bytes.
+         */
+        void consume(size_t count);
+
+        /*!
+         * Gets a part of the chain, without copying it.
+         * @param offset The offset of the first byte.
+         * @param count The number of bytes.
+         * @return The part of the chain.
+         */
+        [[nodiscard]] BufferChain slice(size_t offset, size_t count = std::string_view::npos) const;
+
+        void clear();
+
+        /*!
+         * Gets the number of bytes of the chain.
+         * @return The size of the chain.
+         */
+        [[nodiscard]] size_t size() const;
+
+        [[nodiscard]] bool empty() const;
+
+        [[nodiscard]] size_t get_slice_count() const;
+
+        /*!
+         * Gets the contiguous bytes of a slice.
+         * @param index The index of the slice.
+         * @return The bytes of the slice.
+         */
+        [[nodiscard]] std::string_view get_slice(size_t index) const;
+
+        /*!
+         * Gets the first contiguous bytes of the chain.
+         * @return The bytes of the first slice, or an empty view if the chain is empty.
+         */
+        [[nodiscard]] std::string_view front() const;
+
+        /*!
+         * Makes the bytes of the chain contiguous, copying them if they are stored in several slices.
+         * @return The bytes of the chain.
+         */
+        std::string_view linearize();
+
+        /*!
+         * Copies bytes of the chain.
+         * @param buffer The destination.
+         * @param size The maximum number of bytes to copy.
+         * @param offset The offset of the first byte to copy.
+         * @return The number of copied bytes.
+         */
+        size_t copy_to(char* buffer, size_t size, size_t offset = 0) const;
+
+        /*!
+         * Copies the bytes of the chain into a string.
+         * @return The bytes of the chain.
+         */
+        [[nodiscard]] std::string to_string() const;
+
+        bool operator==(const BufferChain& other) const;
+
+        bool operator!=(const BufferChain& other) const;
+
+        bool operator==(std::string_view other) const;
+
+        bool operator!=(std::string_view other) const;
+
+#ifndef LAMBDA_WINDOWS
+        /*!
+         * Exports the first slices for a scatter/gather write (writev).
+         * @param vectors The vectors to fill.
+         * @param max_vectors The maximum number of vectors.
+         * @return The number of filled vectors.
+         */
+        size_t export_iovec(iovec* vectors, size_t max_vectors) const;
+
+        /*!
+         * Prepares free bytes at the end of the chain for a scatter/gather read (readv), {@code commit} must be called before any other change.
+         * The free bytes of the last block are prepared first, then new blocks.
+         * @param vectors The vectors to fill.
+         * @param max_vectors The maximum number of vectors.
+         * @param size The maximum number of bytes to prepare.
+         * @return The number of filled vectors.
+         */
+        size_t prepare(iovec* vectors, size_t max_vectors, size_t size);
+
+        /*!
+         * Appends the bytes read into the prepared bytes.
+         * @param count The number of bytes read.
+         */
+        void commit(size_t count);
+
+        /*!
+         * Writes the first bytes of the chain to a file descriptor with a scatter/gather write, then removes the written bytes.
+         * @param fd The file descriptor.
+         * @return The number of written bytes, or -1 on error with errno set.
+         */
+        long write_to(int fd);
+
+        /*!
+         * Reads bytes from a file descriptor with a scatter/gather read, then appends them to the chain.
+         * @param fd The file descriptor.
+         * @param size The maximum number of bytes to read.
+         * @return The number of read bytes, 0 at the end of the file, or -1 on error with errno set.
+         */
+        long read_from(int fd, size_t size);
+#endif
+    };
+}
+
+#ifdef LAMBDA_WINDOWS
+#  pragma warning(pop)
+#endif
+
+#endif //LAMBDACOMMON_BUFFER_H
@@ -12,15 +12,27 @@
 
 #include "../serializable.h"
 #include "../types.h"
+#include "../hash.h"
+#include "../system/fs.h"
 #include <array>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 #ifdef LAMBDA_WINDOWS
 #  pragma warning(push)
 #  pragma warning(disable:4251)
 #endif
 
+struct sockaddr;
+struct sockaddr_storage;
+
 namespace lambdacommon
 {
+    class DNSResolver;
+
     typedef std::string host;
 
     enum AddressType
@@ -32,6 +44,140 @@ namespace lambdacommon
         INVALID
     };
 
+    /*!
+     * IPAddress
+     *
+     * Represents an IPv4 or IPv6 address in its binary form, in network byte order.
+     */
+    class LAMBDACOMMON_API IPAddress
+    {
+    private:
+        std::array<u8, 16> _bytes{};
+        AddressType _type = AddressType::EMPTY;
+
+    public:
+        /*!
+         * The maximum length of the textual form of an address.
+         */
+        static constexpr size_t MAX_STRING_SIZE = 45;
+
+        /*!
+         * Creates an empty address, which is neither IPv4 nor IPv6.
+         */
+        IPAddress() = default;
+
+        explicit IPAddress(const std::array<u8, 4>& ipv4);
+
+        explicit IPAddress(const std::array<u8, 16>& ipv6);
+
+        /*!
+         * Parses an IPv4 address in the dotted-decimal form, or an IPv6 address in the textual form of RFC 4291 (without zone index).
+         * @param address The address to parse.
+         * @return The address, or an empty optional if the address is invalid.
+         */
+        static std::optional<IPAddress> parse(std::string_view address);
+
+        /*!
+         * Reads the address and the port of a socket address.
+         * @param address The socket address.
+         * @param port The port of the socket address, if not null.
+         * @return The address, or an empty optional if the socket address is neither IPv4 nor IPv6.
+         */
+        static std::optional<IPAddress> from_sockaddr(const sockaddr* address, port_t* port = nullptr);
+
+        /*!
+         * Gets the type of address.
+         * @return IPv4, IPv6 or EMPTY.
+         */
+        [[nodiscard]] AddressType get_type() const;
+
+        [[nodiscard]] bool is_ipv4() const;
+
+        [[nodiscard]] bool is_ipv6() const;
+
+        /*!
+         * Gets the bytes of the address, the bytes after the size of the address are zero.
+         * @return The bytes of the address.
+         */
+        [[nodiscard]] const std::array<u8, 16>& get_bytes() const;
+
+        /*!
+         * Gets the number of bytes of the address.
+         * @return 4 for an IPv4 address, 16 for an IPv6 address, else 0.
+         */
+        [[nodiscard]] size_t size() const;
+
+        /*!
+         * Writes the textual form of the address, IPv6 addresses are written in the canonical form of RFC 5952.
+         * @param output The output buffer, of at least {@code MAX_STRING_SIZE} bytes.
+         * @return The number of written bytes.
+         */
+        size_t format(char* output) const;
+
+        [[nodiscard]] std::string to_string() const;
+
+        /*!
+         * Writes the address into a socket address.
+         * @param port The port.
+         * @param storage The socket address.
+         * @return The size of the socket address, or 0 if the address is empty.
+         */
+        size_t to_sockaddr(port_t port, sockaddr_storage& storage) const;
+
+        [[nodiscard]] size_t hash() const;
+
+        bool operator==(const IPAddress& other) const;
+
+        bool operator!=(const IPAddress& other) const;
+
+        bool operator<(const IPAddress& other) const;
+    };
+
+    /*!
+     * IPNetwork
+     *
+     * Represents a range of IP addresses in the CIDR notation, like 192.168.0.0/16.
+     */
+    class LAMBDACOMMON_API IPNetwork
+    {
+    private:
+        IPAddress _address;
+        u8 _prefix_length;
+
+    public:
+        /*!
+         * Creates a network, the bits of the address after the prefix are cleared.
+         * @param address The address of the network.
+         * @param prefix_length The number of bits of the prefix.
+         * @throws std::invalid_argument If the address is empty or if the prefix is longer than the address.
+         */
+        IPNetwork(const IPAddress& address, u8 prefix_length);
+
+        /*!
+         * Parses a network in the CIDR notation, an address without prefix length is a network of a single address.
+         * @param network The network to parse.
+         * @return The network, or an empty optional if the network is invalid.
+         */
+        static std::optional<IPNetwork> parse(std::string_view network);
+
+        [[nodiscard]] const IPAddress& get_address() const;
+
+        [[nodiscard]] u8 get_prefix_length() const;
+
+        /*!
+         * Checks whether the network contains the address, an IPv4 network doesn't contain IPv6 addresses and vice versa.
+         * @param address The address.
+         * @return True if the address is in the network, else false.
+         */
+        [[nodiscard]] bool contains(const IPAddress& address) const;
+
+        [[nodiscard]] std::string to_string() const;
+
+        bool operator==(const IPNetwork& other) const;
+
+        bool operator!=(const IPNetwork& other) const;
+    };
+
     /*!
      * Represents a network address.
      */
@@ -39,11 +185,19 @@ namespace lambdacommon
     {
     protected:
         host _host;
+        IPAddress _ip;
         port_t _port;
 
     public:
+        /*!
+         * Creates an address, an IP address host is parsed once into its binary form.
+         * @param host The host.
+         * @param port The port.
+         */
         Address(host host, port_t port = 0);
 
+        Address(const IPAddress& ip, port_t port = 0);
+
         Address(const Address& address);
 
         Address(Address&& address) noexcept;
@@ -62,6 +216,12 @@ namespace lambdacommon
          */
         port_t get_port() const;
 
+        /*!
+         * Gets the binary form of the host if the host is an IP address.
+         * @return The IP address, which is empty if the host is a domain name.
+         */
+        const IPAddress& get_ip() const;
+
         /*!
          * Checks whether the address is an IPv4 address.
          * @return True if the address is an IPv4 address, else false.
@@ -74,6 +234,10 @@ namespace lambdacommon
          */
         bool is_ipv6() const;
 
+        /*!
+         * Checks whether the address is a valid domain name, which ends with a known top-level domain, see {@code is_top_level_domain}.
+         * @return True if the address is a valid domain name, else false.
+         */
         bool is_domain_valid() const;
 
         /*!
@@ -100,6 +264,29 @@ namespace lambdacommon
 
         bool operator<(const Address& other) const;
 
+        /*!
+         * Writes the address into a socket address.
+         * @param storage The socket address.
+         * @return The size of the socket address, or 0 if the host is not an IP address.
+         */
+        size_t to_sockaddr(sockaddr_storage& storage) const;
+
+        /*!
+         * Reads an address from a socket address.
+         * @param address The socket address.
+         * @return The address, or an empty optional if the socket address is neither IPv4 nor IPv6.
+         */
+        static std::optional<Address> from_sockaddr(const sockaddr* address);
+
+        /*!
+         * Resolves the host of the address asynchronously, see {@code DNSResolver}.
+         * @param resolver The resolver.
+         * @return The future of the addresses of the host with the port of this address, or of no address if the host cannot be resolved.
+         */
+        std::future<std::vector<Address>> resolve_async(DNSResolver& resolver) const;
+
+        [[nodiscard]] size_t hash() const;
+
         template<std::size_t N>
         decltype(auto) get() const {
             if constexpr (N == 0) return this->_host;
@@ -108,10 +295,96 @@ namespace lambdacommon
 
         static Address EMPTY;
     };
+
+    /*!
+     * PublicSuffixList
+     *
+     * Represents a list of public suffixes in the format of the Public Suffix List (https://publicsuffix.org/list/),
+     * with the wildcard ("*.ck") and exception ("!www.ck") rules.
+     * The lookups are case-insensitive and don't allocate, the rules are matched byte-wise: internationalized domain names must be in their ASCII form.
+     */
+    class LAMBDACOMMON_API PublicSuffixList
+    {
+    private:
+        std::vector<std::string> _rules;
+        std::vector<std::string> _wildcards;
+        std::vector<std::string> _exceptions;
+        std::vector<std::string> _top_level_domains;
+
+        PublicSuffixList() = default;
+
+    public:
+        /*!
+         * Parses a public suffix list.
+         * @param content The content of the list, one rule per line, the lines starting with "//" are comments.
+         * @return The public suffix list.
+         */
+        static PublicSuffixList parse(std::string_view content);
+
+        /*!
+         * Loads a public suffix list from a file, see {@code parse}.
+         * @param path The path of the file.
+         * @return The public suffix list.
+         * @throws std::runtime_error If the file cannot be read.
+         */
+        static PublicSuffixList load(const fs::path& path);
+
+        /*!
+         * Checks whether the label is the top-level domain of a rule of the list.
+         * @param label The label.
+         * @return True if the label is a top-level domain, else false.
+         */
+        [[nodiscard]] bool is_top_level_domain(std::string_view label) const;
+
+        /*!
+         * Gets the public suffix of a domain name, which is the last label if no rule matches.
+         * @param domain The domain name.
+         * @return The public suffix, as a view into the domain name.
+         */
+        [[nodiscard]] std::string_view get_public_suffix(std::string_view domain) const;
+
+        /*!
+         * Gets the registrable domain of a domain name, which is the public suffix and the label before it.
+         * @param domain The domain name.
+         * @return The registrable domain as a view into the domain name, or an empty view if the domain name is a public suffix.
+         */
+        [[nodiscard]] std::string_view get_registrable_domain(std::string_view domain) const;
+
+        /*!
+         * Gets the number of rules of the list.
+         * @return The number of rules.
+         */
+        [[nodiscard]] size_t size() const;
+    };
+
+    /*!
+     * Checks whether the label is a known top-level domain, case-insensitively.
+     * The built-in list of top-level domains is used unless a public suffix list was set with {@code set_public_suffix_list}.
+     * @param label The label.
+     * @return True if the label is a top-level domain, else false.
+     */
+    extern bool LAMBDACOMMON_API is_top_level_domain(std::string_view label);
+
+    /*!
+     * Sets the public suffix list which defines the known top-level domains, it can be changed while other threads check domain names.
+     * @param list The public suffix list.
+     */
+    extern void LAMBDACOMMON_API set_public_suffix_list(PublicSuffixList list);
+
+    /*!
+     * Gets the public suffix list set with {@code set_public_suffix_list}.
+     * @return The public suffix list, which stays valid if replaced, or null if the built-in list of top-level domains is used.
+     */
+    extern std::shared_ptr<const PublicSuffixList> LAMBDACOMMON_API get_public_suffix_list();
+
+    /*!
+     * Restores the built-in list of top-level domains.
+     */
+    extern void LAMBDACOMMON_API reset_public_suffix_list();
 }
 
 
-// Structured bindings for lambdacommon::Address.
+// Structured bindings and hash for lambdacommon::Address.
 namespace std
 {
     template<>
@@ -124,6 +397,22 @@ namespace std
     {
         using type = decltype(std::declval<lambdacommon::Address>().get<N>());
     };
+
+    template<>
+    struct hash<lambdacommon::Address>
+    {
+        size_t operator()(const lambdacommon::Address& address) const noexcept {
+            return address.hash();
+        }
+    };
+
+    template<>
+    struct hash<lambdacommon::IPAddress>
+    {
+        size_t operator()(const lambdacommon::IPAddress& address) const noexcept {
+            return address.hash();
+        }
+    };
 }
 
 #ifdef LAMBDA_WINDOWS
@@ -0,0 +1,372 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef LAMBDACOMMON_EVENT_LOOP_H
+#define LAMBDACOMMON_EVENT_LOOP_H
+
+#include "address.h"
+#include "../buffer.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <system_error>
+#include <unordered_map>
+
+// The event loop uses epoll, it is only available on Linux.
+#ifdef __linux__
+
+struct epoll_event;
+
+namespace lambdacommon
+{
+    class EventLoop;
+
+    /*!
+     * EventSource
+     *
+     * Represents a file descriptor watched by an event loop, the loop keeps the source alive until it is closed.
+     * The event loop must outlive its sources.
+     */
+    class LAMBDACOMMON_API EventSource : public std::enable_shared_from_this<EventSource>
+    {
+        friend class EventLoop;
+
+    protected:
+        EventLoop& _loop;
+        int _fd;
+
+        EventSource(EventLoop& loop, int fd);
+
+        /*!
+         * Starts watching the file descriptor, in edge-triggered mode.
+         * @param events The epoll events to watch.
+         */
+        void watch(u32 events);
+
+        /*!
+         * Stops watching the file descriptor and closes it, the source is destroyed once no longer used by the loop nor by the user.
+         */
+        void close_source();
+
+        /*!
+         * Handles the events of the file descriptor, called by the loop.
+         * @param events The epoll events.
+         */
+        virtual void handle_events(u32 events) = 0;
+
+    public:
+        EventSource(const EventSource& other) = delete;
+
+        virtual ~EventSource();
+
+        EventSource& operator=(const EventSource& other) = delete;
+
+        [[nodiscard]] EventLoop& get_loop() const;
+
+        [[nodiscard]] int get_fd() const;
+
+        [[nodiscard]] bool is_open() const;
+
+        /*!
+         * Closes the source, it is no longer watched by the loop.
+         */
+        virtual void close();
+    };
+
+    typedef u64 TimerId;
+
+    /*!
+     * EventLoop
+     *
+     * Represents a single-threaded event loop over epoll: the sockets are non-blocking and watched in edge-triggered mode,
+     * their callbacks and the timers are called from the thread running the loop.
+     * Only {@code post} and {@code stop} may be called from other threads.
+     */
+    class LAMBDACOMMON_API EventLoop
+    {
+        friend class EventSource;
+
+    private:
+        struct Timer
+        {
+            std::function<void()> callback;
+            std::chrono::milliseconds period;
+        };
+
+        typedef std::pair<std::chrono::steady_clock::time_point, TimerId> TimerDeadline;
+
+        int _epoll_fd;
+        int _wake_fd;
+        size_t _max_events;
+        std::unique_ptr<epoll_event[]> _events;
+        std::unordered_map<int, std::shared_ptr<EventSource>> _sources;
+        // The sources closed during the current iteration, kept alive as their pending events reference them.
+        std::vector<std::shared_ptr<EventSource>> _closed;
+        std::unordered_map<TimerId, Timer> _timers;
+        std::priority_queue<TimerDeadline, std::vector<TimerDeadline>, std::greater<>> _deadlines;
+        TimerId _next_timer_id = 1;
+        std::mutex _posted_mutex;
+        std::vector<std::function<void()>> _posted;
+        std::atomic<bool> _stopping{false};
+        BlockPool _block_pool;
+
+        void run_timers();
+
+        void run_posted();
+
+    public:
+        /*!
+         * Creates an event loop.
+         * @param max_events The maximum number of events handled by iteration.
+         * @throws std::system_error If the epoll instance cannot be created.
+         */
+        explicit EventLoop(size_t max_events = 256);
+
+        EventLoop(const EventLoop& other) = delete;
+
+        /*!
+         * Destroys the event loop, its open sources are closed.
+         */
+        ~EventLoop();
+
+        EventLoop& operator=(const EventLoop& other) = delete;
+
+        /*!
+         * Runs the loop until {@code stop} is called.
+         */
+        void run();
+
+        /*!
+         * Waits for events then handles them, with the expired timers and the posted tasks.
+         * @param timeout The maximum waiting time, negative to wait until an event.
+         * @return The number of handled I/O events.
+         */
+        size_t run_once(std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
+        /*!
+         * Stops the loop after its current iteration, thread-safe.
+         */
+        void stop();
+
+        /*!
+         * Executes a task in the thread of the loop, thread-safe.
+         * @param task The task.
+         */
+        void post(std::function<void()> task);
+
+        /*!
+         * Calls a function after a delay.
+         * @param delay The delay.
+         * @param callback The function to call.
+         * @param repeat True if the function is called every delay until the timer is cancelled, else false.
+         * @return The identifier of the timer.
+         */
+        TimerId add_timer(std::chrono::milliseconds delay, std::function<void()> callback, bool repeat = false);
+
+        /*!
+         * Cancels a timer.
+         * @param timer The identifier of the timer.
+         * @return True if the timer was pending, else false.
+         */
+        bool cancel_timer(TimerId timer);
+
+        /*!
+         * Gets the block pool of the loop, which provides the blocks the sockets read into.
+         * @return The block pool.
+         */
+        BlockPool& get_block_pool();
+
+        /*!
+         * Gets the number of open sources.
+         * @return The number of sources.
+         */
+        [[nodiscard]] size_t get_source_count() const;
+    };
+
+    /*!
+     * TCPConnection
+     *
+     * Represents a non-blocking TCP connection: the received data is read into blocks of the pool of the loop and given to the data callback as it arrives,
+     * the written data which cannot be sent immediately is queued in a buffer chain and sent with scatter/gather writes when the socket is writable.
+     */
+    class LAMBDACOMMON_API TCPConnection : public EventSource
+    {
+        friend class TCPListener;
+
+    public:
+        typedef std::function<void(TCPConnection& connection, BufferChain& data)> DataCallback;
+        typedef std::function<void(TCPConnection& connection)> CloseCallback;
+        typedef std::function<void(std::shared_ptr<TCPConnection> connection, std::error_code error)> ConnectCallback;
+
+    private:
+        Address _peer_address;
+        DataCallback _on_data;
+        CloseCallback _on_close;
+        ConnectCallback _on_connect;
+        BufferChain _output;
+
+        TCPConnection(EventLoop& loop, int fd, Address peer_address);
+
+        void flush();
+
+        void read(u32 events);
+
+        void handle_events(u32 events) override;
+
+    public:
+        /*!
+         * Connects to an address.
+         * @param loop The event loop.
+         * @param address The IP address and port to connect to, a domain name must be resolved first.
+         * @param callback Called from the loop with the connection once connected, or with the error if the connection failed.
+         */
+        static void connect(EventLoop& loop, const Address& address, ConnectCallback callback);
+
+        /*!
+         * Sets the function called with the data received by each read.
+         * The chain is cleared after the call, the callback keeps bytes without copying them by copying or splitting the chain.
+         * @param callback The callback.
+         */
+        void set_on_data(DataCallback callback);
+
+        /*!
+         * Sets the function called once when the connection is closed, by either side or after an error.
+         * @param callback The callback.
+         */
+        void set_on_close(CloseCallback callback);
+
+        /*!
+         * Writes data, the data which cannot be sent immediately is copied into the output queue.
+         * @param data The data to write.
+         * @return True if the data is written or queued, false if the connection is closed.
+         */
+        bool write(std::string_view data);
+
+        /*!
+         * Writes several buffers with a single system call (scatter/gather), see {@code write}.
+         * @param parts The buffers to write.
+         * @return True if the data is written or queued, false if the connection is closed.
+         */
+        bool write(std::initializer_list<std::string_view> parts);
+
+        /*!
+         * Writes several buffers with a single system call (scatter/gather), see {@code write}.
+         * @param parts The buffers to write.
+         * @param count The number of buffers.
+         * @return True if the data is written or queued, false if the connection is closed.
+         */
+        bool write(const std::string_view* parts, size_t count);
+
+        /*!
+         * Writes the bytes of a chain, the data which cannot be sent immediately is queued without being copied.
+         * @param data The data to write.
+         * @return True if the data is written or queued, false if the connection is closed.
+         */
+        bool write(BufferChain data);
+
+        /*!
+         * Closes the connection, the queued data is discarded.
+         */
+        void close() override;
+
+        [[nodiscard]] const Address& get_peer_address() const;
+
+        /*!
+         * Gets the size of the data waiting in the output queue.
+         * @return The number of queued bytes.
+         */
+        [[nodiscard]] size_t get_queued_size() const;
+    };
+
+    /*!
+     * TCPListener
+     *
+     * Represents a TCP socket accepting connections.
+     */
+    class LAMBDACOMMON_API TCPListener : public EventSource
+    {
+    public:
+        typedef std::function<void(std::shared_ptr<TCPConnection> connection)> AcceptCallback;
+
+    private:
+        AcceptCallback _on_accept;
+
+        TCPListener(EventLoop& loop, int fd, AcceptCallback on_accept);
+
+        void handle_events(u32 events) override;
+
+    public:
+        /*!
+         * Listens for connections.
+         * @param loop The event loop.
+         * @param address The IP address and port to listen on, port 0 to pick a free port.
+         * @param on_accept Called from the loop with each accepted connection.
+         * @param backlog The maximum number of connections waiting to be accepted.
+         * @return The listener.
+         * @throws std::system_error If the socket cannot listen on the address.
+         */
+        static std::shared_ptr<TCPListener> listen(EventLoop& loop, const Address& address, AcceptCallback on_accept, int backlog = 1024);
+
+        /*!
+         * Gets the address the socket listens on.
+         * @return The local address.
+         */
+        [[nodiscard]] Address get_local_address() const;
+    };
+
+    /*!
+     * UDPSocket
+     *
+     * Represents a non-blocking UDP socket.
+     */
+    class LAMBDACOMMON_API UDPSocket : public EventSource
+    {
+    public:
+        typedef std::function<void(UDPSocket& socket, std::string_view data, const Address& sender)> DatagramCallback;
+
+    private:
+        DatagramCallback _on_datagram;
+
+        UDPSocket(EventLoop& loop, int fd, DatagramCallback on_datagram);
+
+        void handle_events(u32 events) override;
+
+    public:
+        /*!
+         * Binds a socket.
+         * @param loop The event loop.
+         * @param address The IP address and port to bind, port 0 to pick a free port.
+         * @param on_datagram Called from the loop with each received datagram.
+         * @return The socket.
+         * @throws std::system_error If the socket cannot be bound to the address.
+         */
+        static std::shared_ptr<UDPSocket> bind(EventLoop& loop, const Address& address, DatagramCallback on_datagram);
+
+        /*!
+         * Sends a datagram.
+         * @param address The IP address and port of the receiver.
+         * @param data The content of the datagram.
+         * @return True if the datagram is sent, false if the send buffer is full or on error.
+         */
+        bool send_to(const Address& address, std::string_view data);
+
+        /*!
+         * Gets the address the socket is bound to.
+         * @return The local address.
+         */
+        [[nodiscard]] Address get_local_address() const;
+    };
+}
+
+#endif //__linux__
+
+#endif //LAMBDACOMMON_EVENT_LOOP_H
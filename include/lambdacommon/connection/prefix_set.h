@@ -0,0 +1,151 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef LAMBDACOMMON_PREFIX_SET_H
+#define LAMBDACOMMON_PREFIX_SET_H
+
+#include "address.h"
+#include <memory>
+#include <utility>
+
+#ifdef LAMBDA_WINDOWS
+#  pragma warning(push)
+#  pragma warning(disable:4251)
+#endif
+
+namespace lambdacommon
+{
+    /*!
+     * IPPrefixSet
+     *
+     * Represents an immutable set of IPv4 and IPv6 networks, with longest-prefix match lookups.
+     * The networks are stored in a poptrie: a multibit trie of 64-way nodes whose children and leaves are located with the population count of bitmaps,
+     * and where the consecutive identical leaves of a node are stored once. A lookup reads at most 6 nodes for IPv4 and 22 nodes for IPv6.
+     */
+    class LAMBDACOMMON_API IPPrefixSet
+    {
+    private:
+        struct Node
+        {
+            /*!
+             * The bitmap of the slots which have a child node.
+             */
+            u64 children;
+            /*!
+             * The bitmap of the slots which start a run of identical leaves.
+             */
+            u64 leaves;
+            u32 first_leaf;
+            u32 first_child;
+        };
+
+        std::vector<IPNetwork> _networks;
+        std::vector<Node> _nodes;
+        /*!
+         * The leaves, the index of the matching network plus one, or zero if no network matches.
+         */
+        std::vector<u32> _leaves;
+
+    public:
+        /*!
+         * The number of bits of the address read by each level of the trie.
+         */
+        static constexpr u32 STRIDE = 6;
+
+        /*!
+         * Creates an empty set.
+         */
+        IPPrefixSet();
+
+        /*!
+         * Creates a set of networks, for duplicate networks the last one is matched.
+         * @param networks The networks.
+         */
+        explicit IPPrefixSet(std::vector<IPNetwork> networks);
+
+        /*!
+         * Creates a set of networks from addresses and prefix lengths.
+         * @param prefixes The addresses and the prefix lengths.
+         * @throws std::invalid_argument If an address is not an IP address or if a prefix is longer than its address.
+         */
+        explicit IPPrefixSet(const std::vector<std::pair<Address, u8>>& prefixes);
+
+        /*!
+         * Finds the longest network containing the address.
+         * @param address The address.
+         * @return The index of the network in the list given to the constructor, or an empty optional if no network contains the address.
+         */
+        [[nodiscard]] std::optional<size_t> longest_match(const IPAddress& address) const;
+
+        /*!
+         * Checks whether a network of the set contains the address.
+         * @param address The address.
+         * @return True if the address is in the set, else false.
+         */
+        [[nodiscard]] bool contains(const IPAddress& address) const;
+
+        /*!
+         * Checks whether a network of the set contains the host of the address, a domain name is never in the set.
+         * @param address The address.
+         * @return True if the address is in the set, else false.
+         */
+        [[nodiscard]] bool contains(const Address& address) const;
+
+        [[nodiscard]] const std::vector<IPNetwork>& get_networks() const;
+
+        /*!
+         * Gets the number of networks of the set.
+         * @return The number of networks.
+         */
+        [[nodiscard]] size_t size() const;
+
+        /*!
+         * Gets the number of bytes used by the trie.
+         * @return The memory usage of the trie.
+         */
+        [[nodiscard]] size_t get_memory_usage() const;
+    };
+
+    /*!
+     * AtomicIPPrefixSet
+     *
+     * Holds a prefix set which can be replaced while other threads look addresses up:
+     * a new set is built off-thread then swapped in, the lookups in progress keep the previous set alive.
+     */
+    class LAMBDACOMMON_API AtomicIPPrefixSet
+    {
+    private:
+        std::shared_ptr<const IPPrefixSet> _set;
+
+    public:
+        explicit AtomicIPPrefixSet(IPPrefixSet set = IPPrefixSet{});
+
+        /*!
+         * Gets the current set, which stays valid while the returned pointer is held.
+         * @return The current set.
+         */
+        [[nodiscard]] std::shared_ptr<const IPPrefixSet> load() const;
+
+        /*!
+         * Replaces the current set.
+         * @param set The new set.
+         */
+        void store(IPPrefixSet set);
+
+        [[nodiscard]] bool contains(const IPAddress& address) const;
+
+        [[nodiscard]] bool contains(const Address& address) const;
+    };
+}
+
+#ifdef LAMBDA_WINDOWS
+#  pragma warning(pop)
+#endif
+
+#endif //LAMBDACOMMON_PREFIX_SET_H
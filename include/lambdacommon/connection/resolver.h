@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef LAMBDACOMMON_RESOLVER_H
+#define LAMBDACOMMON_RESOLVER_H
+
+#include "address.h"
+#include "../thread_pool.h"
+#include <chrono>
+#include <unordered_map>
+
+#ifdef LAMBDA_WINDOWS
+#  pragma warning(push)
+#  pragma warning(disable:4251)
+#endif
+
+namespace lambdacommon
+{
+    /*!
+     * Looks the addresses of a host name up, returns no address if the host cannot be resolved.
+     */
+    typedef std::function<std::vector<IPAddress>(const std::string& host)> HostLookup;
+
+    /*!
+     * HostsFile
+     *
+     * Represents a list of host names and their addresses, in the format of /etc/hosts: an address followed by its host names on each line,
+     * with comments starting with '#'.
+     */
+    class LAMBDACOMMON_API HostsFile
+    {
+    private:
+        std::unordered_map<std::string, std::vector<IPAddress>> _hosts;
+
+        HostsFile() = default;
+
+    public:
+        /*!
+         * Parses a hosts file, the lines with an invalid address are ignored.
+         * @param content The content of the file.
+         * @return The hosts file.
+         */
+        static HostsFile parse(std::string_view content);
+
+        /*!
+         * Loads a hosts file, see {@code parse}.
+         * @param path The path of the file.
+         * @return The hosts file.
+         * @throws std::runtime_error If the file cannot be read.
+         */
+        static HostsFile load(const fs::path& path);
+
+        /*!
+         * Gets the addresses of a host name, case-insensitively.
+         * @param host The host name.
+         * @return The addresses of the host in the order of the file, or no address if the host is unknown.
+         */
+        [[nodiscard]] std::vector<IPAddress> lookup(const std::string& host) const;
+
+        /*!
+         * Gets the number of host names.
+         * @return The number of host names.
+         */
+        [[nodiscard]] size_t size() const;
+    };
+
+    /*!
+     * Looks the addresses of a host name up with the system resolver (getaddrinfo), blocking until the answer or the timeout of the system.
+     * @param host The host name.
+     * @return The addresses of the host, or no address if the host cannot be resolved.
+     */
+    extern std::vector<IPAddress> LAMBDACOMMON_API lookup_host(const std::string& host);
+
+    /*!
+     * Represents the statistics of a DNS resolver.
+     */
+    struct DNSResolverStats
+    {
+        /*!
+         * The number of lookups done by the lookup function.
+         */
+        u64 lookups;
+        u64 hits;
+        /*!
+         * The number of resolutions answered by a cached failure.
+         */
+        u64 negative_hits;
+        /*!
+         * The number of resolutions which waited for the pending lookup of the same host.
+         */
+        u64 coalesced;
+        size_t entries;
+    };
+
+    /*!
+     * DNSResolver
+     *
+     * Resolves host names asynchronously on a thread pool, so the blocking lookups don't block the threads handling requests.
+     * The resolutions of a host waiting for a lookup share it, the results are cached for a time to live and the failures for a shorter one.
+     * The host names are case-insensitive, IP addresses are resolved to themselves without lookup.
+     *
+     * Resolving a host only blocks if 1024 other hosts are already waiting for a lookup.
+     * The resolver is thread-safe, its destructor waits for the pending lookups.
+     */
+    class LAMBDACOMMON_API DNSResolver
+    {
+    public:
+        typedef std::function<void(const std::vector<IPAddress>& addresses)> Callback;
+
+    private:
+        struct CacheEntry
+        {
+            std::vector<IPAddress> addresses;
+            std::chrono::steady_clock::time_point expiration;
+        };
+
+        HostLookup _lookup;
+        std::chrono::milliseconds _ttl;
+        std::chrono::milliseconds _negative_ttl;
+        size_t _cache_capacity;
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, CacheEntry> _cache;
+        std::unordered_map<std::string, std::vector<Callback>> _pending;
+        DNSResolverStats _stats{};
+        // Destroyed first so the pending lookups complete while the resolver is still valid.
+        ThreadPool _pool;
+
+        /*!
+         * Looks up a pending host then completes its resolution.
+         * @param host The lowercase host name.
+         */
+        void lookup(const std::string& host);
+
+        void complete(const std::string& host, const std::vector<IPAddress>& addresses);
+
+    public:
+        /*!
+         * Creates a resolver.
+         * @param threads The maximum number of concurrent lookups.
+         * @param ttl The time to live of the resolved addresses.
+         * @param negative_ttl The time to live of the failed resolutions.
+         * @param cache_capacity The maximum number of cached hosts, the expired hosts then every host are forgotten when it is reached.
+         * @param lookup The lookup function, the system resolver by default.
+         */
+        explicit DNSResolver(size_t threads = 4, std::chrono::milliseconds ttl = std::chrono::seconds(60),
+                             std::chrono::milliseconds negative_ttl = std::chrono::seconds(5), size_t cache_capacity = 4096, HostLookup lookup = lookup_host);
+
+        /*!
+         * Resolves a host name asynchronously.
+         * @param host The host name.
+         * @param callback Called with the addresses of the host, or no address if the host cannot be resolved.
+         *                 The callback is called from a resolver thread, or from the calling thread if the result is known.
+         *                 A host resolved from a resolver thread, by a callback for example, is looked up by this thread instead of being queued.
+         */
+        void resolve_async(const std::string& host, Callback callback);
+
+        /*!
+         * Resolves a host name asynchronously.
+         * The future must not be waited for from a resolver thread, its lookup may be queued behind the waiting callback.
+         * @param host The host name.
+         * @return The future of the addresses of the host, or of no address if the host cannot be resolved.
+         */
+        std::future<std::vector<IPAddress>> resolve_async(const std::string& host);
+
+        /*!
+         * Resolves a host name, blocking until its addresses are known.
+         * @param host The host name.
+         * @return The addresses of the host, or no address if the host cannot be resolved.
+         * @throws std::logic_error If called from a resolver thread, a callback for example.
+         */
+        std::vector<IPAddress> resolve(const std::string& host);
+
+        [[nodiscard]] DNSResolverStats get_stats() const;
+
+        /*!
+         * Forgets the cached results, the pending lookups are not affected.
+         */
+        void clear_cache();
+    };
+}
+
+#ifdef LAMBDA_WINDOWS
+#  pragma warning(pop)
+#endif
+
+#endif //LAMBDACOMMON_RESOLVER_H
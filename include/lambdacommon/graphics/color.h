@@ -11,6 +11,7 @@
 #define LAMBDACOMMON_COLOR_H
 
 #include "../types.h"
+#include "../hash.h"
 #include <utility>
 
 namespace lambdacommon
@@ -242,7 +243,7 @@ namespace lambdacommon
     }
 }
 
-// Structured bindings for lambdacommon::Color.
+// Structured bindings and hash for lambdacommon::Color.
 namespace std
 {
     template<>
@@ -255,6 +256,17 @@ namespace std
     {
         using type = decltype(std::declval<lambdacommon::Color>().get<N>());
     };
+
+    template<>
+    struct hash<lambdacommon::Color>
+    {
+        size_t operator()(const lambdacommon::Color& color) const noexcept {
+            // Colors are compared with their 8-bit components, so they are hashed the same way.
+            lambdacommon::u64 rgba = (static_cast<lambdacommon::u64>(color.red_as_int()) << 24) | (static_cast<lambdacommon::u64>(color.green_as_int()) << 16)
+                                     | (static_cast<lambdacommon::u64>(color.blue_as_int()) << 8) | color.alpha_as_int();
+            return static_cast<size_t>(lambdacommon::hashing::hash_int(rgba));
+        }
+    };
 }
 
 #endif //LAMBDACOMMON_COLOR_H
@@ -0,0 +1,146 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef LAMBDACOMMON_HASH_H
+#define LAMBDACOMMON_HASH_H
+
+#include "types.h"
+#include <cstring>
+#include <string_view>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#  include <intrin.h>
+#  pragma intrinsic(_umul128)
+#endif
+
+/*
+ * Fast non-cryptographic hashing of byte strings, used by the std::hash specializations of the λcommon value types.
+ *
+ * The algorithm is wyhash (final version 4, by Wang Yi, released in the public domain): short keys are hashed with a single 128-bit multiplication,
+ * long keys 48 bytes per iteration. The hashes are stable during the execution of a program but may differ between platforms and versions.
+ */
+namespace lambdacommon::hashing
+{
+    namespace detail
+    {
+        constexpr u64 SECRET[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+        /*
+         * Multiplies two 64-bit integers into a 128-bit result, the low half is written into a and the high half into b.
+         */
+        inline void multiply(u64& a, u64& b) {
+#if defined(__SIZEOF_INT128__)
+            __uint128_t result = static_cast<__uint128_t>(a) * b;
+            a = static_cast<u64>(result);
+            b = static_cast<u64>(result >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            a = _umul128(a, b, &b);
+#else
+            u64 ha = a >> 32, hb = b >> 32, la = static_cast<u32>(a), lb = static_cast<u32>(b);
+            u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+            u64 carry = t < rl;
+            u64 low = t + (rm1 << 32);
+            carry += low < t;
+            b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+            a = low;
+#endif
+        }
+
+        inline u64 mix(u64 a, u64 b) {
+            multiply(a, b);
+            return a ^ b;
+        }
+
+        inline u64 read_64(const u8* p) {
+            u64 value;
+            std::memcpy(&value, p, 8);
+            return value;
+        }
+
+        inline u64 read_32(const u8* p) {
+            u32 value;
+            std::memcpy(&value, p, 4);
+            return value;
+        }
+
+        inline u64 read_small(const u8* p, size_t length) {
+            return (static_cast<u64>(p[0]) << 16) | (static_cast<u64>(p[length >> 1]) << 8) | p[length - 1];
+        }
+    }
+
+    /*!
+     * Hashes the specified bytes.
+     * @param data The bytes to hash.
+     * @param length The number of bytes.
+     * @param seed The seed, allows to chain hashes.
+     * @return The 64-bit hash.
+     */
+    inline u64 hash_bytes(const void* data, size_t length, u64 seed = 0) {
+        using namespace detail;
+        const auto* p = static_cast<const u8*>(data);
+        seed ^= mix(seed ^ SECRET[0], SECRET[1]);
+        u64 a, b;
+        if (length <= 16) {
+            if (length >= 4) {
+                a = (read_32(p) << 32) | read_32(p + ((length >> 3) << 2));
+                b = (read_32(p + length - 4) << 32) | read_32(p + length - 4 - ((length >> 3) << 2));
+            } else if (length > 0) {
+                a = read_small(p, length);
+                b = 0;
+            } else
+                a = b = 0;
+        } else {
+            size_t i = length;
+            if (i > 48) {
+                u64 seed1 = seed, seed2 = seed;
+                do {
+                    seed = mix(read_64(p) ^ SECRET[1], read_64(p + 8) ^ seed);
+                    seed1 = mix(read_64(p + 16) ^ SECRET[2], read_64(p + 24) ^ seed1);
+                    seed2 = mix(read_64(p + 32) ^ SECRET[3], read_64(p + 40) ^ seed2);
+                    p += 48;
+                    i -= 48;
+                } while (i > 48);
+                seed ^= seed1 ^ seed2;
+            }
+            while (i > 16) {
+                seed = mix(read_64(p) ^ SECRET[1], read_64(p + 8) ^ seed);
+                i -= 16;
+                p += 16;
+            }
+            a = read_64(p + i - 16);
+            b = read_64(p + i - 8);
+        }
+        a ^= SECRET[1];
+        b ^= seed;
+        multiply(a, b);
+        return mix(a ^ SECRET[0] ^ length, b ^ SECRET[1]);
+    }
+
+    /*!
+     * Hashes the specified string.
+     * @param str The string to hash.
+     * @param seed The seed, allows to chain hashes.
+     * @return The 64-bit hash.
+     */
+    inline u64 hash_string(std::string_view str, u64 seed = 0) {
+        return hash_bytes(str.data(), str.size(), seed);
+    }
+
+    /*!
+     * Hashes a 64-bit integer.
+     * @param value The integer to hash.
+     * @param seed The seed, allows to chain hashes.
+     * @return The 64-bit hash.
+     */
+    inline u64 hash_int(u64 value, u64 seed = 0) {
+        return detail::mix(value ^ detail::SECRET[0], seed ^ detail::SECRET[1]);
+    }
+}
+
+#endif //LAMBDACOMMON_HASH_H
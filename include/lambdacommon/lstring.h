@@ -11,13 +11,178 @@
 #define LAMBDACOMMON_STRING_H
 
 #include "object.h"
+#include "types.h"
+#include <array>
 #include <vector>
+#include <system_error>
 #include <optional>
+#include <string_view>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#ifdef LAMBDA_WINDOWS
+#  pragma warning(push)
+#  pragma warning(disable:4251)
+#endif
 
 namespace lambdacommon::lstring
 {
+    namespace detail
+    {
+        /*
+         * Finds the next delimiter from the specified position, returns its position and its length.
+         */
+        inline std::pair<size_t, size_t> find_delimiter(std::string_view s, size_t pos, char delim) {
+            return {s.find(delim, pos), 1};
+        }
+
+        inline std::pair<size_t, size_t> find_delimiter(std::string_view s, size_t pos, std::string_view delim) {
+            // An empty delimiter never matches, else it would split forever at the same place.
+            if (delim.empty())
+                return {std::string_view::npos, 0};
+            return {s.find(delim, pos), delim.size()};
+        }
+
+        template<typename Predicate>
+        inline std::pair<size_t, size_t> find_delimiter(std::string_view s, size_t pos, const Predicate& predicate) {
+            auto it = std::find_if(s.begin() + pos, s.end(), predicate);
+            return {it == s.end() ? std::string_view::npos : static_cast<size_t>(it - s.begin()), 1};
+        }
+    }
+
+    /*!
+     * Lazy range over the tokens of a string separated by a delimiter.
+     * No copy of the source is made, the tokens are views into it so the source must outlive the range.
+     *
+     * The delimiter can be a single char, a string (multi-char delimiter) or a predicate called on each char.
+     * A string with N delimiters yields N + 1 tokens (empty tokens included), an empty string yields no token.
+     *
+     * @tparam Delimiter The type of the delimiter.
+     */
+    template<typename Delimiter>
+    class split_view
+    {
+    private:
+        std::string_view _source;
+        Delimiter _delimiter;
+        size_t _max_split;
+
+    public:
+        class iterator
+        {
+        private:
+            const split_view* _view = nullptr;
+            size_t _start = std::string_view::npos;
+            size_t _end = std::string_view::npos;
+            size_t _next = std::string_view::npos;
+            size_t _splits = 0;
+
+            void find_token() {
+                if (_splits < _view->_max_split) {
+                    auto[pos, length] = detail::find_delimiter(_view->_source, _start, _view->_delimiter);
+                    if (pos != std::string_view::npos) {
+                        _end = pos;
+                        _next = pos + length;
+                        return;
+                    }
+                }
+                _end = _view->_source.size();
+                _next = std::string_view::npos;
+            }
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string_view*;
+            using reference = std::string_view;
+
+            iterator() = default;
+
+            explicit iterator(const split_view* view) : _view(view), _start(0) {
+                if (view->_source.empty())
+                    _start = std::string_view::npos;
+                else
+                    find_token();
+            }
+
+            reference operator*() const {
+                return _view->_source.substr(_start, _end - _start);
+            }
+
+            iterator& operator++() {
+                if (_next == std::string_view::npos)
+                    _start = std::string_view::npos;
+                else {
+                    _start = _next;
+                    _splits++;
+                    find_token();
+                }
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator old = *this;
+                ++*this;
+                return old;
+            }
+
+            bool operator==(const iterator& other) const {
+                return _start == other._start;
+            }
+
+            bool operator!=(const iterator& other) const {
+                return !(*this == other);
+            }
+        };
+
+        /*!
+         * Creates a new split view.
+         * @param source The string to split.
+         * @param delimiter The delimiter.
+         * @param max_split The maximum number of splits, the last token contains the rest of the string once reached.
+         */
+        split_view(std::string_view source, Delimiter delimiter, size_t max_split = std::string_view::npos)
+                : _source(source), _delimiter(std::move(delimiter)), _max_split(max_split) {}
+
+        iterator begin() const {
+            return iterator(this);
+        }
+
+        iterator end() const {
+            return iterator();
+        }
+    };
+
+    split_view(std::string_view, char, size_t = std::string_view::npos) -> split_view<char>;
+
+    split_view(std::string_view, std::string_view, size_t = std::string_view::npos) -> split_view<std::string_view>;
+
+    split_view(std::string_view, const char*, size_t = std::string_view::npos) -> split_view<std::string_view>;
+
+    split_view(std::string_view, const std::string&, size_t = std::string_view::npos) -> split_view<std::string_view>;
+
+    template<typename Predicate>
+    split_view(std::string_view, Predicate, size_t = std::string_view::npos) -> split_view<Predicate>;
+
+    /*!
+     * Splits a string with a delimiter and writes each token into the output iterator.
+     * Behaves like reading the string with std::getline: a trailing delimiter doesn't produce an empty token.
+     * @param s String to split.
+     * @param delim Delimiter.
+     * @param result The output iterator.
+     */
     template<typename Out>
-    extern void LAMBDACOMMON_API split(const std::string& s, char delim, Out result);
+    void split(std::string_view s, char delim, Out result) {
+        split_view view{s, delim};
+        for (auto it = view.begin(); it != view.end();) {
+            auto token = *it;
+            if (++it == view.end() && token.empty())
+                break;
+            *(result++) = std::string(token);
+        }
+    }
 
     /*!
      * Splits a string into a vector with a delimiter.
@@ -25,7 +190,7 @@ namespace lambdacommon::lstring
      * @param delim Delimiter.
      * @return The split string as a vector.
      */
-    extern std::vector<std::string> LAMBDACOMMON_API split(const std::string& s, char delim);
+    extern std::vector<std::string> LAMBDACOMMON_API split(std::string_view s, char delim);
 
     /*!
      * Checks if two chars are equal with case insensitive.
@@ -41,33 +206,153 @@ namespace lambdacommon::lstring
      * @param b One of two strings.
      * @return True if they are equal else false.
      */
-    extern bool LAMBDACOMMON_API equals(const std::string& a, const std::string& b);
+    extern bool LAMBDACOMMON_API equals(std::string_view a, std::string_view b);
 
     /*!
      * Checks if two strings are equal with case insensitive.
+     * Only ASCII letters are case folded, the comparison is vectorized when the CPU allows it.
      * @param a One of two strings.
      * @param b One of two strings.
      * @return True if they are equal with case insensitive else false.
      */
-    extern bool LAMBDACOMMON_API equals_ignore_case(const std::string& a, const std::string& b);
+    extern bool LAMBDACOMMON_API equals_ignore_case(std::string_view a, std::string_view b);
 
     /*!
      * Transforms a string to a full lower case string.
      * @param from The string to transform.
      * @return The new string.
      */
-    extern std::string LAMBDACOMMON_API to_lower_case(const std::string& from);
+    extern std::string LAMBDACOMMON_API to_lower_case(std::string_view from);
 
     /*!
      * Transforms a string to a full upper case string.
      * @param from The string to transform.
      * @return The new string.
      */
-    extern std::string LAMBDACOMMON_API to_upper_case(const std::string& from);
+    extern std::string LAMBDACOMMON_API to_upper_case(std::string_view from);
+
+    /*!
+     * Transforms the content of a buffer to lower case, without any allocation.
+     * @param buffer The buffer to transform.
+     * @param size The size of the buffer.
+     */
+    extern void LAMBDACOMMON_API to_lower_case_in_place(char* buffer, size_t size);
+
+    /*!
+     * Transforms a string to a full lower case string, without any allocation.
+     * @param str The string to transform.
+     */
+    extern void LAMBDACOMMON_API to_lower_case_in_place(std::string& str);
+
+    /*!
+     * Transforms the content of a buffer to upper case, without any allocation.
+     * @param buffer The buffer to transform.
+     * @param size The size of the buffer.
+     */
+    extern void LAMBDACOMMON_API to_upper_case_in_place(char* buffer, size_t size);
+
+    /*!
+     * Transforms a string to a full upper case string, without any allocation.
+     * @param str The string to transform.
+     */
+    extern void LAMBDACOMMON_API to_upper_case_in_place(std::string& str);
 
+    /*!
+     * Replaces all the occurrences of a char by another char.
+     * @param subject The string in which the chars are replaced.
+     * @param from The char to replace.
+     * @param to The replacement char.
+     * @return The string with the replaced chars.
+     */
     extern std::string LAMBDACOMMON_API replace_all(std::string subject, const char& from, const char& to);
 
-    extern std::string LAMBDACOMMON_API replace_all(std::string subject, const std::string& from, const std::string& to);
+    /*!
+     * Replaces all the occurrences of a string by another string.
+     * The result is built in one pass, in place when the replacement isn't longer than the replaced string.
+     * @param subject The string in which the occurrences are replaced.
+     * @param from The string to replace, nothing is replaced if empty.
+     * @param to The replacement string.
+     * @return The string with the replaced occurrences.
+     */
+    extern std::string LAMBDACOMMON_API replace_all(std::string subject, std::string_view from, std::string_view to);
+
+    /*!
+     * Replacer
+     *
+     * Replaces several patterns at once in a single scan of the subject.
+     * The table is compiled once in a trie over the bytes used by the patterns, so a replacer should be reused across calls.
+     *
+     * At each position the longest matching pattern is replaced (the first one of the table if there are duplicates),
+     * and the scan resumes after it: the replacements are never scanned again.
+     * The output size is computed before writing so the result is allocated exactly once.
+     */
+    class LAMBDACOMMON_API Replacer
+    {
+    private:
+        std::vector<std::string> _from;
+        std::vector<std::string> _to;
+        // Byte to class index in the trie, 0 if the byte isn't used by any pattern.
+        std::array<u16, 256> _classes{};
+        size_t _class_count = 1;
+        // Flat trie: transitions of the node N are at [N * _class_count, (N + 1) * _class_count), 0 means no transition.
+        std::vector<u32> _transitions;
+        // Index + 1 of the rule matching at the node, 0 if none.
+        std::vector<u32> _matches;
+        // Whether a byte can start a pattern.
+        std::array<bool, 256> _first_bytes{};
+        // Set when the only first byte of the patterns is this one, the scan can then use memchr.
+        int _single_first_byte = -1;
+        bool _single_bytes = true;
+
+        void compile();
+
+        template<typename Callback>
+        void scan(std::string_view subject, Callback callback) const;
+
+    public:
+        /*!
+         * Creates a new replacer.
+         * @param table The (from, to) pairs, the from strings can't be empty.
+         */
+        Replacer(std::initializer_list<std::pair<std::string_view, std::string_view>> table);
+
+        /*!
+         * Creates a new replacer.
+         * @param table The (from, to) pairs, the from strings can't be empty.
+         */
+        explicit Replacer(const std::vector<std::pair<std::string, std::string>>& table);
+
+        /*!
+         * Computes the size of the string returned by {@code replace_all} without building it.
+         * @param subject The string in which the patterns would be replaced.
+         * @return The size of the result.
+         */
+        [[nodiscard]] size_t get_result_size(std::string_view subject) const;
+
+        /*!
+         * Replaces all the patterns of the table in the subject.
+         * @param subject The string in which the patterns are replaced.
+         * @return The string with the replaced patterns.
+         */
+        [[nodiscard]] std::string replace_all(std::string_view subject) const;
+
+        /*!
+         * Replaces all the patterns of the table in the subject and appends the result to the output.
+         * @param subject The string in which the patterns are replaced.
+         * @param output The string where the result is appended, it grows at most once.
+         * @return The number of replacements.
+         */
+        size_t replace_all(std::string_view subject, std::string& output) const;
+    };
+
+    /*!
+     * Replaces all the patterns of the table in the subject in one scan.
+     * Prefer a {@code Replacer} if the same table is used several times.
+     * @param subject The string in which the patterns are replaced.
+     * @param table The (from, to) pairs.
+     * @return The string with the replaced patterns.
+     */
+    extern std::string LAMBDACOMMON_API replace_all(std::string_view subject, std::initializer_list<std::pair<std::string_view, std::string_view>> table);
 
     /*!
      * Transforms a boolean value into a string value.
@@ -96,7 +381,7 @@ namespace lambdacommon::lstring
      * @param prefix The prefix.
      * @return True if the string started with the specified prefix, else false.
      */
-    extern bool LAMBDACOMMON_API starts_with(const std::string& str, const std::string& prefix);
+    extern bool LAMBDACOMMON_API starts_with(std::string_view str, std::string_view prefix);
 
     /*!
      * Checks whether the specified string does start with the specified prefix (case insensitive).
@@ -104,7 +389,7 @@ namespace lambdacommon::lstring
      * @param prefix The prefix.
      * @return True if the string started with the specified prefix, else false.
      */
-    extern bool LAMBDACOMMON_API starts_with_ignore_case(const std::string& str, const std::string& prefix);
+    extern bool LAMBDACOMMON_API starts_with_ignore_case(std::string_view str, std::string_view prefix);
 
     /*!
      * Checks whether the specified string does end with the specified suffix.
@@ -112,7 +397,7 @@ namespace lambdacommon::lstring
      * @param suffix The suffix.
      * @return True if the string ended with the specified suffix, else false.
      */
-    extern bool LAMBDACOMMON_API ends_with(const std::string& str, const std::string& suffix);
+    extern bool LAMBDACOMMON_API ends_with(std::string_view str, std::string_view suffix);
 
     /*!
      * Checks whether the specified string does end with the specified suffix (case insensitive).
@@ -120,9 +405,9 @@ namespace lambdacommon::lstring
      * @param suffix The suffix.
      * @return True if the string ended with the specified suffix, else false.
      */
-    extern bool LAMBDACOMMON_API ends_with_ignore_case(const std::string& str, const std::string& suffix);
+    extern bool LAMBDACOMMON_API ends_with_ignore_case(std::string_view str, std::string_view suffix);
 
-    extern const std::string LAMBDACOMMON_API merge_path(const std::string& parent, const std::string& child);
+    extern const std::string LAMBDACOMMON_API merge_path(std::string_view parent, std::string_view child);
 
     /*!
      * Parses int from a string.
@@ -130,7 +415,7 @@ namespace lambdacommon::lstring
      * @param base The base of the integer.
      * @return The parsed integer, may be 0 if parse failed.
      */
-    extern std::optional<int> LAMBDACOMMON_API parse_int(const std::string& integer, int base = 10);
+    extern std::optional<int> LAMBDACOMMON_API parse_int(std::string_view integer, int base = 10);
 
     /*!
      * Parses long from a string.
@@ -138,7 +423,188 @@ namespace lambdacommon::lstring
      * @param base The base of the long.
      * @return The parsed long, may be 0 if parse failed.
      */
-    extern std::optional<long> LAMBDACOMMON_API parse_long(const std::string& long_number, int base = 10);
+    extern std::optional<long> LAMBDACOMMON_API parse_long(std::string_view long_number, int base = 10);
+
+    /*!
+     * Represents how the number parsing functions handle whitespaces and prefixes.
+     */
+    enum ParseMode
+    {
+        /*!
+         * The whole string must be the number: no whitespace, no '+' sign and no base prefix.
+         */
+        PARSE_STRICT,
+        /*!
+         * Leading and trailing whitespaces are skipped, a '+' sign and the "0x" prefix (in base 16) are accepted.
+         */
+        PARSE_LENIENT
+    };
+
+    /*
+     * Number parsing.
+     *
+     * Those functions never throw nor allocate and don't depend on the current locale.
+     * The error code is std::errc::invalid_argument if the string isn't a number in the requested base and mode,
+     * and std::errc::result_out_of_range if the number doesn't fit in the requested type, the value is left untouched on error.
+     */
+
+    extern std::errc LAMBDACOMMON_API parse(std::string_view str, i8& value, int base = 10, ParseMode mode = PARSE_STRICT);
+
+    extern std::errc LAMBDACOMMON_API parse(std::string_view str, i16& value, int base = 10, ParseMode mode = PARSE_STRICT);
+
+    extern std::errc LAMBDACOMMON_API parse(std::string_view str, i32& value, int base = 10, ParseMode mode = PARSE_STRICT);
+
+    extern std::errc LAMBDACOMMON_API parse(std::string_view str, i64& value, int base = 10, ParseMode mode = PARSE_STRICT);
+
+    extern std::errc LAMBDACOMMON_API parse(std::string_view str, u8& value, int base = 10, ParseMode mode = PARSE_STRICT);
+
+    extern std::errc LAMBDACOMMON_API parse(std::string_view str, u16& value, int base = 10, ParseMode mode = PARSE_STRICT);
+
+    extern std::errc LAMBDACOMMON_API parse(std::string_view str, u32& value, int base = 10, ParseMode mode = PARSE_STRICT);
+
+    extern std::errc LAMBDACOMMON_API parse(std::string_view str, u64& value, int base = 10, ParseMode mode = PARSE_STRICT);
+
+    extern std::errc LAMBDACOMMON_API parse(std::string_view str, f32& value, ParseMode mode = PARSE_STRICT);
+
+    extern std::errc LAMBDACOMMON_API parse(std::string_view str, f64& value, ParseMode mode = PARSE_STRICT);
+
+    /*!
+     * Parses a 8-bit signed integer from a string.
+     * @param str The string to parse.
+     * @param base The base of the number.
+     * @param mode The parse mode.
+     * @return The parsed number if the string is valid, else an empty optional.
+     */
+    inline std::optional<i8> parse_i8(std::string_view str, int base = 10, ParseMode mode = PARSE_STRICT) {
+        i8 value;
+        if (parse(str, value, base, mode) != std::errc())
+            return std::nullopt;
+        return value;
+    }
+
+    /*!
+     * Parses a 16-bit signed integer from a string.
+     * @param str The string to parse.
+     * @param base The base of the number.
+     * @param mode The parse mode.
+     * @return The parsed number if the string is valid, else an empty optional.
+     */
+    inline std::optional<i16> parse_i16(std::string_view str, int base = 10, ParseMode mode = PARSE_STRICT) {
+        i16 value;
+        if (parse(str, value, base, mode) != std::errc())
+            return std::nullopt;
+        return value;
+    }
+
+    /*!
+     * Parses a 32-bit signed integer from a string.
+     * @param str The string to parse.
+     * @param base The base of the number.
+     * @param mode The parse mode.
+     * @return The parsed number if the string is valid, else an empty optional.
+     */
+    inline std::optional<i32> parse_i32(std::string_view str, int base = 10, ParseMode mode = PARSE_STRICT) {
+        i32 value;
+        if (parse(str, value, base, mode) != std::errc())
+            return std::nullopt;
+        return value;
+    }
+
+    /*!
+     * Parses a 64-bit signed integer from a string.
+     * @param str The string to parse.
+     * @param base The base of the number.
+     * @param mode The parse mode.
+     * @return The parsed number if the string is valid, else an empty optional.
+     */
+    inline std::optional<i64> parse_i64(std::string_view str, int base = 10, ParseMode mode = PARSE_STRICT) {
+        i64 value;
+        if (parse(str, value, base, mode) != std::errc())
+            return std::nullopt;
+        return value;
+    }
+
+    /*!
+     * Parses a 8-bit unsigned integer from a string.
+     * @param str The string to parse.
+     * @param base The base of the number.
+     * @param mode The parse mode.
+     * @return The parsed number if the string is valid, else an empty optional.
+     */
+    inline std::optional<u8> parse_u8(std::string_view str, int base = 10, ParseMode mode = PARSE_STRICT) {
+        u8 value;
+        if (parse(str, value, base, mode) != std::errc())
+            return std::nullopt;
+        return value;
+    }
+
+    /*!
+     * Parses a 16-bit unsigned integer from a string.
+     * @param str The string to parse.
+     * @param base The base of the number.
+     * @param mode The parse mode.
+     * @return The parsed number if the string is valid, else an empty optional.
+     */
+    inline std::optional<u16> parse_u16(std::string_view str, int base = 10, ParseMode mode = PARSE_STRICT) {
+        u16 value;
+        if (parse(str, value, base, mode) != std::errc())
+            return std::nullopt;
+        return value;
+    }
+
+    /*!
+     * Parses a 32-bit unsigned integer from a string.
+     * @param str The string to parse.
+     * @param base The base of the number.
+     * @param mode The parse mode.
+     * @return The parsed number if the string is valid, else an empty optional.
+     */
+    inline std::optional<u32> parse_u32(std::string_view str, int base = 10, ParseMode mode = PARSE_STRICT) {
+        u32 value;
+        if (parse(str, value, base, mode) != std::errc())
+            return std::nullopt;
+        return value;
+    }
+
+    /*!
+     * Parses a 64-bit unsigned integer from a string.
+     * @param str The string to parse.
+     * @param base The base of the number.
+     * @param mode The parse mode.
+     * @return The parsed number if the string is valid, else an empty optional.
+     */
+    inline std::optional<u64> parse_u64(std::string_view str, int base = 10, ParseMode mode = PARSE_STRICT) {
+        u64 value;
+        if (parse(str, value, base, mode) != std::errc())
+            return std::nullopt;
+        return value;
+    }
+
+    /*!
+     * Parses a single precision float from a string.
+     * @param str The string to parse.
+     * @param mode The parse mode.
+     * @return The parsed number if the string is valid, else an empty optional.
+     */
+    inline std::optional<f32> parse_f32(std::string_view str, ParseMode mode = PARSE_STRICT) {
+        f32 value;
+        if (parse(str, value, mode) != std::errc())
+            return std::nullopt;
+        return value;
+    }
+
+    /*!
+     * Parses a double precision float from a string.
+     * @param str The string to parse.
+     * @param mode The parse mode.
+     * @return The parsed number if the string is valid, else an empty optional.
+     */
+    inline std::optional<f64> parse_f64(std::string_view str, ParseMode mode = PARSE_STRICT) {
+        f64 value;
+        if (parse(str, value, mode) != std::errc())
+            return std::nullopt;
+        return value;
+    }
 
     /*
      * String conversions
@@ -148,10 +614,11 @@ namespace lambdacommon::lstring
     {
         /*!
          * Converts an UTF-8 character to an UTF-32 character.
-         * @param character Value representing an UTF-8 character.
-         * @return The UTF-32 character.
+         * @param character Value starting with an UTF-8 character, only the first code point is decoded.
+         * @return The UTF-32 character, or -1 if the sequence is invalid.
+         * @see unicode::utf8_to_utf32 to decode whole strings.
          */
-        extern char32_t LAMBDACOMMON_API to_utf32(const std::string& character);
+        extern char32_t LAMBDACOMMON_API to_utf32(std::string_view character);
 
         /*!
          * Converts an UTF-8 character to an UTF-32 character.
@@ -159,6 +626,182 @@ namespace lambdacommon::lstring
          * @return The UTF-32 character.
          */
         extern char32_t LAMBDACOMMON_API to_utf32(const char* character);
+
+        /*!
+         * The code point yielded for invalid sequences.
+         */
+        constexpr char32_t REPLACEMENT_CHARACTER = U'\uFFFD';
+
+        namespace detail
+        {
+            /*!
+             * Decodes the code point starting at the specified position, invalid sequences are decoded as one REPLACEMENT_CHARACTER per byte.
+             * @param it The start of the sequence.
+             * @param end The end of the string.
+             * @param code_point The decoded code point.
+             * @return The length of the sequence in bytes.
+             */
+            inline size_t decode(const char* it, const char* end, char32_t& code_point) {
+                auto lead = static_cast<u8>(*it);
+                if (lead < 0x80) {
+                    code_point = lead;
+                    return 1;
+                }
+
+                size_t length;
+                char32_t min;
+                if (lead >= 0xC2 && lead < 0xE0) {
+                    length = 2;
+                    code_point = lead & 0x1Fu;
+                    min = 0x80;
+                } else if (lead >= 0xE0 && lead < 0xF0) {
+                    length = 3;
+                    code_point = lead & 0x0Fu;
+                    min = 0x800;
+                } else if (lead >= 0xF0 && lead < 0xF5) {
+                    length = 4;
+                    code_point = lead & 0x07u;
+                    min = 0x10000;
+                } else {
+                    code_point = REPLACEMENT_CHARACTER;
+                    return 1;
+                }
+
+                if (static_cast<size_t>(end - it) < length) {
+                    code_point = REPLACEMENT_CHARACTER;
+                    return 1;
+                }
+                for (size_t i = 1; i < length; i++) {
+                    auto byte = static_cast<u8>(it[i]);
+                    if ((byte & 0xC0u) != 0x80u) {
+                        code_point = REPLACEMENT_CHARACTER;
+                        return 1;
+                    }
+                    code_point = (code_point << 6u) | (byte & 0x3Fu);
+                }
+                if (code_point < min || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+                    code_point = REPLACEMENT_CHARACTER;
+                    return 1;
+                }
+                return length;
+            }
+        }
+
+        /*!
+         * A view over the code points of an UTF-8 string, decoded lazily while iterating.
+         * Invalid sequences yield one REPLACEMENT_CHARACTER per invalid byte, the iteration never fails.
+         */
+        class code_point_view
+        {
+        private:
+            std::string_view _source;
+
+        public:
+            class iterator
+            {
+            private:
+                const char* _it = nullptr;
+                const char* _end = nullptr;
+                char32_t _code_point = 0;
+                size_t _length = 0;
+
+                void decode() {
+                    if (_it != _end)
+                        _length = detail::decode(_it, _end, _code_point);
+                }
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = char32_t;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const char32_t*;
+                using reference = char32_t;
+
+                iterator() = default;
+
+                iterator(const char* it, const char* end) : _it(it), _end(end) {
+                    decode();
+                }
+
+                reference operator*() const {
+                    return _code_point;
+                }
+
+                /*!
+                 * Gets the address of the current sequence in the source string.
+                 * @return The address of the current sequence.
+                 */
+                [[nodiscard]] const char* base() const {
+                    return _it;
+                }
+
+                /*!
+                 * Gets the current sequence.
+                 * @return The bytes of the current code point.
+                 */
+                [[nodiscard]] std::string_view sequence() const {
+                    return {_it, _length};
+                }
+
+                iterator& operator++() {
+                    _it += _length;
+                    decode();
+                    return *this;
+                }
+
+                iterator operator++(int) {
+                    iterator old = *this;
+                    ++*this;
+                    return old;
+                }
+
+                bool operator==(const iterator& other) const {
+                    return _it == other._it;
+                }
+
+                bool operator!=(const iterator& other) const {
+                    return !(*this == other);
+                }
+            };
+
+            constexpr code_point_view() noexcept = default;
+
+            constexpr explicit code_point_view(std::string_view source) noexcept : _source(source) {}
+
+            [[nodiscard]] iterator begin() const {
+                return {_source.data(), _source.data() + _source.size()};
+            }
+
+            [[nodiscard]] iterator end() const {
+                auto end = _source.data() + _source.size();
+                return {end, end};
+            }
+
+            [[nodiscard]] constexpr std::string_view source() const {
+                return _source;
+            }
+        };
+
+        /*!
+         * Gets the number of terminal columns used by the specified code point.
+         *
+         * Combining marks, zero-width and format characters, and control characters use 0 columns,
+         * East Asian wide and fullwidth characters and emoji presented as emoji use 2 columns, everything else uses 1 column.
+         *
+         * @param code_point The code point.
+         * @return The width of the code point, 0, 1 or 2.
+         */
+        extern u8 LAMBDACOMMON_API code_point_width(char32_t code_point);
+
+        /*!
+         * Gets the number of terminal columns used by the specified UTF-8 string.
+         *
+         * Emoji joined with ZERO WIDTH JOINER, emoji followed by skin tone modifiers and pairs of regional indicators (flags) count as one 2-columns character.
+         *
+         * @param str The UTF-8 string.
+         * @return The display width of the string.
+         */
+        extern size_t LAMBDACOMMON_API display_width(std::string_view str);
     }
 
     /**
@@ -166,14 +809,14 @@ namespace lambdacommon::lstring
      * @param wstring The std::wstring to convert.
      * @return The converted string.
      */
-    extern std::string LAMBDACOMMON_API from_wstring_to_utf8(const std::wstring& wstring);
+    extern std::string LAMBDACOMMON_API from_wstring_to_utf8(std::wstring_view wstring);
 
     /**
      * Converts a std::string to a std::wstring.
      * @param wstring The std::string to convert.
      * @return The converted wstring.
      */
-    extern std::wstring LAMBDACOMMON_API from_utf8_to_wstring(const std::string& string);
+    extern std::wstring LAMBDACOMMON_API from_utf8_to_wstring(std::string_view string);
 
     namespace stream
     {
@@ -181,4 +824,8 @@ namespace lambdacommon::lstring
     }
 }
 
+#ifdef LAMBDA_WINDOWS
+#  pragma warning(pop)
+#endif
+
 #endif //LAMBDACOMMON_STRING_H
@@ -11,8 +11,20 @@
 #define LAMBDACOMMON_RESOURCES_H
 
 #include "system/fs.h"
+#include "buffer.h"
 #include "lstring.h"
+#include "hash.h"
+#include "thread_pool.h"
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #ifdef LAMBDA_WINDOWS
 #  pragma warning(push)
@@ -92,6 +104,393 @@ namespace lambdacommon
         }
     };
 
+    /*!
+     * IdentifierHash
+     *
+     * Hasher of identifiers, an identifier and its string representation {@code "namespace:path"} have the same hash.
+     * Combined with {@code IdentifierEqual} it allows heterogeneous lookup in unordered containers (needs a C++20 standard library),
+     * for example {@code std::unordered_map<Identifier, T, IdentifierHash, IdentifierEqual>::find(std::string_view)}.
+     */
+    struct IdentifierHash
+    {
+        using is_transparent = void;
+
+        static inline size_t hash(std::string_view domain, std::string_view name) noexcept {
+            return static_cast<size_t>(hashing::hash_string(name, hashing::hash_string(domain)));
+        }
+
+        inline size_t operator()(const Identifier& identifier) const noexcept {
+            return hash(identifier.get_domain(), identifier.get_name());
+        }
+
+        inline size_t operator()(std::string_view name) const noexcept {
+            auto separator = name.find(':');
+            if (separator == std::string_view::npos)
+                return hash(name, {});
+            return hash(name.substr(0, separator), name.substr(separator + 1));
+        }
+
+        inline size_t operator()(const std::string& name) const noexcept {
+            return (*this)(std::string_view{name});
+        }
+
+        inline size_t operator()(const char* name) const noexcept {
+            return (*this)(std::string_view{name});
+        }
+    };
+
+    /*!
+     * IdentifierEqual
+     *
+     * Transparent equality of identifiers, an identifier is equal to its string representation {@code "namespace:path"}.
+     */
+    struct IdentifierEqual
+    {
+        using is_transparent = void;
+
+        static inline bool equals(const Identifier& identifier, std::string_view name) noexcept {
+            const auto& domain = identifier.get_domain();
+            const auto& path = identifier.get_name();
+            return name.size() == domain.size() + 1 + path.size() && name[domain.size()] == ':'
+                   && name.compare(0, domain.size(), domain) == 0 && name.compare(domain.size() + 1, path.size(), path) == 0;
+        }
+
+        inline bool operator()(const Identifier& a, const Identifier& b) const {
+            return a == b;
+        }
+
+        inline bool operator()(const Identifier& a, std::string_view b) const noexcept {
+            return equals(a, b);
+        }
+
+        inline bool operator()(std::string_view a, const Identifier& b) const noexcept {
+            return equals(b, a);
+        }
+
+        inline bool operator()(const Identifier& a, const std::string& b) const noexcept {
+            return equals(a, b);
+        }
+
+        inline bool operator()(const std::string& a, const Identifier& b) const noexcept {
+            return equals(b, a);
+        }
+
+        inline bool operator()(const Identifier& a, const char* b) const noexcept {
+            return equals(a, b);
+        }
+
+        inline bool operator()(const char* a, const Identifier& b) const noexcept {
+            return equals(b, a);
+        }
+    };
+
+    namespace detail
+    {
+        /*!
+         * Hashes a string with 32-bit FNV-1a, usable at compile time.
+         * @param str The string to hash.
+         * @return The hash of the string.
+         */
+        constexpr u32 fnv1a_32(std::string_view str) {
+            u32 hash = 2166136261u;
+            for (char c : str) {
+                hash ^= static_cast<u8>(c);
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+    }
+
+    /*!
+     * IdentifierLiteral
+     *
+     * Represents a resource identifier literal ({@code "namespace:path"_id}), validated and hashed at compile time.
+     */
+    struct IdentifierLiteral
+    {
+        std::string_view value;
+        size_t separator;
+        u32 hash;
+    };
+
+    /*!
+     * InternedIdentifier
+     *
+     * Represents a resource identifier interned in a global symbol table.
+     * It only holds a 32-bit handle and the cached hash of the identifier, so copies are free and equality is a single integer comparison.
+     *
+     * The symbol table is shared by every thread and never shrinks: interning the same identifier always gives the same handle,
+     * and the views returned by get_domain() and get_name() stay valid until the end of the program.
+     */
+    class LAMBDACOMMON_API InternedIdentifier
+    {
+    private:
+        u32 _handle;
+        u32 _hash;
+
+    public:
+        /*!
+         * Interns an identifier literal, the hash is not computed again.
+         * @param literal The identifier literal.
+         */
+        InternedIdentifier(const IdentifierLiteral& literal);
+
+        /*!
+         * Interns an identifier from its string representation.
+         * @param name The identifier as {@code "namespace:path"}.
+         * @throws std::invalid_argument If the identifier doesn't have a namespace.
+         */
+        explicit InternedIdentifier(std::string_view name);
+
+        /*!
+         * Interns an identifier from its namespace and its path.
+         * @param domain The namespace.
+         * @param name The path.
+         * @throws std::invalid_argument If the namespace is empty or contains a ':'.
+         */
+        InternedIdentifier(std::string_view domain, std::string_view name);
+
+        /*!
+         * Interns an existing identifier.
+         * @param identifier The identifier.
+         */
+        explicit InternedIdentifier(const Identifier& identifier);
+
+        /*!
+         * Gets the handle of the identifier in the symbol table.
+         * @return The handle.
+         */
+        [[nodiscard]] inline u32 get_handle() const {
+            return _handle;
+        }
+
+        /*!
+         * Gets the cached hash of the identifier, it is the same as the hash of the string {@code "namespace:path"}.
+         * @return The hash.
+         */
+        [[nodiscard]] inline u32 hash() const {
+            return _hash;
+        }
+
+        /*!
+         * Gets the namespace of the resource.
+         * @return The namespace of the resource.
+         */
+        [[nodiscard]] std::string_view get_domain() const;
+
+        /*!
+         * Gets the name of the resource.
+         * @return The name of the resource.
+         */
+        [[nodiscard]] std::string_view get_name() const;
+
+        /*!
+         * Gets the identifier as a string view, no concatenation is done.
+         * @return The identifier as {@code "namespace:path"}.
+         */
+        [[nodiscard]] std::string_view to_string_view() const;
+
+        [[nodiscard]] std::string to_string() const;
+
+        /*!
+         * Converts this interned identifier to an {@code Identifier}.
+         * @return The identifier.
+         */
+        [[nodiscard]] Identifier to_identifier() const;
+
+        explicit operator Identifier() const;
+
+        inline bool operator==(const InternedIdentifier& other) const {
+            return _handle == other._handle;
+        }
+
+        inline bool operator!=(const InternedIdentifier& other) const {
+            return _handle != other._handle;
+        }
+
+        /*!
+         * Orders the identifiers by handle, which is the interning order and not the lexicographic order.
+         */
+        inline bool operator<(const InternedIdentifier& other) const {
+            return _handle < other._handle;
+        }
+    };
+
+    inline namespace literals
+    {
+        /*!
+         * Creates an identifier literal, an identifier without namespace fails to compile when used in a constant expression.
+         * @return The identifier literal, which converts to {@code InternedIdentifier}.
+         */
+        constexpr IdentifierLiteral operator ""_id(const char* str, size_t length) {
+            std::string_view value{str, length};
+            auto separator = value.find(':');
+            if (separator == 0 || separator == std::string_view::npos)
+                throw std::invalid_argument("The resource name literal is invalid, it must be like \"namespace:path\".");
+            return {value, separator, detail::fnv1a_32(value)};
+        }
+    }
+
+    /*!
+     * ResourceView
+     *
+     * Represents the immutable bytes of a loaded resource.
+     * The bytes are shared: copying a view only increments a reference count, and the bytes stay valid as long as a view references them
+     * (even if the resource is evicted from a cache or reloaded in the meantime).
+     */
+    class LAMBDACOMMON_API ResourceView
+    {
+    private:
+        std::shared_ptr<const void> _owner;
+        std::string_view _bytes;
+
+    public:
+        /*!
+         * Creates an empty view which represents a resource that couldn't be loaded.
+         */
+        ResourceView() = default;
+
+        /*!
+         * Creates a view.
+         * @param owner The owner of the bytes, released when the last view referencing the bytes is destroyed.
+         * @param bytes The bytes.
+         */
+        ResourceView(std::shared_ptr<const void> owner, std::string_view bytes) noexcept;
+
+        /*!
+         * Creates a view which owns a copy of the specified string.
+         * @param content The content of the resource.
+         * @return The view.
+         */
+        static ResourceView from_string(std::string content);
+
+        [[nodiscard]] inline const char* data() const noexcept {
+            return _bytes.data();
+        }
+
+        [[nodiscard]] inline size_t size() const noexcept {
+            return _bytes.size();
+        }
+
+        [[nodiscard]] inline bool empty() const noexcept {
+            return _bytes.empty();
+        }
+
+        /*!
+         * Checks whether the resource was loaded.
+         * @return True if the resource was loaded (even if empty), else false.
+         */
+        [[nodiscard]] inline bool is_loaded() const noexcept {
+            return static_cast<bool>(_owner);
+        }
+
+        [[nodiscard]] inline std::string_view view() const noexcept {
+            return _bytes;
+        }
+
+        inline operator std::string_view() const noexcept {
+            return _bytes;
+        }
+
+        /*!
+         * Copies the bytes into a string.
+         * @return The content of the resource.
+         */
+        [[nodiscard]] inline std::string to_string() const {
+            return std::string(_bytes);
+        }
+
+        /*!
+         * Gets a view of a part of the bytes, which shares their ownership.
+         * @param offset The offset of the first byte.
+         * @param count The number of bytes.
+         * @return The view.
+         */
+        [[nodiscard]] inline ResourceView subview(size_t offset, size_t count = std::string_view::npos) const {
+            return {_owner, _bytes.substr(offset, count)};
+        }
+
+        /*!
+         * Gets the number of views sharing the bytes.
+         * @return The number of views.
+         */
+        [[nodiscard]] inline long use_count() const noexcept {
+            return _owner.use_count();
+        }
+
+        /*!
+         * Gets a buffer chain of the bytes, which shares their ownership instead of copying them.
+         * @return The buffer chain.
+         */
+        [[nodiscard]] inline BufferChain to_buffer_chain() const {
+            BufferChain chain;
+            chain.append_shared(_owner, _bytes);
+            return chain;
+        }
+    };
+
+    /*!
+     * ResourceReader
+     *
+     * Represents a sequential reader of the content of a resource, which reads the resource chunk by chunk into a buffer supplied by the caller
+     * so large resources can be processed with a fixed memory footprint.
+     */
+    class LAMBDACOMMON_API ResourceReader
+    {
+    public:
+        virtual ~ResourceReader() = default;
+
+        /*!
+         * Reads the next bytes of the resource.
+         * @param buffer The buffer to read into.
+         * @param size The size of the buffer.
+         * @return The number of bytes read, less than the size of the buffer only at the end of the resource or on error, 0 at the end of the resource.
+         */
+        virtual size_t read(char* buffer, size_t size) = 0;
+
+        /*!
+         * Moves the reading position.
+         * @param offset The new position, from the beginning of the resource.
+         * @return True if the position was moved, else false.
+         */
+        virtual bool seek(u64 offset) = 0;
+
+        /*!
+         * Gets the reading position.
+         * @return The position, from the beginning of the resource.
+         */
+        [[nodiscard]] virtual u64 tell() const = 0;
+
+        /*!
+         * Gets the size of the resource if it is known, to size buffers or report progress.
+         * @return The size of the resource in bytes, if known.
+         */
+        [[nodiscard]] virtual std::optional<u64> size_hint() const = 0;
+    };
+
+    /*!
+     * ResourceViewReader
+     *
+     * Represents a reader of a resource already in memory.
+     */
+    class LAMBDACOMMON_API ResourceViewReader : public ResourceReader
+    {
+    private:
+        ResourceView _view;
+        size_t _position = 0;
+
+    public:
+        explicit ResourceViewReader(ResourceView view);
+
+        size_t read(char* buffer, size_t size) override;
+
+        bool seek(u64 offset) override;
+
+        [[nodiscard]] u64 tell() const override;
+
+        [[nodiscard]] std::optional<u64> size_hint() const override;
+    };
+
     /*!
      * ResourcesManager
      *
@@ -146,6 +545,45 @@ namespace lambdacommon
          * @return The resource content if successfully loaded, else an empty string.
          */
         [[nodiscard]] virtual std::string load_resource(const Identifier& resource) const = 0;
+
+        /*! @brief Loads the resource content without copying it when the resources manager allows it.
+         *
+         * The default implementation copies the result of {@code load_resource} into the view.
+         *
+         * @param resource The resource to load.
+         * @param extension The extension of the resource file.
+         * @return The resource content if successfully loaded, else an empty view.
+         */
+        [[nodiscard]] virtual ResourceView load_resource_view(const Identifier& resource, const std::string& extension = "") const;
+
+        /*! @brief Gets a key telling where the resource is stored, resources with close keys are faster to load one after the other.
+         *
+         * Used to order batched loads, the default implementation returns 0.
+         *
+         * @param resource The resource.
+         * @param extension The extension of the resource file.
+         * @return The locality key of the resource.
+         */
+        [[nodiscard]] virtual u64 get_locality_key(const Identifier& resource, const std::string& extension) const;
+
+        /*! @brief Lists the resources of the resources manager.
+         *
+         * The default implementation returns false, as not every resources manager can list its resources.
+         *
+         * @param keys The list to append the keys of the resources to, formatted as {@code namespace:path.extension}.
+         * @return True if the resources were listed, else false.
+         */
+        virtual bool list_resources(std::vector<std::string>& keys) const;
+
+        /*! @brief Opens a reader of the resource content, to process the resource incrementally.
+         *
+         * The default implementation reads from the result of {@code load_resource_view}.
+         *
+         * @param resource The resource to open.
+         * @param extension The extension of the resource file.
+         * @return The reader, or null if the resource doesn't exist.
+         */
+        [[nodiscard]] virtual std::unique_ptr<ResourceReader> open_resource(const Identifier& resource, const std::string& extension = "") const;
     };
 
     class LAMBDACOMMON_API FileResourcesManager : public ResourcesManager
@@ -177,15 +615,435 @@ namespace lambdacommon
 
         std::string load_resource(const Identifier& resource, const std::string& extension) const override;
 
+        /*! @brief Loads the resource file, large files are memory-mapped so their content is never copied.
+         *
+         * @param resource The resource to load.
+         * @param extension The extension of the resource file.
+         * @return The resource content if successfully loaded, else an empty view.
+         */
+        ResourceView load_resource_view(const Identifier& resource, const std::string& extension = "") const override;
+
+        /*! @brief Gets the inode of the resource file (0 on Windows), so files are loaded in their on-disk order.
+         *
+         * @param resource The resource.
+         * @param extension The extension of the resource file.
+         * @return The inode of the resource file, or 0 if the file doesn't exist.
+         */
+        u64 get_locality_key(const Identifier& resource, const std::string& extension) const override;
+
+        /*! @brief Lists the files of the working directory, the files directly in the working directory are ignored.
+         *
+         * @param keys The list to append the keys of the resources to.
+         * @return True if the working directory was listed, else false.
+         */
+        bool list_resources(std::vector<std::string>& keys) const override;
+
+        /*! @brief Opens the resource file for reading, only the buffer of the caller holds its content.
+         *
+         * @param resource The resource to open.
+         * @param extension The extension of the resource file.
+         * @return The reader, or null if the file cannot be opened.
+         */
+        std::unique_ptr<ResourceReader> open_resource(const Identifier& resource, const std::string& extension = "") const override;
+
         FileResourcesManager& operator=(const FileResourcesManager& other);
 
         FileResourcesManager& operator=(FileResourcesManager&& other) noexcept;
 
         bool operator==(const FileResourcesManager& other) const;
     };
+
+    /*!
+     * Represents the result of the asynchronous loading of a resource.
+     */
+    struct ResourceLoadResult
+    {
+        /*!
+         * The content of the resource, not loaded if the resource couldn't be loaded.
+         */
+        ResourceView view;
+        /*!
+         * The time spent loading the resource.
+         */
+        std::chrono::nanoseconds latency{0};
+    };
+
+    /*!
+     * Represents the report of a batch of asynchronous loads.
+     */
+    struct LAMBDACOMMON_API ResourceBatchReport
+    {
+        /*!
+         * The results, in the same order as the requested resources.
+         */
+        std::vector<ResourceLoadResult> results;
+        size_t loaded = 0;
+        size_t failed = 0;
+        u64 bytes = 0;
+        /*!
+         * The time between the submission of the batch and the end of the last load.
+         */
+        std::chrono::nanoseconds elapsed{0};
+        std::chrono::nanoseconds max_latency{0};
+        std::chrono::nanoseconds total_latency{0};
+
+        /*!
+         * Gets the throughput of the batch.
+         * @return The number of bytes loaded per second.
+         */
+        [[nodiscard]] double get_bytes_per_second() const;
+
+        /*!
+         * Gets the mean time spent loading a resource.
+         * @return The mean latency.
+         */
+        [[nodiscard]] std::chrono::nanoseconds get_mean_latency() const;
+    };
+
+    /*!
+     * ResourceLoader
+     *
+     * Loads resources asynchronously from a resources manager with a bounded pool of I/O threads.
+     *
+     * The resources of a batch are ordered by directory then by locality key (the inode for files) before being loaded,
+     * and the threads take them in this order so loads stay close on the disk. The locality keys are computed by the I/O threads.
+     * Loads cannot be submitted from the I/O threads of the loader, since the submission blocks while the queue is full.
+     * The resources manager must outlive the loader, and must be safe to use from multiple threads (the managers of λcommon are).
+     */
+    class LAMBDACOMMON_API ResourceLoader
+    {
+    private:
+        const ResourcesManager& _manager;
+        ThreadPool _pool;
+
+        /*!
+         * Checks that the calling thread isn't an I/O thread of the loader: submitting blocks while the queue of the pool is full,
+         * which would never end if the threads emptying the queue were waiting for it.
+         * @throws std::logic_error If the calling thread is an I/O thread of the loader.
+         */
+        void check_caller_thread() const;
+
+    public:
+        /*!
+         * Creates a resource loader.
+         * @param manager The resources manager to load resources from.
+         * @param threads The number of I/O threads, 0 to use the number of hardware threads.
+         */
+        explicit ResourceLoader(const ResourcesManager& manager, size_t threads = 0);
+
+        /*!
+         * Loads a resource asynchronously.
+         * @param resource The resource to load.
+         * @param extension The extension of the resource file.
+         * @return The future of the resource content, an empty view if the resource couldn't be loaded.
+         * @throws std::logic_error If called from an I/O thread of the loader, an {@code on_loaded} callback for example.
+         */
+        std::future<ResourceView> load_resource_async(const Identifier& resource, const std::string& extension = "");
+
+        /*!
+         * Loads resources asynchronously.
+         * @param resources The resources to load.
+         * @param extension The extension of the resource files.
+         * @param on_loaded Called from an I/O thread each time a resource is loaded, with the index of the resource in the batch.
+         * @return The future of the report of the batch, available once every resource is loaded.
+         * @throws std::logic_error If called from an I/O thread of the loader, an {@code on_loaded} callback for example.
+         */
+        std::future<ResourceBatchReport> load_resources_async(std::vector<Identifier> resources, const std::string& extension = "",
+                                                              std::function<void(size_t, const ResourceLoadResult&)> on_loaded = {});
+    };
+
+    /*!
+     * Represents the statistics of a resources cache.
+     */
+    struct ResourcesCacheStats
+    {
+        u64 hits;
+        u64 misses;
+        u64 evictions;
+        /*!
+         * The number of cached resources reloaded because their file was modified.
+         */
+        u64 invalidations;
+        size_t entries;
+        size_t bytes;
+    };
+
+    /*!
+     * CachingFileResourcesManager
+     *
+     * Represents a file resources manager which keeps the loaded resources in memory.
+     *
+     * The cache is bounded by the total size of the cached resources, the least recently used resources are evicted first.
+     * Each lookup checks the modification time and the size of the file so modified resources are reloaded, this can be disabled for immutable resources.
+     * Resource files should be replaced (written then renamed) rather than modified in place, as large files are memory-mapped.
+     *
+     * The cache is thread-safe.
+     */
+    class LAMBDACOMMON_API CachingFileResourcesManager : public FileResourcesManager
+    {
+    private:
+        struct CacheEntry
+        {
+            std::string key;
+            lambdacommon::fs::path path;
+            ResourceView view;
+            // Modification time (in nanoseconds, or 100 nanoseconds on Windows) and size of the file when it was loaded.
+            u64 modification_time;
+            u64 file_size;
+        };
+
+        size_t _capacity;
+        bool _check_modifications = true;
+        mutable std::mutex _mutex;
+        mutable std::list<CacheEntry> _entries;
+        mutable std::unordered_map<std::string_view, std::list<CacheEntry>::iterator> _index;
+        mutable ResourcesCacheStats _stats{};
+
+        void evict(size_t target_bytes) const;
+
+    public:
+        /*!
+         * Creates a caching file resources manager.
+         * @param working_directory The working directory.
+         * @param capacity The maximum number of bytes kept in the cache.
+         */
+        explicit CachingFileResourcesManager(lambdacommon::fs::path working_directory = std::move(fs::current_path()), size_t capacity = 64 * 1024 * 1024);
+
+        CachingFileResourcesManager(const CachingFileResourcesManager& other) = delete;
+
+        CachingFileResourcesManager& operator=(const CachingFileResourcesManager& other) = delete;
+
+        /*!
+         * Gets the maximum number of bytes kept in the cache.
+         * @return The capacity of the cache in bytes.
+         */
+        [[nodiscard]] size_t get_capacity() const;
+
+        /*!
+         * Sets the maximum number of bytes kept in the cache, evicts resources if needed.
+         * @param capacity The capacity of the cache in bytes.
+         */
+        void set_capacity(size_t capacity);
+
+        /*!
+         * Sets whether the modification time of the files is checked on each lookup.
+         * @param check_modifications True to reload modified resources, false if the resources never change.
+         */
+        void set_check_modifications(bool check_modifications);
+
+        ResourceView load_resource_view(const Identifier& resource, const std::string& extension = "") const override;
+
+        /*!
+         * Removes a resource from the cache.
+         * @param resource The resource.
+         * @param extension The extension of the resource file.
+         */
+        void invalidate(const Identifier& resource, const std::string& extension = "");
+
+        /*!
+         * Removes every resource from the cache.
+         */
+        void clear();
+
+        /*!
+         * Gets the statistics of the cache.
+         * @return The statistics.
+         */
+        [[nodiscard]] ResourcesCacheStats get_stats() const;
+    };
+
+    /*!
+     * ArchiveResourcesManager
+     *
+     * Represents a resources manager which loads the resources from a single archive file, built with {@code pack_resources_archive}.
+     *
+     * The archive is opened (and memory-mapped) once, finding a resource is a single probe in the hash index of the archive,
+     * and the loaded views share the bytes of the archive without copying them.
+     *
+     * Format of the archive (little-endian):
+     * - header (32 bytes): magic "LCRA", version (u32), resources count (u32), buckets count (u32, power of 2), index offset (u64), keys offset (u64);
+     * - index: open-addressing hash table of 32 bytes buckets: key hash (u64, 0 for an empty bucket), data offset (u64), data size (u64),
+     *   key offset (u32, relative to the keys offset), key length (u16), compression (u8, 0 for stored), reserved (u8);
+     * - keys: the keys of the resources ("namespace:path.extension"), concatenated;
+     * - data: the content of the resources, each aligned on 16 bytes.
+     */
+    class LAMBDACOMMON_API ArchiveResourcesManager : public ResourcesManager
+    {
+    private:
+        lambdacommon::fs::path _archive_path;
+        ResourceView _archive;
+        u32 _count;
+        u32 _bucket_mask;
+        size_t _index_offset;
+        size_t _keys_offset;
+
+        [[nodiscard]] std::optional<std::pair<u64, u64>> find(std::string_view key) const;
+
+        [[nodiscard]] std::optional<std::pair<u64, u64>> find(const Identifier& resource, const std::string& extension) const;
+
+    public:
+        /*!
+         * Opens an archive.
+         * @param archive_path The path of the archive file.
+         * @throws std::runtime_error If the archive cannot be opened or is invalid.
+         */
+        explicit ArchiveResourcesManager(lambdacommon::fs::path archive_path);
+
+        /*!
+         * Gets the path of the archive file.
+         * @return The path of the archive.
+         */
+        [[nodiscard]] const lambdacommon::fs::path& get_archive_path() const;
+
+        /*!
+         * Gets the number of resources in the archive.
+         * @return The number of resources.
+         */
+        [[nodiscard]] size_t get_resource_count() const;
+
+        bool has_resource(const Identifier& resource) const override;
+
+        bool has_resource(const Identifier& resource, const std::string& extension) const override;
+
+        std::string load_resource(const Identifier& resource) const override;
+
+        std::string load_resource(const Identifier& resource, const std::string& extension) const override;
+
+        /*! @brief Loads the resource from the archive without copying it.
+         *
+         * @param resource The resource to load.
+         * @param extension The extension of the resource file.
+         * @return The resource content if the archive contains the resource, else an empty view.
+         */
+        ResourceView load_resource_view(const Identifier& resource, const std::string& extension = "") const override;
+
+        /*! @brief Gets the offset of the resource in the archive.
+         *
+         * @param resource The resource.
+         * @param extension The extension of the resource file.
+         * @return The offset of the resource, or 0 if the archive doesn't contain the resource.
+         */
+        u64 get_locality_key(const Identifier& resource, const std::string& extension) const override;
+
+        bool list_resources(std::vector<std::string>& keys) const override;
+    };
+
+    /*!
+     * Packs the resources of a directory into an archive readable by {@code ArchiveResourcesManager}.
+     *
+     * The directory has the same layout as the working directory of a {@code FileResourcesManager}: the file {@code namespace/path.extension}
+     * becomes the resource {@code namespace:path} with the extension {@code extension}. Files directly in the directory are ignored.
+     *
+     * @param directory The directory containing the resources.
+     * @param archive_path The path of the archive file to write.
+     * @return The number of packed resources.
+     * @throws std::runtime_error If a resource cannot be read or the archive cannot be written.
+     */
+    extern size_t LAMBDACOMMON_API pack_resources_archive(const lambdacommon::fs::path& directory, const lambdacommon::fs::path& archive_path);
+
+    /*!
+     * LayeredResourcesManager
+     *
+     * Represents a stack of resources managers, each resource is loaded from the top-most layer which has it (mods and overrides on top of base assets).
+     *
+     * On the first lookup the layers which can list their resources are scanned into an index of which layers own which resources,
+     * the other layers are probed once per resource and the result (including a miss) is remembered.
+     * When a layer changes, {@code invalidate_layer} forgets only what is known about this layer.
+     *
+     * The manager is thread-safe, the layers must be safe to use from multiple threads.
+     */
+    class LAMBDACOMMON_API LayeredResourcesManager : public ResourcesManager
+    {
+    public:
+        /*!
+         * The maximum number of layers.
+         */
+        static constexpr size_t MAX_LAYERS = 64;
+
+    private:
+        struct IndexEntry
+        {
+            // One bit per layer: the layers probed for the resource, and the layers which have it (probed or scanned).
+            u64 known = 0;
+            u64 present = 0;
+        };
+
+        std::vector<std::shared_ptr<const ResourcesManager>> _layers;
+        mutable std::shared_mutex _mutex;
+        mutable std::unordered_map<std::string, IndexEntry> _index;
+        // The layers whose resources are listed in the index, and the layers to scan on the next lookup.
+        mutable u64 _scanned = 0;
+        mutable u64 _pending_scan = 0;
+        mutable u64 _generation = 0;
+
+        void scan() const;
+
+        [[nodiscard]] int find_layer_index(const Identifier& resource, const std::string& extension) const;
+
+    public:
+        /*!
+         * Creates a layered resources manager.
+         * @param layers The layers, from the lowest priority to the highest priority.
+         */
+        explicit LayeredResourcesManager(std::vector<std::shared_ptr<const ResourcesManager>> layers = {});
+
+        LayeredResourcesManager(const LayeredResourcesManager& other) = delete;
+
+        LayeredResourcesManager& operator=(const LayeredResourcesManager& other) = delete;
+
+        /*!
+         * Adds a layer on top of the others.
+         * @param layer The layer.
+         * @return The index of the layer.
+         * @throws std::length_error If the manager already has {@code MAX_LAYERS} layers.
+         */
+        size_t add_layer(std::shared_ptr<const ResourcesManager> layer);
+
+        /*!
+         * Gets the number of layers.
+         * @return The number of layers.
+         */
+        [[nodiscard]] size_t get_layer_count() const;
+
+        /*!
+         * Gets the layer which provides the specified resource.
+         * @param resource The resource.
+         * @param extension The extension of the resource file.
+         * @return The top-most layer which has the resource, or null if no layer has it.
+         */
+        [[nodiscard]] std::shared_ptr<const ResourcesManager> get_layer(const Identifier& resource, const std::string& extension = "") const;
+
+        /*!
+         * Forgets what is known about the resources of a layer, to call when the resources of the layer changed.
+         * A layer which can list its resources is scanned again on the next lookup.
+         * @param layer The index of the layer.
+         */
+        void invalidate_layer(size_t layer);
+
+        /*!
+         * Forgets what is known about every layer.
+         */
+        void invalidate();
+
+        bool has_resource(const Identifier& resource) const override;
+
+        bool has_resource(const Identifier& resource, const std::string& extension) const override;
+
+        std::string load_resource(const Identifier& resource) const override;
+
+        std::string load_resource(const Identifier& resource, const std::string& extension) const override;
+
+        ResourceView load_resource_view(const Identifier& resource, const std::string& extension = "") const override;
+
+        u64 get_locality_key(const Identifier& resource, const std::string& extension) const override;
+
+        bool list_resources(std::vector<std::string>& keys) const override;
+
+        std::unique_ptr<ResourceReader> open_resource(const Identifier& resource, const std::string& extension = "") const override;
+    };
 }
 
-// Structured bindings for lambdacommon::Identifier.
+// Structured bindings for lambdacommon::Identifier and hash of the identifiers.
 namespace std
 {
     template<>
@@ -198,6 +1056,22 @@ namespace std
     {
         using type = decltype(std::declval<lambdacommon::Identifier>().get<N>());
     };
+
+    template<>
+    struct hash<lambdacommon::Identifier>
+    {
+        size_t operator()(const lambdacommon::Identifier& identifier) const noexcept {
+            return lambdacommon::IdentifierHash{}(identifier);
+        }
+    };
+
+    template<>
+    struct hash<lambdacommon::InternedIdentifier>
+    {
+        size_t operator()(const lambdacommon::InternedIdentifier& identifier) const noexcept {
+            return identifier.hash();
+        }
+    };
 }
 
 #ifdef LAMBDA_WINDOWS
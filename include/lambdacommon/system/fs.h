@@ -12,6 +12,7 @@
 
 #include "../path.h"
 #include "../types.h"
+#include "../hash.h"
 #include <memory>
 #include <system_error>
 #include <utility>
@@ -913,6 +914,18 @@ namespace lambdacommon
     }
 }
 
+namespace std
+{
+    template<>
+    struct hash<lambdacommon::fs::path>
+    {
+        size_t operator()(const lambdacommon::fs::path& path) const noexcept {
+            const auto& native = path.native();
+            return static_cast<size_t>(lambdacommon::hashing::hash_bytes(native.data(), native.size() * sizeof(lambdacommon::fs::path::value_type)));
+        }
+    };
+}
+
 #ifdef LAMBDA_WINDOWS
 #  pragma warning(pop)
 #endif
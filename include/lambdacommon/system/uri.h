@@ -12,7 +12,12 @@
 
 #include "fs.h"
 #include "../connection/address.h"
+#include "../buffer.h"
 #include <map>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #ifdef LAMBDA_WINDOWS
 #  pragma warning(push)
@@ -35,12 +40,270 @@ namespace lambdacommon
             OTHER
         };
 
-        extern SchemeType LAMBDACOMMON_API get_scheme_type_by_string(const std::string& scheme);
+        extern SchemeType LAMBDACOMMON_API get_scheme_type_by_string(std::string_view scheme);
 
         extern port_t LAMBDACOMMON_API get_scheme_default_port(SchemeType scheme);
 
         extern bool LAMBDACOMMON_API is_scheme_type_non_file_special(SchemeType scheme);
 
+        /*!
+         * Represents the URI components, which each allow different characters without percent-encoding.
+         */
+        enum URIComponent
+        {
+            /*!
+             * A path, the '/' separators are kept.
+             */
+            COMPONENT_PATH,
+            /*!
+             * A single path segment, '/' is encoded.
+             */
+            COMPONENT_PATH_SEGMENT,
+            COMPONENT_QUERY,
+            /*!
+             * A key or a value of a query parameter, '&', '=' and '+' are encoded.
+             */
+            COMPONENT_QUERY_PARAMETER,
+            COMPONENT_FRAGMENT,
+            COMPONENT_USERINFO
+        };
+
+        /*!
+         * Computes the size of a string once percent-encoded.
+         * @param str The string to encode.
+         * @param component The component the string is encoded for.
+         * @return The size of the encoded string.
+         */
+        extern size_t LAMBDACOMMON_API percent_encoded_size(std::string_view str, URIComponent component);
+
+        /*!
+         * Percent-encodes a string into a buffer, every character not allowed in the component (including '%') is encoded.
+         * @param str The string to encode.
+         * @param component The component the string is encoded for.
+         * @param output The output buffer, of at least {@code percent_encoded_size(str, component)} bytes.
+         * @return The number of bytes written.
+         */
+        extern size_t LAMBDACOMMON_API percent_encode(std::string_view str, URIComponent component, char* output);
+
+        /*!
+         * Percent-encodes a string, every character not allowed in the component (including '%') is encoded.
+         * @param str The string to encode.
+         * @param component The component the string is encoded for.
+         * @return The encoded string.
+         */
+        extern std::string LAMBDACOMMON_API percent_encode(std::string_view str, URIComponent component);
+
+        /*!
+         * Decodes a percent-encoded string in place, the invalid percent-encoded sequences are kept as is and '+' is not decoded.
+         * @param data The string to decode.
+         * @param size The size of the string.
+         * @return The size of the decoded string.
+         */
+        extern size_t LAMBDACOMMON_API percent_decode(char* data, size_t size);
+
+        /*!
+         * Decodes a percent-encoded string, the invalid percent-encoded sequences are kept as is and '+' is not decoded.
+         * @param str The string to decode.
+         * @return The decoded string.
+         */
+        extern std::string LAMBDACOMMON_API percent_decode(std::string_view str);
+
+        /*!
+         * QueryParameters
+         *
+         * Represents the query parameters of an URI, in order and with repeated keys.
+         *
+         * The parameters are stored percent-encoded in a single buffer indexed by a flat vector, so parsing a query allocates twice whatever the number of parameters.
+         * Lookups take a decoded key and compare it to the encoded keys without decoding them; values are decoded only when requested.
+         */
+        class LAMBDACOMMON_API QueryParameters
+        {
+        private:
+            struct Entry
+            {
+                u32 key_offset;
+                u32 key_size;
+                u32 value_offset;
+                u32 value_size;
+            };
+
+            std::string _buffer;
+            std::vector<Entry> _entries;
+            // The bytes of the buffer not referenced anymore.
+            size_t _unused = 0;
+
+            [[nodiscard]] inline std::string_view get_key(const Entry& entry) const {
+                return std::string_view{_buffer}.substr(entry.key_offset, entry.key_size);
+            }
+
+            [[nodiscard]] inline std::string_view get_value(const Entry& entry) const {
+                return std::string_view{_buffer}.substr(entry.value_offset, entry.value_size);
+            }
+
+            [[nodiscard]] std::vector<Entry>::const_iterator find(std::string_view key) const;
+
+            Entry append(std::string_view key, std::string_view value, bool encode);
+
+            void compact();
+
+        public:
+            /*!
+             * Iterates the parameters as pairs of percent-encoded key and value.
+             */
+            class const_iterator
+            {
+            private:
+                const QueryParameters* _parameters;
+                std::vector<Entry>::const_iterator _it;
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = std::pair<std::string_view, std::string_view>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = value_type;
+
+                const_iterator(const QueryParameters* parameters, std::vector<Entry>::const_iterator it) : _parameters(parameters), _it(it) {}
+
+                inline value_type operator*() const {
+                    return {_parameters->get_key(*_it), _parameters->get_value(*_it)};
+                }
+
+                inline const_iterator& operator++() {
+                    ++_it;
+                    return *this;
+                }
+
+                inline const_iterator operator++(int) {
+                    auto old = *this;
+                    ++_it;
+                    return old;
+                }
+
+                inline bool operator==(const const_iterator& other) const {
+                    return _it == other._it;
+                }
+
+                inline bool operator!=(const const_iterator& other) const {
+                    return _it != other._it;
+                }
+            };
+
+            QueryParameters() = default;
+
+            /*!
+             * Creates query parameters from decoded keys and values.
+             * @param parameters The parameters.
+             */
+            QueryParameters(std::initializer_list<std::pair<std::string_view, std::string_view>> parameters);
+
+            /*!
+             * Creates query parameters from decoded keys and values, sorted by key.
+             * @param parameters The parameters.
+             */
+            QueryParameters(const std::map<std::string, std::string>& parameters);
+
+            /*!
+             * Parses a query string, the parameters are separated by '&' and a key is separated from its value by '='.
+             * @param query The percent-encoded query, without the '?'.
+             * @return The query parameters.
+             */
+            static QueryParameters parse(std::string_view query);
+
+            [[nodiscard]] inline size_t size() const noexcept {
+                return _entries.size();
+            }
+
+            [[nodiscard]] inline bool empty() const noexcept {
+                return _entries.empty();
+            }
+
+            [[nodiscard]] inline const_iterator begin() const {
+                return {this, _entries.begin()};
+            }
+
+            [[nodiscard]] inline const_iterator end() const {
+                return {this, _entries.end()};
+            }
+
+            /*!
+             * Checks whether a parameter has the specified key.
+             * @param key The decoded key.
+             * @return True if the key is present, else false.
+             */
+            [[nodiscard]] bool contains(std::string_view key) const;
+
+            /*!
+             * Counts the parameters which have the specified key.
+             * @param key The decoded key.
+             * @return The number of parameters with the key.
+             */
+            [[nodiscard]] size_t count(std::string_view key) const;
+
+            /*!
+             * Gets the value of the first parameter with the specified key, without decoding it.
+             * @param key The decoded key.
+             * @return The percent-encoded value, if the key is present.
+             */
+            [[nodiscard]] std::optional<std::string_view> get_raw(std::string_view key) const;
+
+            /*!
+             * Gets the decoded value of the first parameter with the specified key.
+             * @param key The decoded key.
+             * @return The decoded value, if the key is present.
+             */
+            [[nodiscard]] std::optional<std::string> get(std::string_view key) const;
+
+            /*!
+             * Gets the decoded values of every parameter with the specified key, in order.
+             * @param key The decoded key.
+             * @return The decoded values.
+             */
+            [[nodiscard]] std::vector<std::string> get_all(std::string_view key) const;
+
+            /*!
+             * Adds a parameter after the others, even if the key is already present.
+             * The key and the value are percent-encoded, '%' included.
+             * @param key The decoded key.
+             * @param value The decoded value, empty for a parameter without value.
+             */
+            void add(std::string_view key, std::string_view value = "");
+
+            /*!
+             * Adds an already percent-encoded parameter after the others, even if the key is already present.
+             * @param key The percent-encoded key, without '&' nor '='.
+             * @param value The percent-encoded value, without '&', empty for a parameter without value.
+             */
+            void add_raw(std::string_view key, std::string_view value = "");
+
+            /*!
+             * Sets the value of the first parameter with the specified key and removes the other parameters with this key,
+             * or adds the parameter if the key is not present.
+             * @param key The decoded key.
+             * @param value The decoded value.
+             */
+            void set(std::string_view key, std::string_view value);
+
+            /*!
+             * Removes every parameter with the specified key.
+             * @param key The decoded key.
+             * @return The number of removed parameters.
+             */
+            size_t remove(std::string_view key);
+
+            void clear() noexcept;
+
+            /*!
+             * Gets the query string.
+             * @return The percent-encoded query, without the '?'.
+             */
+            [[nodiscard]] std::string to_string() const;
+
+            bool operator==(const QueryParameters& other) const;
+
+            bool operator!=(const QueryParameters& other) const;
+        };
+
         /**
          * Based on https://url.spec.whatwg.org
          */
@@ -51,11 +314,18 @@ namespace lambdacommon
             std::string _username;
             std::string _password;
             Address _address;
-            std::map<std::string, std::string> _queries;
+            QueryParameters _queries;
             std::string _fragment;
 
+        private:
+            /*!
+             * Writes the URI, the output is a string or a buffer chain.
+             */
+            template<typename Output>
+            void write(Output& output, char delimiter) const;
+
         public:
-            URI(std::string scheme, std::string username, std::string password, Address address, std::string path = "", const std::map<std::string, std::string>& queries = {},
+            URI(std::string scheme, std::string username, std::string password, Address address, std::string path = "", QueryParameters queries = {},
                 std::string fragment = "");
 
             URI(const URI& uri);
@@ -78,13 +348,25 @@ namespace lambdacommon
 
             void set_address(Address address);
 
-            std::map<std::string, std::string> get_queries() const;
+            const QueryParameters& get_queries() const;
 
-            void set_queries(const std::map<std::string, std::string>& queries);
+            /*!
+             * Gets the query parameters, to modify them in place.
+             * @return The query parameters.
+             */
+            QueryParameters& get_queries();
 
-            bool has_query(const std::string& query) const;
+            void set_queries(QueryParameters queries);
 
-            std::string get_query(const std::string& query) const;
+            bool has_query(std::string_view query) const;
+
+            /*!
+             * Gets the decoded value of the first query parameter with the specified key.
+             * @param query The key of the query parameter.
+             * @return The decoded value.
+             * @throws std::out_of_range If there is no query parameter with this key.
+             */
+            std::string get_query(std::string_view query) const;
 
             const std::string& get_fragment() const;
 
@@ -92,6 +374,13 @@ namespace lambdacommon
 
             std::string to_string(char delimiter = '/') const override;
 
+            /*!
+             * Appends the URI to a buffer chain, its components are appended directly without building an intermediate string.
+             * @param output The buffer chain.
+             * @param delimiter The delimiter of the path.
+             */
+            void serialize(BufferChain& output, char delimiter = '/') const;
+
             /*!
              * Opens the URI in the default assigned application.
              */
@@ -101,13 +390,33 @@ namespace lambdacommon
 
             URI& operator=(URI&& uri) noexcept;
 
-            bool operator==(const URI& uri);
+            /*!
+             * Hashes every component of the URI, equal URIs have the same hash.
+             * @return The hash of the URI.
+             */
+            [[nodiscard]] size_t hash() const;
 
-            bool operator!=(const URI& uri);
+            bool operator==(const URI& uri) const;
+
+            bool operator!=(const URI& uri) const;
 
             URI operator/(const URI& uri);
 
             URI operator/(const AbstractPath& path);
+
+            /*!
+             * Normalizes the URI (RFC 3986, section 6.2.2): see {@code uri::normalize}.
+             * @return The normalized URI.
+             */
+            [[nodiscard]] URI normalize() const;
+
+            /*!
+             * Resolves a reference with this URI as base (RFC 3986, section 5.2).
+             * @param reference The URI reference, absolute or relative.
+             * @return The normalized target URI.
+             * @throws ParseException If the reference is invalid.
+             */
+            [[nodiscard]] URI resolve(std::string_view reference) const;
         };
 
         /**
@@ -118,7 +427,324 @@ namespace lambdacommon
         extern URI LAMBDACOMMON_API from_file_path(fs::path path = fs::current_path());
 
         extern URI LAMBDACOMMON_API from_string(const std::string& uri);
+
+        /*!
+         * URIView
+         *
+         * Represents the components of a parsed URI (RFC 3986), as views into the parsed string: parsing doesn't copy nor allocate anything,
+         * and the string must outlive the view.
+         * The components are not percent-decoded, and an absent component is distinguished from an empty one with the {@code has_*} flags.
+         */
+        struct LAMBDACOMMON_API URIView
+        {
+            /*!
+             * The whole URI.
+             */
+            std::string_view source;
+            std::string_view scheme;
+            std::string_view userinfo;
+            /*!
+             * The host, an IP literal keeps its brackets.
+             */
+            std::string_view host;
+            std::string_view port;
+            std::string_view path;
+            std::string_view query;
+            std::string_view fragment;
+            port_t port_number = 0;
+            bool has_authority = false;
+            bool has_userinfo = false;
+            bool has_query = false;
+            bool has_fragment = false;
+
+            [[nodiscard]] inline SchemeType get_scheme_type() const {
+                return get_scheme_type_by_string(scheme);
+            }
+
+            /*!
+             * Gets the username, which is the userinfo until the first ':'.
+             * @return The username.
+             */
+            [[nodiscard]] std::string_view get_username() const;
+
+            /*!
+             * Gets the password, which is the userinfo after the first ':'.
+             * @return The password.
+             */
+            [[nodiscard]] std::string_view get_password() const;
+
+            /*!
+             * Gets the host without the brackets of an IP literal.
+             * @return The host name.
+             */
+            [[nodiscard]] std::string_view get_host_name() const;
+
+            /*!
+             * Gets the port, or the default port of the scheme if the URI doesn't specify it.
+             * @return The port.
+             */
+            [[nodiscard]] port_t get_port_or_default() const;
+
+            /*!
+             * Copies the components into an URI.
+             * @return The URI.
+             * @throws ParseException If the URI cannot be represented by {@code URI} (userinfo without password, special scheme without host).
+             */
+            [[nodiscard]] URI to_uri() const;
+        };
+
+        /*!
+         * Parses an URI in a single pass without copying it, the syntax of every component is validated.
+         * @param uri The URI to parse.
+         * @return The view of the components of the URI, or an empty optional if the URI is invalid.
+         */
+        extern std::optional<URIView> LAMBDACOMMON_API parse_view(std::string_view uri);
+
+        /*!
+         * Parses an URI reference, which is an URI or a relative reference without scheme (like "../index.html" or "//host/path"), see {@code parse_view}.
+         * @param reference The URI reference to parse.
+         * @return The view of the components of the reference, with an empty scheme if relative, or an empty optional if the reference is invalid.
+         */
+        extern std::optional<URIView> LAMBDACOMMON_API parse_reference_view(std::string_view reference);
+
+        /*!
+         * Removes the "." and ".." segments of a path in place (RFC 3986, section 5.2.4).
+         * @param path The path.
+         * @param size The size of the path.
+         * @return The size of the resulting path.
+         */
+        extern size_t LAMBDACOMMON_API remove_dot_segments(char* path, size_t size);
+
+        /*!
+         * Removes the "." and ".." segments of a path (RFC 3986, section 5.2.4).
+         * @param path The path.
+         * @return The resulting path.
+         */
+        extern std::string LAMBDACOMMON_API remove_dot_segments(std::string_view path);
+
+        /*!
+         * Normalizes an URI (RFC 3986, section 6.2.2), equivalent URIs have the same normalized form:
+         * the scheme and the host are lowercased, the percent-encoded sequences are uppercased and the unreserved characters are decoded,
+         * the dot segments are removed, an empty path becomes "/" and the default port of the scheme is removed.
+         * @param uri The URI to normalize.
+         * @return The normalized URI, or an empty optional if the URI is invalid.
+         */
+        extern std::optional<std::string> LAMBDACOMMON_API normalize(std::string_view uri);
+
+        /*!
+         * Resolves an URI reference against a base URI (RFC 3986, section 5.2).
+         * @param base The absolute base URI.
+         * @param reference The URI reference, absolute or relative.
+         * @return The normalized target URI, or an empty optional if the base or the reference is invalid.
+         */
+        extern std::optional<std::string> LAMBDACOMMON_API resolve(std::string_view base, std::string_view reference);
+
+        /*!
+         * URIResolver
+         *
+         * Resolves URI references and remembers the normalized form of the recent base URIs, as the references of a page share the same base.
+         * A resolver is not thread-safe, use one resolver per thread.
+         */
+        class LAMBDACOMMON_API URIResolver
+        {
+        private:
+            struct Base
+            {
+                std::string normalized;
+                URIView view;
+            };
+
+            size_t _capacity;
+            std::unordered_map<std::string, Base> _bases;
+            std::string _key;
+            u64 _hits = 0;
+            u64 _misses = 0;
+
+        public:
+            /*!
+             * Creates a resolver.
+             * @param capacity The maximum number of remembered base URIs, the resolver forgets every base when it is reached.
+             */
+            explicit URIResolver(size_t capacity = 1024);
+
+            // The views of the remembered bases point into their normalized strings, which a copy wouldn't share.
+            URIResolver(const URIResolver& other) = delete;
+
+            URIResolver(URIResolver&& other) = default;
+
+            URIResolver& operator=(const URIResolver& other) = delete;
+
+            URIResolver& operator=(URIResolver&& other) = default;
+
+            /*!
+             * Resolves an URI reference against a base URI, see {@code uri::resolve}.
+             * @param base The absolute base URI.
+             * @param reference The URI reference, absolute or relative.
+             * @return The normalized target URI, or an empty optional if the base or the reference is invalid.
+             */
+            std::optional<std::string> resolve(std::string_view base, std::string_view reference);
+
+            /*!
+             * Gets the number of resolutions which found their base URI already normalized.
+             * @return The number of hits.
+             */
+            [[nodiscard]] u64 get_hits() const;
+
+            /*!
+             * Gets the number of resolutions which normalized their base URI.
+             * @return The number of misses.
+             */
+            [[nodiscard]] u64 get_misses() const;
+
+            /*!
+             * Forgets every base URI.
+             */
+            void clear();
+        };
+
+        /*!
+         * CompactURI
+         *
+         * Represents an URI stored as its serialization in a single buffer, the components are located with 16-bit offsets:
+         * copying an URI is a single allocation (none if the serialization fits in the small string buffer),
+         * the serialization is free and the components are views into the buffer.
+         * The components are not percent-decoded, like {@code URIView}.
+         */
+        class LAMBDACOMMON_API CompactURI
+        {
+        private:
+            std::string _serialization;
+            u16 _scheme_end = 0;
+            u16 _host_start = 0;
+            u16 _host_end = 0;
+            u16 _path_start = 0;
+            u16 _path_end = 0;
+            u16 _query_end = 0;
+            port_t _port_number = 0;
+            u8 _flags = 0;
+
+            CompactURI(std::string serialization, const URIView& view);
+
+            /*!
+             * Copies the offsets of an URI, with an empty serialization of the given capacity.
+             */
+            CompactURI(const CompactURI& other, size_t capacity);
+
+        public:
+            /*!
+             * The maximum size of the serialization of a compact URI.
+             */
+            static constexpr size_t MAX_SIZE = 0xFFFF;
+
+            /*!
+             * Creates a compact URI from an URI.
+             * @param uri The URI.
+             * @throws ParseException If the serialization of the URI is invalid or longer than {@code MAX_SIZE}.
+             */
+            explicit CompactURI(const URI& uri);
+
+            /*!
+             * Parses an URI into a compact URI, see {@code parse_view}.
+             * @param uri The URI to parse.
+             * @return The compact URI, or an empty optional if the URI is invalid or longer than {@code MAX_SIZE}.
+             */
+            static std::optional<CompactURI> parse(std::string_view uri);
+
+            [[nodiscard]] std::string_view get_scheme() const;
+
+            [[nodiscard]] inline SchemeType get_scheme_type() const {
+                return get_scheme_type_by_string(get_scheme());
+            }
+
+            [[nodiscard]] std::string_view get_userinfo() const;
+
+            [[nodiscard]] std::string_view get_username() const;
+
+            [[nodiscard]] std::string_view get_password() const;
+
+            /*!
+             * Gets the host, an IP literal keeps its brackets.
+             * @return The host.
+             */
+            [[nodiscard]] std::string_view get_host() const;
+
+            /*!
+             * Gets the host without the brackets of an IP literal.
+             * @return The host name.
+             */
+            [[nodiscard]] std::string_view get_host_name() const;
+
+            [[nodiscard]] port_t get_port() const;
+
+            /*!
+             * Gets the port, or the default port of the scheme if the URI doesn't specify it.
+             * @return The port.
+             */
+            [[nodiscard]] port_t get_port_or_default() const;
+
+            [[nodiscard]] std::string_view get_path() const;
+
+            [[nodiscard]] std::string_view get_query() const;
+
+            [[nodiscard]] std::string_view get_fragment() const;
+
+            [[nodiscard]] bool has_authority() const;
+
+            [[nodiscard]] bool has_query() const;
+
+            [[nodiscard]] bool has_fragment() const;
+
+            /*!
+             * Gets the view of the components of the URI, valid as long as this URI is not modified nor destroyed.
+             * @return The view.
+             */
+            [[nodiscard]] URIView get_view() const;
+
+            /*!
+             * Copies the components into an URI.
+             * @return The URI.
+             * @throws ParseException If the URI cannot be represented by {@code URI}, see {@code URIView::to_uri}.
+             */
+            [[nodiscard]] URI to_uri() const;
+
+            [[nodiscard]] const std::string& to_string() const;
+
+            [[nodiscard]] size_t size() const;
+
+            [[nodiscard]] size_t hash() const;
+
+            bool operator==(const CompactURI& other) const;
+
+            bool operator!=(const CompactURI& other) const;
+
+            /*!
+             * Appends a segment to the path, the segment is percent-encoded.
+             * @param segment The segment to append.
+             * @return The new URI.
+             * @throws std::length_error If the new URI is longer than {@code MAX_SIZE}.
+             */
+            CompactURI operator/(std::string_view segment) const;
+        };
     }
 }
 
+namespace std
+{
+    template<>
+    struct hash<lambdacommon::uri::URI>
+    {
+        size_t operator()(const lambdacommon::uri::URI& uri) const noexcept {
+            return uri.hash();
+        }
+    };
+
+    template<>
+    struct hash<lambdacommon::uri::CompactURI>
+    {
+        size_t operator()(const lambdacommon::uri::CompactURI& uri) const noexcept {
+            return uri.hash();
+        }
+    };
+}
+
 #endif //LAMBDACOMMON_URL_H
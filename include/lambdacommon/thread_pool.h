@@ -0,0 +1,101 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef LAMBDACOMMON_THREAD_POOL_H
+#define LAMBDACOMMON_THREAD_POOL_H
+
+#include "lambdacommon.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef LAMBDA_WINDOWS
+#  pragma warning(push)
+#  pragma warning(disable:4251)
+#endif
+
+namespace lambdacommon
+{
+    /*!
+     * ThreadPool
+     *
+     * Represents a fixed number of worker threads executing tasks from a bounded queue.
+     * Submitting a task blocks while the queue is full, which bounds the memory used by pending tasks.
+     * The destructor executes the pending tasks then joins the threads.
+     */
+    class LAMBDACOMMON_API ThreadPool
+    {
+    private:
+        std::vector<std::thread> _threads;
+        std::deque<std::function<void()>> _tasks;
+        size_t _max_pending;
+        mutable std::mutex _mutex;
+        std::condition_variable _task_available;
+        std::condition_variable _space_available;
+        bool _stopping = false;
+
+        void work();
+
+    public:
+        /*!
+         * Creates a thread pool.
+         * @param threads The number of threads, 0 to use the number of hardware threads.
+         * @param max_pending The maximum number of pending tasks.
+         */
+        explicit ThreadPool(size_t threads = 0, size_t max_pending = 1024);
+
+        ThreadPool(const ThreadPool& other) = delete;
+
+        ~ThreadPool();
+
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+
+        /*!
+         * Gets the number of threads of the pool.
+         * @return The number of threads.
+         */
+        [[nodiscard]] size_t get_thread_count() const;
+
+        /*!
+         * Gets the number of tasks waiting for a thread.
+         * @return The number of pending tasks.
+         */
+        [[nodiscard]] size_t get_pending_count() const;
+
+        /*!
+         * Submits a task, blocks while the queue is full.
+         * Exceptions thrown by the task are ignored, use submit_future to get them.
+         * @param task The task.
+         */
+        void submit(std::function<void()> task);
+
+        /*!
+         * Submits a task and returns a future of its result.
+         * @param task The task.
+         * @return The future of the result of the task.
+         */
+        template<typename F>
+        auto submit_future(F&& task) -> std::future<decltype(task())> {
+            auto packaged = std::make_shared<std::packaged_task<decltype(task())()>>(std::forward<F>(task));
+            auto future = packaged->get_future();
+            submit([packaged]() { (*packaged)(); });
+            return future;
+        }
+    };
+}
+
+#ifdef LAMBDA_WINDOWS
+#  pragma warning(pop)
+#endif
+
+#endif //LAMBDACOMMON_THREAD_POOL_H
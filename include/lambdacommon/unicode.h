@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef LAMBDACOMMON_UNICODE_H
+#define LAMBDACOMMON_UNICODE_H
+
+#include "lambdacommon.h"
+#include "types.h"
+#include <optional>
+#include <string_view>
+
+/*
+ * Unicode transcoding between UTF-8, UTF-16, UTF-32 and std::wstring.
+ *
+ * Every conversion fully validates its input (overlong sequences, surrogates and code points above U+10FFFF are rejected) and reports the position of the first error.
+ * The conversions into caller buffers never allocate, the allocating ones precompute the output length so they allocate exactly once.
+ * Runs of ASCII are converted 16 bytes at a time with SSE2 when available.
+ */
+namespace lambdacommon::unicode
+{
+    /*!
+     * Represents the error found while transcoding.
+     */
+    enum class ErrorType : u8
+    {
+        NONE,
+        /*!
+         * The input ends in the middle of a sequence.
+         */
+        TRUNCATED,
+        /*!
+         * Invalid leading byte or invalid continuation byte (or unpaired surrogate in UTF-16).
+         */
+        INVALID_SEQUENCE,
+        /*!
+         * The code point is encoded with more bytes than needed (UTF-8 only).
+         */
+        OVERLONG,
+        /*!
+         * The code point is a surrogate (U+D800 to U+DFFF), which cannot be encoded in UTF-8 or UTF-32.
+         */
+        SURROGATE,
+        /*!
+         * The code point is greater than U+10FFFF.
+         */
+        TOO_LARGE,
+        /*!
+         * The output buffer is too small, the conversion stopped before the end of the input.
+         */
+        OUTPUT_TOO_SMALL
+    };
+
+    /*!
+     * Represents the result of a validation or a conversion.
+     */
+    struct TranscodeResult
+    {
+        ErrorType error;
+        /*!
+         * The position of the first error in the input (in code units), or the size of the input if successful.
+         */
+        size_t position;
+        /*!
+         * The number of code units written in the output.
+         */
+        size_t written;
+
+        [[nodiscard]] inline bool ok() const {
+            return error == ErrorType::NONE;
+        }
+    };
+
+    /*
+     * Validation
+     */
+
+    extern TranscodeResult LAMBDACOMMON_API validate_utf8(std::string_view input);
+
+    extern TranscodeResult LAMBDACOMMON_API validate_utf16(std::u16string_view input);
+
+    extern TranscodeResult LAMBDACOMMON_API validate_utf32(std::u32string_view input);
+
+    /*
+     * Length precomputation, those functions expect valid input and don't validate it.
+     */
+
+    /*!
+     * Counts the code points of a valid UTF-8 string, which is also its length in UTF-32.
+     * @param input The UTF-8 string.
+     * @return The number of code points.
+     */
+    extern size_t LAMBDACOMMON_API utf32_length_from_utf8(std::string_view input);
+
+    extern size_t LAMBDACOMMON_API utf16_length_from_utf8(std::string_view input);
+
+    extern size_t LAMBDACOMMON_API utf8_length_from_utf16(std::u16string_view input);
+
+    extern size_t LAMBDACOMMON_API utf8_length_from_utf32(std::u32string_view input);
+
+    /*
+     * Conversions into caller buffers.
+     *
+     * The conversion stops at the first error, the output contains the code units converted before it.
+     */
+
+    extern TranscodeResult LAMBDACOMMON_API convert_utf8_to_utf32(std::string_view input, char32_t* output, size_t capacity);
+
+    extern TranscodeResult LAMBDACOMMON_API convert_utf8_to_utf16(std::string_view input, char16_t* output, size_t capacity);
+
+    extern TranscodeResult LAMBDACOMMON_API convert_utf16_to_utf8(std::u16string_view input, char* output, size_t capacity);
+
+    extern TranscodeResult LAMBDACOMMON_API convert_utf32_to_utf8(std::u32string_view input, char* output, size_t capacity);
+
+    /*
+     * Allocating conversions, they return an empty optional if the input is invalid.
+     */
+
+    extern std::optional<std::u32string> LAMBDACOMMON_API utf8_to_utf32(std::string_view input);
+
+    extern std::optional<std::u16string> LAMBDACOMMON_API utf8_to_utf16(std::string_view input);
+
+    extern std::optional<std::string> LAMBDACOMMON_API utf16_to_utf8(std::u16string_view input);
+
+    extern std::optional<std::string> LAMBDACOMMON_API utf32_to_utf8(std::u32string_view input);
+
+    /*!
+     * Converts an UTF-8 string to a wide string (UTF-16 if wchar_t is 16-bit like on Windows, else UTF-32).
+     * @param input The UTF-8 string.
+     * @return The wide string if the input is valid, else an empty optional.
+     */
+    extern std::optional<std::wstring> LAMBDACOMMON_API utf8_to_wstring(std::string_view input);
+
+    /*!
+     * Converts a wide string (UTF-16 if wchar_t is 16-bit like on Windows, else UTF-32) to an UTF-8 string.
+     * @param input The wide string.
+     * @return The UTF-8 string if the input is valid, else an empty optional.
+     */
+    extern std::optional<std::string> LAMBDACOMMON_API wstring_to_utf8(std::wstring_view input);
+}
+
+#endif //LAMBDACOMMON_UNICODE_H
@@ -0,0 +1,480 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../include/lambdacommon/buffer.h"
+#include <algorithm>
+#include <cstring>
+
+#ifndef LAMBDA_WINDOWS
+#  include <sys/uio.h>
+#endif
+
+namespace lambdacommon
+{
+    /*
+     * The maximum number of vectors of a scatter/gather system call.
+     */
+    constexpr size_t MAX_IO_VECTORS = 64;
+
+    /*
+     * Buffer block
+     */
+
+    BufferBlock::BufferBlock(size_t capacity) : _data(std::make_unique<char[]>(capacity)), _capacity(capacity) {}
+
+    size_t BufferBlock::claim(size_t offset, size_t count) {
+        count = std::min(count, _capacity - offset);
+        if (count == 0 || !_used.compare_exchange_strong(offset, offset + count))
+            return 0;
+        return count;
+    }
+
+    char* BufferBlock::data() const {
+        return _data.get();
+    }
+
+    size_t BufferBlock::capacity() const {
+        return _capacity;
+    }
+
+    /*
+     * Block pool
+     */
+
+    BlockPool::BlockPool(size_t block_size, size_t max_free) : _state(std::make_shared<State>()) {
+        _state->block_size = std::max<size_t>(block_size, 1);
+        _state->max_free = max_free;
+    }
+
+    std::shared_ptr<BufferBlock> BlockPool::acquire(const std::shared_ptr<State>& state) {
+        std::unique_ptr<BufferBlock> block;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->free.empty()) {
+                block = std::move(state->free.back());
+                state->free.pop_back();
+            }
+        }
+        if (!block) {
+            block = std::make_unique<BufferBlock>(state->block_size);
+            state->allocations++;
+        }
+
+        // The block goes back to the pool once released, the state is kept alive in case the pool is destroyed first.
+        return {block.release(), [state](BufferBlock* released) {
+            released->_used = 0;
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if (state->free.size() < state->max_free)
+                state->free.emplace_back(released);
+            else {
+                lock.unlock();
+                delete released;
+            }
+        }};
+    }
+
+    std::shared_ptr<BufferBlock> BlockPool::acquire() {
+        return acquire(_state);
+    }
+
+    size_t BlockPool::get_block_size() const {
+        return _state->block_size;
+    }
+
+    size_t BlockPool::get_free_count() const {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        return _state->free.size();
+    }
+
+    u64 BlockPool::get_allocation_count() const {
+        return _state->allocations;
+    }
+
+    BlockPool& BlockPool::get_default() {
+        static BlockPool pool;
+        return pool;
+    }
+
+    /*
+     * Buffer chain
+     */
+
+    BufferChain::BufferChain() : BufferChain(BlockPool::get_default()) {}
+
+    BufferChain::BufferChain(BlockPool& pool) : _pool(pool._state) {}
+
+    BufferChain::BufferChain(std::shared_ptr<BlockPool::State> pool) : _pool(std::move(pool)) {}
+
+    // The prepared blocks are not shared, they are filled by a single chain.
+    BufferChain::BufferChain(const BufferChain& other) : _pool(other._pool), _slices(other._slices.begin() + other._first, other._slices.end()), _size(other._size) {}
+
+    // The pool is copied, the moved chain stays usable.
+    BufferChain::BufferChain(BufferChain&& other) noexcept
+            : _pool(other._pool), _slices(std::move(other._slices)), _first(other._first), _size(other._size), _reserved(std::move(other._reserved)),
+              _reserved_tail(other._reserved_tail) {
+        other._slices.clear();
+        other._first = 0;
+        other._size = 0;
+        other._reserved_tail = 0;
+    }
+
+    BufferChain& BufferChain::operator=(const BufferChain& other) {
+        if (this != &other) {
+            _pool = other._pool;
+            _slices.assign(other._slices.begin() + other._first, other._slices.end());
+            _first = 0;
+            _size = other._size;
+            _reserved.clear();
+            _reserved_tail = 0;
+        }
+        return *this;
+    }
+
+    BufferChain& BufferChain::operator=(BufferChain&& other) noexcept {
+        if (this != &other) {
+            _pool = other._pool;
+            _slices = std::move(other._slices);
+            _first = other._first;
+            _size = other._size;
+            _reserved = std::move(other._reserved);
+            _reserved_tail = other._reserved_tail;
+            other._slices.clear();
+            other._first = 0;
+            other._size = 0;
+            other._reserved_tail = 0;
+        }
+        return *this;
+    }
+
+    void BufferChain::push(Slice slice) {
+        if (slice.size == 0)
+            return;
+        // Merges the slice with the previous one if they are contiguous, as after splitting then appending back.
+        if (_first < _slices.size()) {
+            auto& last = _slices.back();
+            if (last.owner == slice.owner && last.data + last.size == slice.data) {
+                last.size += slice.size;
+                _size += slice.size;
+                return;
+            }
+        }
+        // Removes the consumed slices once they are the majority, so a queue which is never fully drained doesn't grow.
+        if (_first >= 32 && _first * 2 >= _slices.size()) {
+            _slices.erase(_slices.begin(), _slices.begin() + static_cast<std::ptrdiff_t>(_first));
+            _first = 0;
+        }
+        _size += slice.size;
+        _slices.push_back(std::move(slice));
+    }
+
+    void BufferChain::pop_front() {
+        // Releases the bytes now.
+        _slices[_first].owner.reset();
+        if (++_first == _slices.size()) {
+            _slices.clear();
+            _first = 0;
+        }
+    }
+
+    void BufferChain::append(std::string_view data) {
+        // Fills the free bytes of the last block if no other chain appended to it.
+        if (_first < _slices.size() && _slices.back().block && !data.empty()) {
+            auto& last = _slices.back();
+            auto count = last.block->claim(static_cast<size_t>(last.data + last.size - last.block->data()), data.size());
+            std::memcpy(const_cast<char*>(last.data) + last.size, data.data(), count);
+            last.size += count;
+            _size += count;
+            data.remove_prefix(count);
+        }
+
+        while (!data.empty()) {
+            auto block = BlockPool::acquire(_pool);
+            auto count = block->claim(0, data.size());
+            std::memcpy(block->data(), data.data(), count);
+            auto raw_block = block.get();
+            push({std::move(block), raw_block->data(), count, raw_block});
+            data.remove_prefix(count);
+        }
+    }
+
+    void BufferChain::append(const BufferChain& other) {
+        if (this == &other) {
+            append(BufferChain(other));
+            return;
+        }
+        for (auto it = other._slices.begin() + other._first; it != other._slices.end(); ++it)
+            push(*it);
+    }
+
+    void BufferChain::append(BufferChain&& other) {
+        if (empty()) {
+            _slices = std::move(other._slices);
+            _first = other._first;
+            _size = other._size;
+        } else {
+            for (auto it = other._slices.begin() + other._first; it != other._slices.end(); ++it)
+                push(*it);
+        }
+        other._slices.clear();
+        other._first = 0;
+        other._size = 0;
+    }
+
+    void BufferChain::append_shared(std::shared_ptr<const void> owner, std::string_view bytes) {
+        push({std::move(owner), bytes.data(), bytes.size(), nullptr});
+    }
+
+    BufferChain BufferChain::split(size_t count) {
+        BufferChain result{_pool};
+        count = std::min(count, _size);
+        while (count > 0) {
+            auto& first = _slices[_first];
+            if (count < first.size) {
+                // The slice is shared by both chains.
+                result._slices.push_back({first.owner, first.data, count, first.block});
+                result._size += count;
+                first.data += count;
+                first.size -= count;
+                _size -= count;
+                break;
+            }
+            count -= first.size;
+            _size -= first.size;
+            result._size += first.size;
+            result._slices.push_back(std::move(first));
+            pop_front();
+        }
+        return result;
+    }
+
+    void BufferChain::consume(size_t count) {
+        count = std::min(count, _size);
+        _size -= count;
+        while (count > 0) {
+            auto& first = _slices[_first];
+            if (count < first.size) {
+                first.data += count;
+                first.size -= count;
+                break;
+            }
+            count -= first.size;
+            pop_front();
+        }
+    }
+
+    BufferChain BufferChain::slice(size_t offset, size_t count) const {
+        BufferChain result{_pool};
+        offset = std::min(offset, _size);
+        count = std::min(count, _size - offset);
+        for (auto it = _slices.begin() + _first; it != _slices.end() && count > 0; ++it) {
+            if (offset >= it->size) {
+                offset -= it->size;
+                continue;
+            }
+            auto size = std::min(it->size - offset, count);
+            result._slices.push_back({it->owner, it->data + offset, size, it->block});
+            result._size += size;
+            count -= size;
+            offset = 0;
+        }
+        return result;
+    }
+
+    void BufferChain::clear() {
+        _slices.clear();
+        _first = 0;
+        _size = 0;
+    }
+
+    size_t BufferChain::size() const {
+        return _size;
+    }
+
+    bool BufferChain::empty() const {
+        return _size == 0;
+    }
+
+    size_t BufferChain::get_slice_count() const {
+        return _slices.size() - _first;
+    }
+
+    std::string_view BufferChain::get_slice(size_t index) const {
+        const auto& slice = _slices[_first + index];
+        return {slice.data, slice.size};
+    }
+
+    std::string_view BufferChain::front() const {
+        if (_first == _slices.size())
+            return {};
+        return get_slice(0);
+    }
+
+    std::string_view BufferChain::linearize() {
+        if (get_slice_count() > 1) {
+            if (_size <= _pool->block_size) {
+                auto block = BlockPool::acquire(_pool);
+                block->claim(0, _size);
+                copy_to(block->data(), _size);
+                auto raw_block = block.get();
+                auto size = _size;
+                clear();
+                _slices.push_back({std::move(block), raw_block->data(), size, raw_block});
+                _size = size;
+            } else {
+                auto content = std::make_shared<std::string>(to_string());
+                clear();
+                append_shared(content, *content);
+            }
+        }
+        return front();
+    }
+
+    size_t BufferChain::copy_to(char* buffer, size_t size, size_t offset) const {
+        size_t copied = 0;
+        for (auto it = _slices.begin() + _first; it != _slices.end() && copied < size; ++it) {
+            if (offset >= it->size) {
+                offset -= it->size;
+                continue;
+            }
+            auto count = std::min(it->size - offset, size - copied);
+            std::memcpy(buffer + copied, it->data + offset, count);
+            copied += count;
+            offset = 0;
+        }
+        return copied;
+    }
+
+    std::string BufferChain::to_string() const {
+        std::string result(_size, '\0');
+        copy_to(result.data(), _size);
+        return result;
+    }
+
+    bool BufferChain::operator==(const BufferChain& other) const {
+        if (_size != other._size)
+            return false;
+        // Compares the overlapping parts of the slices of both chains.
+        auto it = _slices.begin() + _first, other_it = other._slices.begin() + other._first;
+        size_t offset = 0, other_offset = 0;
+        while (it != _slices.end()) {
+            auto count = std::min(it->size - offset, other_it->size - other_offset);
+            if (std::memcmp(it->data + offset, other_it->data + other_offset, count) != 0)
+                return false;
+            offset += count;
+            other_offset += count;
+            if (offset == it->size) {
+                ++it;
+                offset = 0;
+            }
+            if (other_offset == other_it->size) {
+                ++other_it;
+                other_offset = 0;
+            }
+        }
+        return true;
+    }
+
+    bool BufferChain::operator!=(const BufferChain& other) const {
+        return !(*this == other);
+    }
+
+    bool BufferChain::operator==(std::string_view other) const {
+        if (_size != other.size())
+            return false;
+        for (auto slice = _slices.begin() + _first; slice != _slices.end(); ++slice) {
+            if (std::memcmp(slice->data, other.data(), slice->size) != 0)
+                return false;
+            other.remove_prefix(slice->size);
+        }
+        return true;
+    }
+
+    bool BufferChain::operator!=(std::string_view other) const {
+        return !(*this == other);
+    }
+
+#ifndef LAMBDA_WINDOWS
+    size_t BufferChain::export_iovec(iovec* vectors, size_t max_vectors) const {
+        size_t count = std::min(max_vectors, get_slice_count());
+        for (size_t i = 0; i < count; i++) {
+            vectors[i].iov_base = const_cast<char*>(_slices[_first + i].data);
+            vectors[i].iov_len = _slices[_first + i].size;
+        }
+        return count;
+    }
+
+    size_t BufferChain::prepare(iovec* vectors, size_t max_vectors, size_t size) {
+        size_t count = 0;
+        _reserved_tail = 0;
+        if (max_vectors > 0 && _first < _slices.size() && _slices.back().block) {
+            auto& last = _slices.back();
+            _reserved_tail = last.block->claim(static_cast<size_t>(last.data + last.size - last.block->data()), size);
+            if (_reserved_tail > 0) {
+                vectors[count].iov_base = const_cast<char*>(last.data) + last.size;
+                vectors[count++].iov_len = _reserved_tail;
+                size -= _reserved_tail;
+            }
+        }
+
+        _reserved.clear();
+        while (size > 0 && count < max_vectors) {
+            auto block = BlockPool::acquire(_pool);
+            auto claimed = block->claim(0, size);
+            vectors[count].iov_base = block->data();
+            vectors[count++].iov_len = claimed;
+            size -= claimed;
+            _reserved.push_back(std::move(block));
+        }
+        return count;
+    }
+
+    void BufferChain::commit(size_t count) {
+        // The prepared bytes which were not filled become free again.
+        if (_reserved_tail > 0) {
+            auto& last = _slices.back();
+            auto filled = std::min(count, _reserved_tail);
+            last.size += filled;
+            _size += filled;
+            last.block->_used = static_cast<size_t>(last.data + last.size - last.block->data());
+            count -= filled;
+            _reserved_tail = 0;
+        }
+        for (auto& block : _reserved) {
+            if (count == 0)
+                break;
+            auto filled = std::min(count, static_cast<size_t>(block->_used));
+            block->_used = filled;
+            auto raw_block = block.get();
+            _slices.push_back({std::move(block), raw_block->data(), filled, raw_block});
+            _size += filled;
+            count -= filled;
+        }
+        _reserved.clear();
+    }
+
+    long BufferChain::write_to(int fd) {
+        iovec vectors[MAX_IO_VECTORS];
+        auto count = export_iovec(vectors, MAX_IO_VECTORS);
+        if (count == 0)
+            return 0;
+        auto written = ::writev(fd, vectors, static_cast<int>(count));
+        if (written > 0)
+            consume(static_cast<size_t>(written));
+        return static_cast<long>(written);
+    }
+
+    long BufferChain::read_from(int fd, size_t size) {
+        iovec vectors[MAX_IO_VECTORS];
+        auto count = prepare(vectors, MAX_IO_VECTORS, size);
+        auto received = count == 0 ? 0 : ::readv(fd, vectors, static_cast<int>(count));
+        commit(received > 0 ? static_cast<size_t>(received) : 0);
+        return static_cast<long>(received);
+    }
+#endif
+}
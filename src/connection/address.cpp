@@ -8,7 +8,13 @@
  */
 
 #include "../../include/lambdacommon/connection/address.h"
-#include <sstream>
+#include "../../include/lambdacommon/connection/resolver.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
 #include <tuple>
 #include <utility>
 
@@ -16,20 +22,512 @@
 #  include <WS2tcpip.h>
 #  pragma comment(lib, "Ws2_32.lib")
 #else
-#  ifdef LAMBDA_BSD
-#    include <netinet/in.h>
-#    include <sys/socket.h>
-#  endif
+#  include <netinet/in.h>
+#  include <sys/socket.h>
 #  include <arpa/inet.h>
 #endif
 
 namespace lambdacommon
 {
-    Address::Address(host host, port_t port) : _host(std::move(host)), _port(port) {}
+    /*
+     * The built-in list of top-level domains, lowercase and sorted for the binary search.
+     */
+    constexpr std::string_view TOP_LEVEL_DOMAINS[] = {
+            "aaa", "aarp", "abarth", "abb", "abbott", "abbvie", "abc", "able", "abogado", "abudhabi", "ac", "academy", "accenture", "accountant",
+            "accountants", "acer", "aco", "active", "actor", "ad", "adac", "ads", "adult", "ae", "aeg", "aero", "aetna", "af", "afamilycompany",
+            "afl", "africa", "africamagic", "ag", "agakhan", "agency", "ai", "aig", "aigo", "airbus", "airforce", "airtel", "akdn", "al", "alcon",
+            "alfaromeo", "alibaba", "alipay", "allfinanz", "allfinanzberater", "allfinanzberatung", "allstate", "ally", "alsace", "alstom", "am",
+            "amazon", "americanexpress", "americanfamily", "amex", "amfam", "amica", "amp", "amsterdam", "an", "analytics", "and", "android",
+            "anquan", "ansons", "anthem", "antivirus", "ao", "aol", "apartments", "app", "apple", "aq", "aquarelle", "aquitaine", "ar", "arab",
+            "aramco", "archi", "architect", "are", "army", "arpa", "art", "arte", "as", "asda", "asia", "associates", "astrium", "at", "athleta",
+            "attorney", "au", "auction", "audi", "audible", "audio", "auspost", "author", "auto", "autoinsurance", "autos", "avery", "avianca", "aw",
+            "ax", "axa", "axis", "az", "azure", "ba", "baby", "baidu", "banamex", "bananarepublic", "band", "bank", "banque", "bar", "barcelona",
+            "barclaycard", "barclays", "barefoot", "bargains", "baseball", "basketball", "bauhaus", "bayern", "bb", "bbb", "bbc", "bbt", "bbva",
+            "bcg", "bcn", "bd", "be", "beats", "beauty", "beer", "beknown", "bentley", "berlin", "best", "bestbuy", "bet", "bf", "bg", "bh", "bharti",
+            "bi", "bible", "bid", "bike", "bing", "bingo", "bio", "biz", "bj", "bl", "black", "blackfriday", "blanco", "blockbuster", "blog",
+            "bloomberg", "bloomingdales", "blue", "bm", "bms", "bmw", "bn", "bnl", "bnpparibas", "bo", "boats", "boehringer", "bofa", "bom", "bond",
+            "boo", "book", "booking", "boots", "bosch", "bostik", "boston", "bot", "boutique", "box", "bq", "br", "bradesco", "bridgestone",
+            "broadway", "broker", "brother", "brussels", "bs", "bt", "budapest", "bugatti", "buick", "build", "builders", "business", "buy", "buzz",
+            "bv", "bw", "bway", "by", "bz", "bzh", "ca", "cab", "cadillac", "cafe", "cal", "call", "calvinklein", "cam", "camera", "camp",
+            "canalplus", "cancerresearch", "canon", "capetown", "capital", "capitalone", "caravan", "cards", "care", "career", "careers", "caremore",
+            "carinsurance", "cars", "cartier", "casa", "case", "caseih", "cash", "cashbackbonus", "casino", "cat", "catalonia", "catering",
+            "catholic", "cba", "cbn", "cbre", "cbs", "cc", "cd", "ceb", "center", "ceo", "cern", "cf", "cfa", "cfd", "cg", "ch", "chanel",
+            "changiairport", "channel", "charity", "chartis", "chase", "chat", "chatr", "cheap", "chesapeake", "chevrolet", "chevy", "chintai", "chk",
+            "chloe", "christmas", "chrome", "chrysler", "church", "ci", "cialis", "cimb", "cipriani", "circle", "cisco", "citadel", "citi", "citic",
+            "city", "cityeats", "ck", "cl", "claims", "cleaning", "click", "clinic", "clinique", "clothing", "club", "clubmed", "cm", "cn", "co",
+            "coach", "codes", "coffee", "college", "cologne", "com", "comcast", "commbank", "community", "company", "compare", "computer", "comsec",
+            "condos", "connectors", "construction", "consulting", "contact", "contractors", "cooking", "cookingchannel", "cool", "coop", "corsica",
+            "country", "coupon", "coupons", "courses", "cr", "credit", "creditcard", "creditunion", "cricket", "crown", "crs", "cruise", "cruises",
+            "csc", "cu", "cuisinella", "cv", "cw", "cx", "cy", "cymru", "cyou", "cz", "dabur", "dad", "dance", "data", "date", "dating", "datsun",
+            "day", "dclk", "dds", "de", "deal", "dealer", "deals", "degree", "delivery", "dell", "delmonte", "deloitte", "delta", "democrat",
+            "dental", "dentist", "desi", "design", "deutschepost", "dhl", "diamonds", "diet", "digikey", "digital", "direct", "directory", "discount",
+            "discover", "dish", "diy", "dj", "dk", "dm", "dnb", "dnp", "do", "docomo", "docs", "doctor", "dodge", "dog", "doha", "domains", "doosan",
+            "dot", "dotafrica", "download", "drive", "dstv", "dtv", "dubai", "duck", "dunlop", "duns", "dupont", "durban", "dvag", "dvr", "dwg", "dz",
+            "earth", "eat", "ec", "eco", "ecom", "edeka", "edu", "education", "ee", "eg", "eh", "email", "emerck", "emerson", "energy", "engineer",
+            "engineering", "enterprises", "epost", "epson", "equipment", "er", "ericsson", "erni", "es", "esq", "est", "estate", "esurance", "et",
+            "etisalat", "eu", "eurovision", "eus", "events", "everbank", "exchange", "expert", "exposed", "express", "extraspace", "fage", "fail",
+            "fairwinds", "faith", "family", "fan", "fans", "farm", "farmers", "fashion", "fast", "fedex", "feedback", "ferrari", "ferrero", "fi",
+            "fiat", "fidelity", "fido", "film", "final", "finance", "financial", "financialaid", "finish", "fire", "firestone", "firmdale", "fish",
+            "fishing", "fitness", "fj", "fk", "flickr", "flights", "flir", "florist", "flowers", "fls", "flsmidth", "fly", "fm", "fo", "foo", "food",
+            "foodnetwork", "football", "ford", "forex", "forsale", "forum", "foundation", "fox", "fr", "free", "fresenius", "frl", "frogans",
+            "frontdoor", "frontier", "ftr", "fujitsu", "fujixerox", "fun", "fund", "furniture", "futbol", "fyi", "ga", "gai", "gal", "gallery",
+            "gallo", "gallup", "game", "games", "gap", "garden", "garnier", "gay", "gb", "gbiz", "gcc", "gd", "gdn", "ge", "gea", "gecompany", "ged",
+            "gent", "genting", "george", "gf", "gg", "ggee", "gh", "gi", "gift", "gifts", "gives", "giving", "gl", "glade", "glass", "gle", "glean",
+            "global", "globalx", "globo", "gm", "gmail", "gmbh", "gmc", "gmo", "gmx", "gn", "godaddy", "gold", "goldpoint", "golf", "goo",
+            "goodhands", "goodyear", "goog", "google", "gop", "got", "gotv", "gov", "gp", "gq", "gr", "grainger", "graphics", "gratis", "gree",
+            "green", "gripe", "grocery", "group", "gs", "gt", "gu", "guardian", "guardianlife", "guardianmedia", "gucci", "guge", "guide", "guitars",
+            "guru", "gw", "gy", "hair", "halal", "hamburg", "hangout", "haus", "hbo", "hdfc", "hdfcbank", "health", "healthcare", "heart", "heinz",
+            "help", "helsinki", "here", "hermes", "hgtv", "hilton", "hiphop", "hisamitsu", "hitachi", "hiv", "hk", "hkt", "hm", "hn", "hockey",
+            "holdings", "holiday", "homedepot", "homegoods", "homes", "homesense", "honda", "honeywell", "horse", "host", "hosting", "hoteis",
+            "hotel", "hoteles", "hotels", "hotmail", "house", "how", "hr", "ht", "htc", "hu", "hughes", "hyatt", "hyundai", "ibm", "icbc", "ice",
+            "icu", "id", "idn", "ie", "ieee", "ifm", "iinet", "ikano", "il", "im", "imamat", "imdb", "immo", "immobilien", "in", "indians",
+            "industries", "infiniti", "info", "infosys", "infy", "ing", "ink", "institute", "insurance", "insure", "int", "intel", "international",
+            "intuit", "investments", "io", "ipiranga", "iq", "ir", "ira", "irish", "is", "iselect", "islam", "ismaili", "ist", "istanbul", "it",
+            "itau", "itv", "iveco", "iwc", "jaguar", "java", "jcb", "jcp", "je", "jeep", "jetzt", "jewelry", "jio", "jlc", "jll", "jm", "jmp", "jnj",
+            "jo", "jobs", "joburg", "jot", "joy", "jp", "jpmorgan", "jpmorganchase", "jprs", "juegos", "juniper", "justforu", "kaufen", "kddi", "ke",
+            "kerastase", "kerryhotels", "kerrylogisitics", "kerryproperties", "ketchup", "kfh", "kg", "kh", "ki", "kia", "kid", "kids", "kiehls",
+            "kim", "kinder", "kindle", "kitchen", "kiwi", "km", "kn", "koeln", "komatsu", "konami", "kone", "kosher", "kp", "kpmg", "kpn", "kr",
+            "krd", "kred", "ksb", "kuokgroup", "kw", "ky", "kyknet", "kyoto", "kz", "la", "lacaixa", "ladbrokes", "lamborghini", "lamer", "lancaster",
+            "lancia", "lancome", "land", "landrover", "lanxess", "lat", "latino", "latrobe", "lawyer", "lb", "lc", "lds", "lease", "leclerc",
+            "lefrak", "legal", "lego", "lexus", "lgbt", "li", "liaison", "lidl", "life", "lifeinsurance", "lifestyle", "lighting", "lightning",
+            "like", "lilly", "limited", "limo", "lincoln", "linde", "link", "lipsy", "live", "livestrong", "living", "lixil", "lk", "llc", "loan",
+            "loans", "locker", "locus", "loft", "lol", "london", "loreal", "lotte", "lotto", "love", "lpl", "lplfinancial", "lr", "ls", "lt", "ltd",
+            "ltda", "lu", "lundbeck", "lupin", "luxe", "luxury", "lv", "ly", "ma", "macys", "madrid", "maif", "maison", "makeup", "man", "management",
+            "mango", "map", "market", "marketing", "markets", "marriott", "marshalls", "maserati", "mattel", "maybelline", "mba", "mc", "mcd",
+            "mcdonalds", "mckinsey", "md", "me", "media", "medical", "meet", "melbourne", "meme", "memorial", "men", "menu", "meo", "merck",
+            "merckmsd", "metlife", "mf", "mg", "mh", "miami", "microsoft", "mih", "mii", "mil", "mini", "mint", "mit", "mitek", "mitsubishi", "mk",
+            "ml", "mlb", "mls", "mm", "mn", "mnet", "mo", "mobi", "mobile", "mobily", "moda", "moe", "mom", "monash", "money", "monster", "montblanc",
+            "mopar", "mormon", "mortgage", "moscow", "moto", "motorcycles", "mov", "movie", "movistar", "mozaic", "mp", "mq", "mr", "mrmuscle",
+            "mrporter", "ms", "mt", "mtn", "mtpc", "mtr", "mu", "multichoice", "museum", "music", "mutual", "mutualfunds", "mutuelle", "mv", "mw",
+            "mx", "my", "mz", "mzansimagic", "na", "nab", "nadex", "nagoya", "name", "naspers", "nationwide", "natura", "navy", "nba", "nc", "ne",
+            "nec", "net", "netaporter", "netbank", "netflix", "network", "neustar", "new", "newholland", "news", "next", "nextdirect", "nexus", "nf",
+            "nfl", "ng", "ngo", "nhk", "ni", "nico", "nike", "nikon", "ninja", "nissan", "nissay", "nl", "no", "nokia", "northlandinsurance",
+            "northwesternmutual", "norton", "now", "nowruz", "nowtv", "np", "nr", "nra", "nrw", "ntt", "nu", "nyc", "nz", "obi", "observer", "off",
+            "okinawa", "olayan", "olayangroup", "oldnavy", "ollo", "olympus", "om", "omega", "ong", "onl", "online", "onyourside", "ooo", "open",
+            "oracle", "orange", "org", "organic", "orientexpress", "origins", "osaka", "otsuka", "ott", "overheidnl", "ovh", "pa", "page",
+            "pamperedchef", "panasonic", "panerai", "paris", "pars", "partners", "parts", "party", "passagens", "patagonia", "patch", "pay", "payu",
+            "pccw", "pe", "persiangulf", "pets", "pf", "pfizer", "pg", "ph", "pharmacy", "phd", "philips", "phone", "photo", "photography", "photos",
+            "physio", "piaget", "pics", "pictet", "pictures", "pid", "pin", "ping", "pink", "pioneer", "piperlime", "pitney", "pizza", "pk", "pl",
+            "place", "play", "playstation", "plumbing", "plus", "pm", "pn", "pnc", "pohl", "poker", "politie", "polo", "porn", "post", "pr",
+            "pramerica", "praxi", "press", "prime", "pro", "prod", "productions", "prof", "progressive", "promo", "properties", "property",
+            "protection", "pru", "prudential", "ps", "pt", "pub", "pw", "pwc", "py", "qa", "qpon", "qtel", "quebec", "quest", "qvc", "racing",
+            "radio", "raid", "ram", "re", "read", "realestate", "realtor", "realty", "recipes", "red", "redken", "redstone", "redumbrella", "rehab",
+            "reise", "reisen", "reit", "ren", "rent", "rentals", "repair", "report", "republican", "rest", "restaurant", "retirement", "review",
+            "reviews", "rexroth", "rich", "richardli", "ricoh", "rightathome", "ril", "rio", "rip", "rmit", "ro", "rocher", "rocks", "rockwool",
+            "rodeo", "rogers", "roma", "room", "rs", "rsvp", "ru", "rugby", "ruhr", "run", "rw", "rwe", "ryukyu", "sa", "saarland", "safe", "safety",
+            "safeway", "sakura", "sale", "salon", "samsclub", "samsung", "sandvik", "sandvikcoromant", "sanofi", "sap", "sapo", "sapphire", "sarl",
+            "sas", "save", "saxo", "sb", "sbi", "sbs", "sc", "sca", "scb", "schaeffler", "schedule", "schmidt", "scholarhips", "scholarships",
+            "schule", "schwarz", "schwarzgroup", "science", "scjohnson", "scor", "scot", "sd", "se", "search", "seat", "security", "seek", "select",
+            "sener", "services", "ses", "seven", "sew", "sex", "sexy", "sfr", "sg", "sh", "shangrila", "sharp", "shell", "shia", "shiksha",
+            "shirriam", "shoes", "shop", "shopping", "shopyourway", "shouji", "show", "showtime", "shriram", "si", "silk", "sina", "singles", "sj",
+            "sk", "ski", "skin", "skolkovo", "sky", "skydrive", "skype", "sl", "sling", "sm", "smart", "smile", "sn", "sncf", "so", "soccer",
+            "social", "softbank", "software", "sohu", "solar", "solutions", "song", "sony", "soy", "spa", "space", "spiegel", "sport", "sports",
+            "spot", "spreadbetting", "sr", "srt", "ss", "st", "stada", "staples", "star", "starhub", "statebank", "statefarm", "statoil", "stc",
+            "stcgroup", "stockholm", "storage", "store", "stream", "stroke", "studio", "study", "style", "su", "sucks", "supersport", "supplies",
+            "supply", "support", "surf", "surgery", "suzuki", "sv", "svr", "swatch", "swiftcover", "swiss", "sx", "sy", "sydney", "symantec",
+            "systems", "sz", "tab", "taipei", "talk", "taobao", "target", "tata", "tatamotors", "tatar", "tattoo", "tax", "taxi", "tc", "tci", "td",
+            "tdk", "team", "technology", "tel", "telecity", "telefonica", "temasek", "tennis", "terra", "teva", "tf", "tg", "th", "thai", "thd",
+            "theater", "theatre", "theguardian", "thehartford", "tiaa", "tickets", "tienda", "tiffany", "tips", "tires", "tirol", "tj", "tjmaxx",
+            "tjx", "tk", "tkmaxx", "tl", "tm", "tmall", "tn", "to", "today", "tokyo", "tools", "top", "toray", "toshiba", "total", "tour", "tours",
+            "town", "toyota", "toys", "tp", "tr", "trade", "tradershotels", "trading", "training", "transformers", "translations", "transunion",
+            "travel", "travelchannel", "travelers", "travelersinsurance", "travelguard", "trust", "trv", "tt", "tube", "tui", "tunes", "tushu", "tv",
+            "tvs", "tw", "tz", "ua", "ubank", "ubs", "uconnect", "ug", "uk", "ultrabook", "um", "ummah", "unicom", "unicorn", "university", "uno",
+            "uol", "ups", "us", "uy", "uz", "va", "vacations", "vana", "vanguard", "vanish", "vc", "ve", "vegas", "ventures", "verisign",
+            "versicherung", "vet", "vg", "vi", "viajes", "video", "vig", "viking", "villas", "vin", "vip", "virgin", "visa", "vision", "vista",
+            "vistaprint", "viva", "vivo", "vlaanderen", "vn", "vodka", "volkswagen", "volvo", "vons", "vote", "voting", "voto", "voyage", "vu",
+            "vuelos", "wales", "walmart", "walter", "wang", "wanggou", "warman", "watch", "watches", "weather", "weatherchannel", "web", "webcam",
+            "weber", "webjet", "webs", "website", "wed", "wedding", "weibo", "weir", "wf", "whoswho", "wien", "wiki", "williamhill", "wilmar",
+            "windows", "wine", "winners", "wme", "wolterskluwer", "woodside", "work", "works", "world", "wow", "ws", "wtc", "wtf", "xbox", "xerox",
+            "xfinity", "xihuan", "xin", "xn--11b4c3d", "xn--1ck2e1b", "xn--1qqw23a", "xn--30rr7y", "xn--3bst00m", "xn--3ds443g", "xn--3e0b707e",
+            "xn--3oq18vl8pn36a", "xn--3pxu8k", "xn--42c2d9a", "xn--45brj9c", "xn--45q11c", "xn--4gbrim", "xn--4gq48lf9j", "xn--54b7fta0cc",
+            "xn--55qw42g", "xn--55qx5d", "xn--55qx5d8y0buji4b870u", "xn--5su34j936bgsg", "xn--5tzm5g", "xn--6frz82g", "xn--6qq986b3x1",
+            "xn--6qq986b3xl", "xn--6rtwn", "xn--80adxhks", "xn--80ao21a", "xn--80aqecdr1a", "xn--80asehdb", "xn--80aswg", "xn--8y0a063a",
+            "xn--90a3ac", "xn--9et52u", "xn--9krt00a", "xn--b4w605ferd", "xn--bck1b9a5dre4c", "xn--c1avg", "xn--c1yn36f", "xn--c2br7g", "xn--cck2b3b",
+            "xn--cckwcxetd", "xn--cg4bki", "xn--clchc0ea0b2g2a9gcd", "xn--czr694b", "xn--czrs0t", "xn--czru2d", "xn--d1acj3b", "xn--dkwm73cwpn",
+            "xn--eckvdtc9d", "xn--efvy88h", "xn--estv75g", "xn--fct429k", "xn--fes124c", "xn--fhbei", "xn--fiq228c5hs", "xn--fiq64b", "xn--fiqs8s",
+            "xn--fiqz9s", "xn--fjq720a", "xn--flw351e", "xn--fpcrj9c3d", "xn--fzc2c9e2c", "xn--fzys8d69uvgm", "xn--g2xx48c", "xn--gckr3f0f",
+            "xn--gecrj9c", "xn--gk3at1e", "xn--h2brj9c", "xn--hdb9cza1b", "xn--hxt035cmppuel", "xn--hxt035czzpffl", "xn--hxt814e", "xn--i1b6b1a6a2e",
+            "xn--imr513n", "xn--io0a7i", "xn--j1aef", "xn--j1amh", "xn--j6w193g", "xn--j6w470d71issc", "xn--jlq480n2rg", "xn--jlq61u9w7b",
+            "xn--jvr189m", "xn--kcrx77d1x4a", "xn--kcrx7bb75ajk3b", "xn--kprw13d", "xn--kpry57d", "xn--kpu716f", "xn--kput3i", "xn--lgbbat1ad8j",
+            "xn--mgb9awbf", "xn--mgba3a3ejt", "xn--mgba3a4f16a", "xn--mgba7c0bbn0a", "xn--mgbaakc7dvf", "xn--mgbaam7a8h", "xn--mgbab2bd",
+            "xn--mgbai9azgqp6j", "xn--mgbayh7gpa", "xn--mgbb9fbpob", "xn--mgbbh1a71e", "xn--mgbc0a9azcg", "xn--mgbca7dzdo", "xn--mgberp4a5d4ar",
+            "xn--mgbi4ecexp", "xn--mgbt3dhd", "xn--mgbv6cfpo", "xn--mgbx4cd0ab", "xn--mk1bu44c", "xn--mxtq1m", "xn--ngbc5azd", "xn--ngbe9e0a",
+            "xn--ngbrx", "xn--node", "xn--nqv7f", "xn--nqv7fs00ema", "xn--nyqy26a", "xn--o3cw4h", "xn--ogbpf8fl", "xn--otu796d", "xn--p1acf",
+            "xn--p1ai", "xn--pbt977c", "xn--pgb3ceoj", "xn--pgbs0dh", "xn--pssy2u", "xn--q9jyb4c", "xn--qcka1pmc", "xn--rhqv96g", "xn--rovu88b",
+            "xn--s9brj9c", "xn--ses554g", "xn--t60b56a", "xn--tckwe", "xn--tiq49xqyj", "xn--tqq33ed31aqia", "xn--unup4y", "xn--vermgensberater-ctb",
+            "xn--vermgensberatung-pwb", "xn--vhquv", "xn--vuq861b", "xn--w4r85el8fhu5dnra", "xn--w4rs40l", "xn--wgbh1c", "xn--wgbl6a", "xn--xhq521b",
+            "xn--xkc2al3hye2a", "xn--xkc2dl3a5ee0h", "xn--yfro4i67o", "xn--ygbi2ammx", "xn--zfr164b", "xperia", "xxx", "xyz", "yachts", "yahoo",
+            "yamaxun", "yandex", "ye", "yellowpages", "yodobashi", "yoga", "yokohama", "you", "youtube", "yt", "yun", "za", "zappos", "zara", "zero",
+            "zip", "zippo", "zm", "zone", "zuerich", "zulu", "zw"
+    };
 
-    Address::Address(const Address& address) : _host(address._host), _port(address._port) {}
+    constexpr bool is_strictly_sorted(const std::string_view* begin, const std::string_view* end) {
+        for (auto it = begin + 1; it < end; it++) {
+            if (!(*(it - 1) < *it))
+                return false;
+        }
+        return true;
+    }
+
+    static_assert(is_strictly_sorted(std::begin(TOP_LEVEL_DOMAINS), std::end(TOP_LEVEL_DOMAINS)), "The top-level domains must be sorted.");
+
+    inline char to_lower_ascii(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    /*
+     * Compares a lowercase string with a string of any case, without allocating the lowercase form of the latter.
+     */
+    inline int compare_lowercase(std::string_view lowercase, std::string_view str) {
+        size_t length = std::min(lowercase.size(), str.size());
+        for (size_t i = 0; i < length; i++) {
+            auto a = static_cast<u8>(lowercase[i]), b = static_cast<u8>(to_lower_ascii(str[i]));
+            if (a != b)
+                return a < b ? -1 : 1;
+        }
+        return lowercase.size() == str.size() ? 0 : (lowercase.size() < str.size() ? -1 : 1);
+    }
+
+    template<typename Iterator>
+    inline bool contains_lowercase(Iterator begin, Iterator end, std::string_view str) {
+        auto it = std::lower_bound(begin, end, str, [](std::string_view element, std::string_view value) { return compare_lowercase(element, value) < 0; });
+        return it != end && compare_lowercase(*it, str) == 0;
+    }
+
+    template<typename Container>
+    inline bool contains_lowercase(const Container& sorted, std::string_view str) {
+        return contains_lowercase(std::begin(sorted), std::end(sorted), str);
+    }
+
+    /*
+     * IP addresses
+     */
+
+    inline bool parse_ipv4(std::string_view str, u8* output) {
+        size_t i = 0;
+        for (size_t part = 0; part < 4; part++) {
+            if (part != 0) {
+                if (i >= str.size() || str[i] != '.')
+                    return false;
+                i++;
+            }
+            size_t start = i;
+            u32 value = 0;
+            while (i < str.size() && i - start < 3 && str[i] >= '0' && str[i] <= '9')
+                value = value * 10 + static_cast<u32>(str[i++] - '0');
+            // Leading zeros are rejected as they may be read as octal.
+            if (i == start || value > 255 || (str[start] == '0' && i - start > 1))
+                return false;
+            output[part] = static_cast<u8>(value);
+        }
+        return i == str.size();
+    }
+
+    inline int hex_value(char c) {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    inline bool parse_ipv6(std::string_view str, u8* output) {
+        u8 bytes[16]{};
+        size_t count = 0, i = 0;
+        size_t compressed = std::string_view::npos; // The position of "::", npos if absent.
+        if (str.size() >= 2 && str[0] == ':' && str[1] == ':') {
+            compressed = 0;
+            i = 2;
+        }
+        while (i < str.size()) {
+            if (count == 16)
+                return false;
+            size_t start = i;
+            u32 value = 0;
+            for (int digit; i < str.size() && i - start < 4 && (digit = hex_value(str[i])) >= 0; i++)
+                value = (value << 4) | static_cast<u32>(digit);
+            // An IPv4 address can only end the address.
+            if (i < str.size() && str[i] == '.') {
+                if (count > 12 || !parse_ipv4(str.substr(start), bytes + count))
+                    return false;
+                count += 4;
+                break;
+            }
+            if (i == start)
+                return false;
+            bytes[count++] = static_cast<u8>(value >> 8);
+            bytes[count++] = static_cast<u8>(value);
+            if (i == str.size())
+                break;
+            if (str[i++] != ':')
+                return false;
+            if (i < str.size() && str[i] == ':') {
+                if (compressed != std::string_view::npos)
+                    return false;
+                compressed = count;
+                i++;
+            } else if (i == str.size())
+                return false;
+        }
+        if (compressed != std::string_view::npos) {
+            if (count == 16)
+                return false;
+            std::memmove(bytes + 16 - (count - compressed), bytes + compressed, count - compressed);
+            std::memset(bytes + compressed, 0, 16 - count);
+        } else if (count != 16)
+            return false;
+        std::memcpy(output, bytes, 16);
+        return true;
+    }
+
+    inline char* format_ipv4(const u8* bytes, char* output) {
+        for (size_t i = 0; i < 4; i++) {
+            if (i != 0)
+                *output++ = '.';
+            u8 value = bytes[i];
+            if (value >= 100)
+                *output++ = static_cast<char>('0' + value / 100);
+            if (value >= 10)
+                *output++ = static_cast<char>('0' + value / 10 % 10);
+            *output++ = static_cast<char>('0' + value % 10);
+        }
+        return output;
+    }
+
+    inline char* format_ipv6(const u8* bytes, char* output) {
+        static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+        u16 groups[8];
+        for (size_t i = 0; i < 8; i++)
+            groups[i] = static_cast<u16>((bytes[i * 2] << 8) | bytes[i * 2 + 1]);
+
+        // The IPv4-mapped addresses keep the dotted-decimal form of their IPv4 address.
+        if (groups[0] == 0 && groups[1] == 0 && groups[2] == 0 && groups[3] == 0 && groups[4] == 0 && groups[5] == 0xFFFF) {
+            std::memcpy(output, "::ffff:", 7);
+            return format_ipv4(bytes + 12, output + 7);
+        }
+
+        // The longest run of at least two zero groups is compressed, the first one if tied (RFC 5952).
+        size_t best_start = 8, best_length = 1;
+        for (size_t i = 0; i < 8;) {
+            if (groups[i] != 0) {
+                i++;
+                continue;
+            }
+            size_t start = i;
+            while (i < 8 && groups[i] == 0)
+                i++;
+            if (i - start > best_length) {
+                best_start = start;
+                best_length = i - start;
+            }
+        }
+
+        for (size_t i = 0; i < 8; i++) {
+            if (i == best_start) {
+                *output++ = ':';
+                *output++ = ':';
+                i += best_length - 1;
+                continue;
+            }
+            if (i != 0 && i != best_start + best_length)
+                *output++ = ':';
+            u16 group = groups[i];
+            bool started = false;
+            for (int shift = 12; shift >= 0; shift -= 4) {
+                auto digit = (group >> shift) & 0xF;
+                if (digit != 0 || started || shift == 0) {
+                    *output++ = HEX_DIGITS[digit];
+                    started = true;
+                }
+            }
+        }
+        return output;
+    }
+
+    IPAddress::IPAddress(const std::array<u8, 4>& ipv4) : _type(IPv4) {
+        std::memcpy(_bytes.data(), ipv4.data(), 4);
+    }
+
+    IPAddress::IPAddress(const std::array<u8, 16>& ipv6) : _bytes(ipv6), _type(IPv6) {}
+
+    std::optional<IPAddress> IPAddress::parse(std::string_view address) {
+        // An IPv6 address fails to parse as IPv4 at its first ':'.
+        std::array<u8, 4> ipv4;
+        if (parse_ipv4(address, ipv4.data()))
+            return IPAddress{ipv4};
+        std::array<u8, 16> ipv6;
+        if (!parse_ipv6(address, ipv6.data()))
+            return std::nullopt;
+        return IPAddress{ipv6};
+    }
+
+    std::optional<IPAddress> IPAddress::from_sockaddr(const sockaddr* address, port_t* port) {
+        if (address->sa_family == AF_INET) {
+            auto ipv4 = reinterpret_cast<const sockaddr_in*>(address);
+            std::array<u8, 4> bytes;
+            std::memcpy(bytes.data(), &ipv4->sin_addr, 4);
+            if (port)
+                *port = ntohs(ipv4->sin_port);
+            return IPAddress{bytes};
+        } else if (address->sa_family == AF_INET6) {
+            auto ipv6 = reinterpret_cast<const sockaddr_in6*>(address);
+            std::array<u8, 16> bytes;
+            std::memcpy(bytes.data(), &ipv6->sin6_addr, 16);
+            if (port)
+                *port = ntohs(ipv6->sin6_port);
+            return IPAddress{bytes};
+        }
+        return std::nullopt;
+    }
+
+    AddressType IPAddress::get_type() const {
+        return _type;
+    }
+
+    bool IPAddress::is_ipv4() const {
+        return _type == IPv4;
+    }
+
+    bool IPAddress::is_ipv6() const {
+        return _type == IPv6;
+    }
+
+    const std::array<u8, 16>& IPAddress::get_bytes() const {
+        return _bytes;
+    }
+
+    size_t IPAddress::size() const {
+        return _type == IPv4 ? 4 : (_type == IPv6 ? 16 : 0);
+    }
+
+    size_t IPAddress::format(char* output) const {
+        if (_type == IPv4)
+            return static_cast<size_t>(format_ipv4(_bytes.data(), output) - output);
+        else if (_type == IPv6)
+            return static_cast<size_t>(format_ipv6(_bytes.data(), output) - output);
+        return 0;
+    }
+
+    std::string IPAddress::to_string() const {
+        char buffer[MAX_STRING_SIZE];
+        return {buffer, format(buffer)};
+    }
+
+    size_t IPAddress::to_sockaddr(port_t port, sockaddr_storage& storage) const {
+        std::memset(&storage, 0, sizeof(storage));
+        if (_type == IPv4) {
+            auto ipv4 = reinterpret_cast<sockaddr_in*>(&storage);
+            ipv4->sin_family = AF_INET;
+            ipv4->sin_port = htons(port);
+            std::memcpy(&ipv4->sin_addr, _bytes.data(), 4);
+            return sizeof(sockaddr_in);
+        } else if (_type == IPv6) {
+            auto ipv6 = reinterpret_cast<sockaddr_in6*>(&storage);
+            ipv6->sin6_family = AF_INET6;
+            ipv6->sin6_port = htons(port);
+            std::memcpy(&ipv6->sin6_addr, _bytes.data(), 16);
+            return sizeof(sockaddr_in6);
+        }
+        return 0;
+    }
+
+    size_t IPAddress::hash() const {
+        return static_cast<size_t>(hashing::hash_bytes(_bytes.data(), _bytes.size(), _type));
+    }
+
+    bool IPAddress::operator==(const IPAddress& other) const {
+        return _type == other._type && _bytes == other._bytes;
+    }
+
+    bool IPAddress::operator!=(const IPAddress& other) const {
+        return !(*this == other);
+    }
+
+    bool IPAddress::operator<(const IPAddress& other) const {
+        return std::tie(_type, _bytes) < std::tie(other._type, other._bytes);
+    }
+
+    IPNetwork::IPNetwork(const IPAddress& address, u8 prefix_length) : _prefix_length(prefix_length) {
+        if (address.get_type() == AddressType::EMPTY || prefix_length > address.size() * 8)
+            throw std::invalid_argument("Invalid network " + address.to_string() + "/" + std::to_string(prefix_length) + ".");
+        auto bytes = address.get_bytes();
+        for (size_t i = prefix_length / 8; i < bytes.size(); i++) {
+            size_t kept_bits = i == prefix_length / 8u ? prefix_length % 8u : 0;
+            bytes[i] &= static_cast<u8>(0xFF00 >> kept_bits);
+        }
+        if (address.is_ipv4())
+            _address = IPAddress{std::array<u8, 4>{bytes[0], bytes[1], bytes[2], bytes[3]}};
+        else
+            _address = IPAddress{bytes};
+    }
+
+    std::optional<IPNetwork> IPNetwork::parse(std::string_view network) {
+        auto separator = network.find('/');
+        auto address = IPAddress::parse(network.substr(0, separator));
+        if (!address)
+            return std::nullopt;
+        size_t prefix_length = address->size() * 8;
+        if (separator != std::string_view::npos) {
+            auto prefix = network.substr(separator + 1);
+            if (prefix.empty() || prefix.size() > 3)
+                return std::nullopt;
+            prefix_length = 0;
+            for (char c : prefix) {
+                if (c < '0' || c > '9')
+                    return std::nullopt;
+                prefix_length = prefix_length * 10 + static_cast<size_t>(c - '0');
+            }
+            if (prefix_length > address->size() * 8)
+                return std::nullopt;
+        }
+        return IPNetwork{*address, static_cast<u8>(prefix_length)};
+    }
+
+    const IPAddress& IPNetwork::get_address() const {
+        return _address;
+    }
+
+    u8 IPNetwork::get_prefix_length() const {
+        return _prefix_length;
+    }
+
+    bool IPNetwork::contains(const IPAddress& address) const {
+        if (address.get_type() != _address.get_type())
+            return false;
+        auto& bytes = address.get_bytes();
+        auto& network = _address.get_bytes();
+        size_t full_bytes = _prefix_length / 8u;
+        if (std::memcmp(bytes.data(), network.data(), full_bytes) != 0)
+            return false;
+        size_t remaining_bits = _prefix_length % 8u;
+        return remaining_bits == 0 || (bytes[full_bytes] & static_cast<u8>(0xFF00 >> remaining_bits)) == network[full_bytes];
+    }
+
+    std::string IPNetwork::to_string() const {
+        return _address.to_string() + "/" + std::to_string(_prefix_length);
+    }
+
+    bool IPNetwork::operator==(const IPNetwork& other) const {
+        return _prefix_length == other._prefix_length && _address == other._address;
+    }
+
+    bool IPNetwork::operator!=(const IPNetwork& other) const {
+        return !(*this == other);
+    }
+
+    /*
+     * Address
+     */
+
+    Address::Address(host host, port_t port) : _host(std::move(host)), _ip(IPAddress::parse(_host).value_or(IPAddress{})), _port(port) {}
+
+    Address::Address(const IPAddress& ip, port_t port) : _host(ip.to_string()), _ip(ip), _port(port) {}
 
-    Address::Address(Address&& address) noexcept : _host(std::move(address._host)), _port(address._port) {}
+    Address::Address(const Address& address) : _host(address._host), _ip(address._ip), _port(address._port) {}
+
+    Address::Address(Address&& address) noexcept : _host(std::move(address._host)), _ip(address._ip), _port(address._port) {}
 
     Address::~Address() = default;
 
@@ -41,54 +539,22 @@ namespace lambdacommon
         return _port;
     }
 
+    const IPAddress& Address::get_ip() const {
+        return _ip;
+    }
+
     bool Address::is_ipv4() const {
-#ifdef __MINGW32__
-        char d;
-        short ip1, ip2, ip3, ip4;
-        std::stringstream ss;
-        ss << _host;
-        ss >> ip1 >> d >> ip2 >> d >> ip3 >> d >> ip4 >> d;
-        ss.str("");
-        ss.clear();
-        ss << (ip1 & 0xFF) << "." << (ip2 & 0xFF) << "." << (ip3 & 0xFF) << "." << (ip4 & 0xFF);
-        return ss.str() == _host;
-#else
-        struct sockaddr_in sa{};
-        return inet_pton(AF_INET, _host.c_str(), &(sa.sin_addr)) != 0;
-#endif
+        return _ip.is_ipv4();
     }
 
     bool Address::is_ipv6() const {
-#ifdef __MINGW32__
-        const char *s = _host.c_str();
-        int colons = 0, segsize = 0, i, ix = static_cast<int>(_host.length());
-        if (s[0] == ':' || s[ix - 1] == ':') return false;
-
-        for (colons = 0, i = 0, segsize = 0; i < ix; i++)
-        {
-            if (s[i] == ':')
-            {
-                segsize = 0;
-                colons++;
-            }
-            else if (('0' <= s[i] && s[i] <= '9') || ('a' <= s[i] && s[i] <= 'f'))//|| ('A' <= s[i] && s[i] <='F')
-                segsize++;
-            else
-                return false;
-            if (segsize >= 5) return false;
-        }
-        return colons <= 7;
-#else
-        struct sockaddr_in6 sa{};
-        return inet_pton(AF_INET6, _host.c_str(), &(sa.sin6_addr)) != 0;
-#endif
+        return _ip.is_ipv6();
     }
 
     bool Address::is_domain_valid() const {
-        static const std::string tlds = "|com|net|org|edu|gov|int|mil|ac|ad|ae|af|ag|ai|al|am|an|ao|aq|ar|arpa|at|au|ax|az|ba|bb|bd|be|bf|bg|bh|bi|bj|bm|bn|bo|br|bs|bt|bv|bw|by|bz|ca|cc|cd|cf|cg|ch|ci|ck|cl|cm|cn|co|cr|cu|cv|cx|cy|cz|de|dj|dk|dm|do|dz|ec|ee|eg|er|es|et|eu|fi|fj|fk|fm|fo|fr|ga|gb|gd|ge|gf|gg|gh|gi|gl|gm|gn|gp|gq|gr|gs|gt|gu|gw|gy|hk|hm|hn|hr|ht|hu|id|ie|il|im|in|io|iq|ir|is|it|je|jm|jo|jp|ke|kg|kh|ki|km|kn|kp|kr|kw|ky|kz|la|lb|lc|li|lk|lr|ls|lt|lu|lv|ly|ma|mc|md|me|mg|mh|mk|ml|mm|mn|mo|mp|mq|ms|mt|mu|mv|mw|mx|my|mz|na|nc|ne|nf|ng|ni|nl|no|np|nr|nu|nz|om|pa|pe|pf|pg|ph|pk|pl|pm|pn|pr|ps|pt|pw|py|qa|re|ro|rs|ru|rw|sa|sb|sc|sd|se|sg|sh|si|sj|sk|sl|sm|sn|so|sr|st|su|sv|sy|sz|tc|td|tf|tg|th|tj|tk|tl|tm|tn|to|tp|tr|tt|tv|tw|tz|ua|ug|uk|us|uy|uz|va|vc|ve|vg|vi|vn|vu|wf|ws|ye|yt|za|zm|zw|aw|as|mr|bl|bq|cw|eh|mf|ss|sx|um|aaa|aarp|abarth|abb|abbott|abbvie|abc|able|abogado|abudhabi|academy|accenture|accountant|accountants|acer|aco|active|actor|adac|ads|adult|aeg|aero|aetna|afamilycompany|afl|africa|africamagic|agakhan|agency|aig|aigo|airbus|airforce|airtel|akdn|alcon|alfaromeo|alibaba|alipay|allfinanz|allfinanzberater|allfinanzberatung|allstate|ally|alsace|alstom|amazon|americanexpress|americanfamily|amex|amfam|amica|amp|amsterdam|analytics|and|android|anquan|ansons|anthem|antivirus|aol|apartments|app|apple|aquarelle|aquitaine|arab|aramco|archi|architect|are|army|art|arte|asda|asia|associates|astrium|athleta|attorney|auction|audi|audible|audio|auspost|author|auto|autoinsurance|autos|avery|avianca|axa|axis|azure|baby|baidu|banamex|bananarepublic|band|bank|banque|bar|barcelona|barclaycard|barclays|barefoot|bargains|baseball|basketball|bauhaus|bayern|bbb|bbc|bbt|bbva|bcg|bcn|beats|beauty|beer|beknown|bentley|berlin|best|bestbuy|bet|bharti|bible|bid|bike|bing|bingo|bio|biz|black|blackfriday|blanco|blockbuster|blog|bloomberg|bloomingdales|blue|bms|bmw|bnl|bnpparibas|boats|boehringer|bofa|bom|bond|boo|book|booking|boots|bosch|bostik|boston|bot|boutique|box|bradesco|bridgestone|broadway|broker|brother|brussels|budapest|bugatti|buick|build|builders|business|buy|buzz|bway|bzh|cab|cadillac|cafe|cal|call|calvinklein|cam|camera|camp|canalplus|cancerresearch|canon|capetown|capital|capitalone|caravan|cards|care|career|careers|caremore|carinsurance|cars|cartier|casa|case|caseih|cash|cashbackbonus|casino|cat|catalonia|catering|catholic|cba|cbn|cbre|cbs|ceb|center|ceo|cern|cfa|cfd|chanel|changiairport|channel|charity|chartis|chase|chat|chatr|cheap|chesapeake|chevrolet|chevy|chintai|city|chk|chloe|christmas|chrome|chrysler|church|cialis|cimb|cipriani|circle|cisco|citadel|citi|citic|cityeats|claims|cleaning|click|clinic|clinique|clothing|club|clubmed|coach|codes|coffee|college|cologne|com|comcast|commbank|community|company|compare|computer|comsec|condos|connectors|construction|consulting|contact|contractors|cooking|cookingchannel|cool|coop|corsica|country|coupon|coupons|courses|credit|creditcard|creditunion|cricket|crown|crs|cruise|cruises|csc|cuisinella|cymru|cyou|dabur|dad|dance|data|date|dating|datsun|day|dclk|dds|deal|dealer|deals|degree|delivery|dell|delmonte|deloitte|delta|democrat|dental|dentist|desi|design|deutschepost|dhl|diamonds|diet|digikey|digital|direct|directory|discount|discover|dish|diy|dnb|dnp|docomo|docs|doctor|dodge|dog|doha|domains|doosan|dot|dotafrica|download|drive|dstv|dtv|dubai|duck|dunlop|duns|dupont|durban|dvag|dvr|dwg|earth|eat|eco|ecom|edeka|education|edu|email|emerck|emerson|energy|engineer|engineering|enterprises|epost|epson|equipment|ericsson|erni|esq|est|estate|esurance|etisalat|eurovision|eus|events|everbank|exchange|expert|exposed|express|extraspace|fage|fail|fairwinds|faith|family|fan|fans|farm|farmers|fashion|fast|fedex|feedback|ferrari|ferrero|fiat|fidelity|fido|film|final|finance|financial|financialaid|finish|fire|firestone|firmdale|fish|fishing|fitness|flickr|flights|flir|florist|flowers|fls|flsmidth|fly|foo|food|foodnetwork|football|ford|forex|forsale|forum|foundation|fox|free|fresenius|frl|frogans|frontdoor|frontier|ftr|fujitsu|fujixerox|fun|fund|furniture|futbol|fyi|gai|gal|gallery|gallo|gallup|game|games|gap|garden|garnier|gay|gbiz|gcc|gdn|gea|gecompany|ged|gent|genting|george|ggee|gift|gifts|gives|giving|glade|glass|gle|glean|global|globalx|globo|gmail|gmbh|gmc|gmo|gmx|godaddy|gold|goldpoint|golf|goo|goodhands|goodyear|goog|google|gop|got|gotv|grainger|graphics|gratis|gree|green|gripe|grocery|group|guardian|guardianlife|guardianmedia|gucci|guge|guide|guitars|guru|hair|halal|hamburg|hangout|haus|hbo|hdfc|hdfcbank|health|healthcare|heart|heinz|help|helsinki|here|hermes|hgtv|hilton|hiphop|hisamitsu|hitachi|hiv|hkt|hockey|holdings|holiday|homedepot|homegoods|homes|homesense|honda|honeywell|horse|host|hosting|hoteis|hotel|hoteles|hotels|hotmail|house|how|htc|hughes|hyatt|hyundai|ibm|icbc|ice|icu|idn|ieee|ifm|iinet|ikano|imamat|imdb|immo|immobilien|indians|industries|infiniti|info|infosys|infy|ing|ink|institute|insurance|insure|intel|international|intuit|investments|ipiranga|ira|irish|iselect|islam|ismaili|ist|istanbul|itau|itv|iveco|iwc|jaguar|java|jcb|jcp|jeep|jetzt|jewelry|jio|jlc|jll|jmp|jnj|jobs|joburg|jot|joy|jpmorgan|jpmorganchase|jprs|juegos|juniper|justforu|kaufen|kddi|kerastase|kerryhotels|kerrylogisitics|kerryproperties|ketchup|kfh|kia|kid|kids|kiehls|kim|kinder|kindle|kitchen|kiwi|koeln|komatsu|konami|kone|kosher|kpmg|kpn|krd|kred|ksb|kuokgroup|kyknet|kyoto|lacaixa|ladbrokes|lamborghini|lamer|lancaster|lancia|lancome|land|landrover|lanxess|lat|latino|latrobe|lawyer|lds|lease|leclerc|lefrak|legal|lego|lexus|lgbt|liaison|lidl|life|lifeinsurance|lifestyle|lighting|lightning|like|lilly|limited|limo|lincoln|linde|link|lipsy|live|livestrong|living|lixil|llc|loan|loans|locker|locus|loft|lol|london|loreal|lotte|lotto|love|lpl|lplfinancial|ltd|ltda|lundbeck|lupin|luxe|luxury|macys|madrid|maif|maison|makeup|man|management|mango|map|market|marketing|markets|marriott|marshalls|maserati|mattel|maybelline|mba|mcd|mcdonalds|mckinsey|media|medical|meet|melbourne|meme|memorial|men|menu|meo|merck|merckmsd|metlife|miami|microsoft|mih|mii|mini|mint|mit|mitek|mitsubishi|mlb|mls|mnet|mobi|mobile|mobily|moda|moe|mom|monash|money|monster|montblanc|mopar|mormon|mortgage|moscow|moto|motorcycles|mov|movie|movistar|mozaic|mrmuscle|mrporter|mtn|mtpc|mtr|multichoice|museum|music|mutual|mutualfunds|mutuelle|mzansimagic|nab|nadex|nagoya|name|naspers|nationwide|natura|navy|nba|nec|net|netaporter|netbank|netflix|network|neustar|new|newholland|news|next|nextdirect|nexus|nfl|ngo|nhk|nico|nike|nikon|ninja|nissan|nissay|nokia|northlandinsurance|northwesternmutual|norton|now|nowruz|nowtv|nra|nrw|ntt|nyc|obi|observer|off|okinawa|olayan|olayangroup|oldnavy|ollo|olympus|omega|ong|onl|online|onyourside|ooo|open|oracle|orange|org|organic|orientexpress|origins|osaka|otsuka|ott|overheidnl|ovh|page|pamperedchef|panasonic|panerai|paris|pars|partners|parts|party|passagens|patagonia|patch|pay|payu|pccw|persiangulf|pets|pfizer|pharmacy|phd|philips|phone|photo|photography|photos|physio|piaget|pics|pictet|pictures|pid|pin|ping|pink|pioneer|piperlime|pitney|pizza|place|play|playstation|plumbing|plus|pnc|pohl|poker|politie|polo|porn|post|pramerica|praxi|press|prime|pro|prod|productions|prof|progressive|promo|properties|property|protection|pru|prudential|pub|pwc|qpon|qtel|quebec|quest|qvc|racing|radio|raid|ram|read|realestate|realtor|realty|recipes|red|redken|redstone|redumbrella|rehab|reise|reisen|reit|ren|rent|rentals|repair|report|republican|rest|restaurant|retirement|review|reviews|rexroth|rich|richardli|ricoh|rightathome|ril|rio|rip|rmit|rocher|rocks|rockwool|rodeo|rogers|roma|room|rsvp|rugby|ruhr|run|rwe|ryukyu|saarland|safe|safety|safeway|sakura|sale|salon|samsclub|samsung|sandvik|sandvikcoromant|sanofi|sap|sapo|sapphire|sarl|sas|save|saxo|sbi|sbs|sca|scb|schaeffler|schedule|schmidt|scholarhips|scholarships|schule|schwarz|schwarzgroup|science|scjohnson|scor|scot|search|seat|security|seek|select|sener|services|ses|seven|sew|sex|sexy|sfr|shangrila|sharp|shell|shia|shiksha|shirriam|shoes|shop|shopping|shopyourway|shouji|show|showtime|shriram|silk|sina|singles|ski|skin|skolkovo|sky|skydrive|skype|sling|smart|smile|sncf|soccer|social|softbank|software|sohu|solar|solutions|song|sony|soy|spa|space|spiegel|sport|sports|spot|spreadbetting|srt|stada|staples|star|starhub|statebank|statefarm|statoil|stc|stcgroup|stockholm|storage|store|stream|stroke|studio|study|style|sucks|supersport|supplies|supply|support|surf|surgery|suzuki|svr|swatch|swiftcover|swiss|symantec|systems|sydney|tab|taipei|talk|taobao|target|tata|tatamotors|tatar|tattoo|tax|taxi|tci|tdk|team|technology|tel|telecity|telefonica|temasek|tennis|terra|teva|thai|thd|theater|theatre|theguardian|thehartford|tiaa|tickets|tienda|tiffany|tips|tires|tirol|tjmaxx|tjx|tkmaxx|tmall|today|tokyo|tools|top|toray|toshiba|total|tour|tours|town|toyota|toys|trade|tradershotels|trading|training|transformers|translations|transunion|travel|travelchannel|travelers|travelersinsurance|travelguard|trust|trv|tube|tui|tunes|tushu|tvs|ubank|ubs|uconnect|ultrabook|ummah|unicom|unicorn|university|uno|uol|ups|vacations|vana|vanguard|vanish|vegas|ventures|verisign|versicherung|vet|viajes|video|vig|viking|villas|vin|vip|virgin|visa|vision|vista|vistaprint|viva|vivo|vlaanderen|vodka|volkswagen|volvo|vons|vote|voting|voto|voyage|vuelos|wales|walmart|walter|wang|wanggou|warman|watch|watches|weather|weatherchannel|web|webcam|weber|webjet|webs|website|wed|wedding|weibo|weir|whoswho|wien|wiki|williamhill|wilmar|windows|wine|winners|wme|wolterskluwer|world|woodside|work|works|wow|wtc|wtf|xbox|xerox|xfinity|xihuan|xin|xn--11b4c3d|xn--1ck2e1b|xn--1qqw23a|xn--30rr7y|xn--3bst00m|xn--3ds443g|xn--3e0b707e|xn--3oq18vl8pn36a|xn--3pxu8k|xn--42c2d9a|xn--45brj9c|xn--45q11c|xn--4gbrim|xn--4gq48lf9j|xn--54b7fta0cc|xn--55qw42g|xn--55qx5d|xn--55qx5d8y0buji4b870u|xn--5su34j936bgsg|xn--5tzm5g|xn--6frz82g|xn--6qq986b3x1|xn--6qq986b3xl|xn--6rtwn|xn--80adxhks|xn--80ao21a|xn--80aqecdr1a|xn--80asehdb|xn--80aswg|xn--8y0a063a|xn--90a3ac|xn--9et52u|xn--9krt00a|xn--b4w605ferd|xn--bck1b9a5dre4c|xn--c1avg|xn--c1yn36f|xn--c2br7g|xn--cck2b3b|xn--cckwcxetd|xn--cg4bki|xn--clchc0ea0b2g2a9gcd|xn--czr694b|xn--czrs0t|xn--czru2d|xn--d1acj3b|xn--dkwm73cwpn|xn--eckvdtc9d|xn--efvy88h|xn--estv75g|xn--fct429k|xn--fes124c|xn--fhbei|xn--fiq228c5hs|xn--fiq64b|xn--fiQ64b|xn--fiQ64B|xn--fiqs8s|xn--fiqz9s|xn--fjq720a|xn--flw351e|xn--fpcrj9c3d|xn--fzc2c9e2c|xn--fzys8d69uvgm|xn--g2xx48c|xn--gckr3f0f|xn--gecrj9c|xn--gk3at1e|xn--h2brj9c|xn--hdb9cza1b|xn--hxt035cmppuel|xn--hxt035czzpffl|xn--hxt814e|xn--i1b6b1a6a2e|xn--imr513n|xn--io0a7i|xn--j1aef|xn--j1amh|xn--j6w193g|xn--j6w470d71issc|xn--jlq480n2rg|xn--jlq61u9w7b|xn--jvr189m|xn--kcrx77d1x4a|xn--kcrx7bb75ajk3b|xn--kprw13d|xn--kpry57d|xn--kpu716f|xn--kput3i|xn--lgbbat1ad8j|xn--mgb9awbf|xn--mgba3a3ejt|xn--mgba3a4f16a|xn--mgba7c0bbn0a|xn--mgbaakc7dvf|xn--mgbaam7a8h|xn--mgbab2bd|xn--mgbai9azgqp6j|xn--mgbayh7gpa|xn--mgbb9fbpob|xn--mgbbh1a71e|xn--mgbc0a9azcg|xn--mgbca7dzdo|xn--mgberp4a5d4ar|xn--mgbi4ecexp|xn--mgbt3dhd|xn--mgbv6cfpo|xn--mgbx4cd0ab|xn--mk1bu44c|xn--mxtq1m|xn--ngbc5azd|xn--ngbe9e0a|xn--ngbrx|xn--node|xn--nqv7f|xn--nqv7fs00ema|xn--nyqy26a|xn--o3cw4h|xn--ogbpf8fl|xn--otu796d|xn--p1acf|xn--p1ai|xn--pbt977c|xn--pgb3ceoj|xn--pgbs0dh|xn--pssy2u|xn--q9jyb4c|xn--qcka1pmc|xn--rhqv96g|xn--rovu88b|xn--s9brj9c|xn--ses554g|xn--t60b56a|xn--tckwe|xn--tiq49xqyj|xn--tqq33ed31aqia|xn--unup4y|xn--vermgensberater-ctb|xn--vermgensberatung-pwb|xn--vhquv|xn--vuq861b|xn--w4r85el8fhu5dnra|xn--w4rs40l|xn--wgbh1c|xn--wgbl6a|xn--xhq521b|xn--xkc2al3hye2a|xn--xkc2dl3a5ee0h|xn--yfro4i67o|xn--ygbi2ammx|xn--zfr164b|xn—3ds443g|xn—fiq228c5hs|xperia|xxx|xyz|yachts|yahoo|yamaxun|yandex|yellowpages|yodobashi|yoga|yokohama|you|youtube|yun|zappos|zara|zero|zip|zippo|zone|zuerich|zulu|";
         const char* s = _host.c_str();
         size_t segsize = 0, i, ix = _host.length();
-        if (s[0] == '.' || s[ix - 1] == '.' || ix > 253)
+        if (ix == 0 || s[0] == '.' || s[ix - 1] == '.' || ix > 253)
             return false;
         for (i = 0, segsize = 0; i < ix; i++) {
             if (s[i] == '.') {
@@ -108,10 +574,7 @@ namespace lambdacommon
                 return false;
         }
 
-        std::stringstream ss;
-        ss << "|" << _host.substr(ix - segsize) << "|"; // Get last domain segment.
-
-        return tlds.find(ss.str()) != std::string::npos;
+        return is_top_level_domain(std::string_view{_host}.substr(ix - segsize)); // Check the last domain segment.
     }
 
     bool Address::is_empty() const {
@@ -157,6 +620,7 @@ namespace lambdacommon
     Address& Address::operator=(const Address& other) {
         if (this != &other) {
             _host = other._host;
+            _ip = other._ip;
             _port = other._port;
         }
         return *this;
@@ -165,18 +629,161 @@ namespace lambdacommon
     Address& Address::operator=(Address&& other) noexcept {
         if (this != &other) {
             _host = std::move(other._host);
+            _ip = other._ip;
             _port = other._port;
         }
         return *this;
     }
 
     bool Address::operator==(const Address& other) const {
+        // IP addresses are compared in their binary form, so "::1" equals "0:0:0:0:0:0:0:1".
+        if (_ip.get_type() != AddressType::EMPTY || other._ip.get_type() != AddressType::EMPTY)
+            return _ip == other._ip && _port == other._port;
         return _host == other._host && _port == other._port;
     }
 
     bool Address::operator<(const Address& other) const {
+        if (_ip.get_type() != AddressType::EMPTY || other._ip.get_type() != AddressType::EMPTY)
+            return std::tie(_ip, _port) < std::tie(other._ip, other._port);
         return std::tie(_host, _port) < std::tie(other._host, other._port);
     }
 
+    size_t Address::to_sockaddr(sockaddr_storage& storage) const {
+        return _ip.to_sockaddr(_port, storage);
+    }
+
+    std::optional<Address> Address::from_sockaddr(const sockaddr* address) {
+        port_t port = 0;
+        auto ip = IPAddress::from_sockaddr(address, &port);
+        if (!ip)
+            return std::nullopt;
+        return Address{*ip, port};
+    }
+
+    std::future<std::vector<Address>> Address::resolve_async(DNSResolver& resolver) const {
+        auto promise = std::make_shared<std::promise<std::vector<Address>>>();
+        auto future = promise->get_future();
+        resolver.resolve_async(_host, [promise, port = _port](const std::vector<IPAddress>& addresses) {
+            std::vector<Address> result;
+            result.reserve(addresses.size());
+            for (const auto& address : addresses)
+                result.emplace_back(address, port);
+            promise->set_value(std::move(result));
+        });
+        return future;
+    }
+
+    size_t Address::hash() const {
+        using namespace hashing;
+        if (_ip.get_type() != AddressType::EMPTY)
+            return static_cast<size_t>(hash_int(_port, _ip.hash()));
+        return static_cast<size_t>(hash_int(_port, hash_string(_host)));
+    }
+
     Address Address::EMPTY{"", 0};
+    /*
+     * Public suffix list
+     */
+
+    inline void sort_unique(std::vector<std::string>& strings) {
+        std::sort(strings.begin(), strings.end());
+        strings.erase(std::unique(strings.begin(), strings.end()), strings.end());
+    }
+
+    PublicSuffixList PublicSuffixList::parse(std::string_view content) {
+        PublicSuffixList list;
+        size_t start = 0;
+        while (start < content.size()) {
+            auto end = content.find('\n', start);
+            if (end == std::string_view::npos)
+                end = content.size();
+            auto line = content.substr(start, end - start);
+            start = end + 1;
+
+            // A rule ends at the first whitespace.
+            auto rule = line.substr(0, line.find_first_of(" \t\r"));
+            if (rule.empty() || rule.substr(0, 2) == "//")
+                continue;
+            std::string lowercase(rule);
+            std::transform(lowercase.begin(), lowercase.end(), lowercase.begin(), to_lower_ascii);
+
+            if (lowercase.front() == '!')
+                list._exceptions.push_back(lowercase.substr(1));
+            else if (lowercase.size() > 2 && lowercase.compare(0, 2, "*.") == 0)
+                list._wildcards.push_back(lowercase.substr(2));
+            else
+                list._rules.push_back(lowercase);
+            list._top_level_domains.push_back(lowercase.substr(lowercase.rfind('.') + 1));
+        }
+        sort_unique(list._rules);
+        sort_unique(list._wildcards);
+        sort_unique(list._exceptions);
+        sort_unique(list._top_level_domains);
+        return list;
+    }
+
+    PublicSuffixList PublicSuffixList::load(const fs::path& path) {
+        std::ifstream file(path.to_string(), std::ios::binary);
+        if (!file)
+            throw std::runtime_error("Cannot read the public suffix list " + path.to_string() + ".");
+        std::string content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        return parse(content);
+    }
+
+    bool PublicSuffixList::is_top_level_domain(std::string_view label) const {
+        return contains_lowercase(_top_level_domains, label);
+    }
+
+    std::string_view PublicSuffixList::get_public_suffix(std::string_view domain) const {
+        // The suffixes are checked from the longest, so the first matching rule is the prevailing one.
+        size_t start = 0;
+        for (;;) {
+            auto suffix = domain.substr(start);
+            if (contains_lowercase(_exceptions, suffix))
+                return suffix.substr(suffix.find('.') + 1);
+            if (contains_lowercase(_rules, suffix))
+                return suffix;
+            auto dot = suffix.find('.');
+            if (dot == std::string_view::npos)
+                return suffix; // The implicit "*" rule.
+            if (contains_lowercase(_wildcards, suffix.substr(dot + 1)))
+                return suffix;
+            start += dot + 1;
+        }
+    }
+
+    std::string_view PublicSuffixList::get_registrable_domain(std::string_view domain) const {
+        auto suffix = get_public_suffix(domain);
+        if (suffix.size() >= domain.size())
+            return {};
+        auto prefix = domain.substr(0, domain.size() - suffix.size() - 1);
+        auto dot = prefix.rfind('.');
+        return domain.substr(dot == std::string_view::npos ? 0 : dot + 1);
+    }
+
+    size_t PublicSuffixList::size() const {
+        return _rules.size() + _wildcards.size() + _exceptions.size();
+    }
+
+    // Null while the built-in list of top-level domains is used.
+    static std::shared_ptr<const PublicSuffixList> active_public_suffix_list;
+
+    bool LAMBDACOMMON_API is_top_level_domain(std::string_view label) {
+        // The list is held while used, another thread may replace it meanwhile.
+        if (auto list = std::atomic_load(&active_public_suffix_list))
+            return list->is_top_level_domain(label);
+        return contains_lowercase(TOP_LEVEL_DOMAINS, label);
+    }
+
+    void LAMBDACOMMON_API set_public_suffix_list(PublicSuffixList list) {
+        std::atomic_store(&active_public_suffix_list, std::shared_ptr<const PublicSuffixList>(std::make_shared<const PublicSuffixList>(std::move(list))));
+    }
+
+    std::shared_ptr<const PublicSuffixList> LAMBDACOMMON_API get_public_suffix_list() {
+        return std::atomic_load(&active_public_suffix_list);
+    }
+
+    void LAMBDACOMMON_API reset_public_suffix_list() {
+        std::atomic_store(&active_public_suffix_list, std::shared_ptr<const PublicSuffixList>());
+    }
 }
@@ -0,0 +1,544 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/lambdacommon/connection/event_loop.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace lambdacommon
+{
+    /*
+     * The maximum number of buffers given to a single scatter/gather read or write.
+     */
+    constexpr size_t MAX_IO_PARTS = 64;
+
+    /*
+     * The maximum number of bytes received by a single read, a datagram is at most this size.
+     */
+    constexpr size_t MAX_READ_SIZE = 65536;
+
+    inline std::system_error last_system_error(const std::string& message) {
+        return std::system_error(errno, std::generic_category(), message);
+    }
+
+    inline void set_option(int fd, int level, int option, int value) {
+        setsockopt(fd, level, option, &value, sizeof(value));
+    }
+
+    inline std::optional<Address> get_socket_address(int fd) {
+        sockaddr_storage storage{};
+        socklen_t length = sizeof(storage);
+        if (getsockname(fd, reinterpret_cast<sockaddr*>(&storage), &length) != 0)
+            return std::nullopt;
+        return Address::from_sockaddr(reinterpret_cast<const sockaddr*>(&storage));
+    }
+
+    /*
+     * Event source
+     */
+
+    EventSource::EventSource(EventLoop& loop, int fd) : _loop(loop), _fd(fd) {}
+
+    EventSource::~EventSource() {
+        // Closing the file descriptor also removes it from the epoll instance.
+        if (_fd >= 0)
+            ::close(_fd);
+    }
+
+    void EventSource::watch(u32 events) {
+        epoll_event event{};
+        event.events = events | EPOLLET;
+        event.data.ptr = this;
+        if (epoll_ctl(_loop._epoll_fd, EPOLL_CTL_ADD, _fd, &event) != 0)
+            throw last_system_error("Cannot watch the file descriptor");
+        _loop._sources[_fd] = shared_from_this();
+    }
+
+    void EventSource::close_source() {
+        if (_fd < 0)
+            return;
+        epoll_ctl(_loop._epoll_fd, EPOLL_CTL_DEL, _fd, nullptr);
+        ::close(_fd);
+        auto source = _loop._sources.find(_fd);
+        if (source != _loop._sources.end()) {
+            _loop._closed.push_back(std::move(source->second));
+            _loop._sources.erase(source);
+        }
+        _fd = -1;
+    }
+
+    EventLoop& EventSource::get_loop() const {
+        return _loop;
+    }
+
+    int EventSource::get_fd() const {
+        return _fd;
+    }
+
+    bool EventSource::is_open() const {
+        return _fd >= 0;
+    }
+
+    void EventSource::close() {
+        close_source();
+    }
+
+    /*
+     * Event loop
+     */
+
+    EventLoop::EventLoop(size_t max_events) : _max_events(std::max<size_t>(max_events, 1)), _events(std::make_unique<epoll_event[]>(_max_events)) {
+        _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (_epoll_fd < 0)
+            throw last_system_error("Cannot create the epoll instance");
+        _wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_wake_fd < 0) {
+            auto error = last_system_error("Cannot create the wake-up event");
+            ::close(_epoll_fd);
+            throw error;
+        }
+        // The wake-up event is the only one without source.
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLET;
+        event.data.ptr = nullptr;
+        epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _wake_fd, &event);
+    }
+
+    EventLoop::~EventLoop() {
+        while (!_sources.empty())
+            _sources.begin()->second->close();
+        _closed.clear();
+        ::close(_wake_fd);
+        ::close(_epoll_fd);
+    }
+
+    void EventLoop::run() {
+        while (!_stopping.exchange(false))
+            run_once();
+    }
+
+    size_t EventLoop::run_once(std::chrono::milliseconds timeout) {
+        // Wakes up for the next timer.
+        if (!_deadlines.empty()) {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(_deadlines.top().first - std::chrono::steady_clock::now());
+            remaining = std::max(remaining, std::chrono::milliseconds(0));
+            if (timeout.count() < 0 || remaining < timeout)
+                timeout = remaining;
+        }
+
+        int count = epoll_wait(_epoll_fd, _events.get(), static_cast<int>(_max_events), static_cast<int>(timeout.count()));
+        if (count < 0) {
+            if (errno != EINTR)
+                throw last_system_error("Cannot wait for events");
+            count = 0;
+        }
+
+        for (int i = 0; i < count; i++) {
+            auto source = static_cast<EventSource*>(_events[i].data.ptr);
+            if (!source) {
+                u64 value;
+                while (read(_wake_fd, &value, sizeof(value)) > 0);
+            } else if (source->is_open())
+                source->handle_events(_events[i].events);
+        }
+
+        run_timers();
+        run_posted();
+        _closed.clear();
+        return static_cast<size_t>(count);
+    }
+
+    void EventLoop::run_timers() {
+        auto now = std::chrono::steady_clock::now();
+        while (!_deadlines.empty() && !(now < _deadlines.top().first)) {
+            auto id = _deadlines.top().second;
+            _deadlines.pop();
+            // The cancelled timers are only removed from the map.
+            auto timer = _timers.find(id);
+            if (timer == _timers.end())
+                continue;
+            // The callback may add or cancel timers, invalidating the iterator.
+            auto callback = timer->second.callback;
+            if (timer->second.period.count() > 0)
+                _deadlines.emplace(now + timer->second.period, id);
+            else
+                _timers.erase(timer);
+            callback();
+        }
+    }
+
+    void EventLoop::run_posted() {
+        std::vector<std::function<void()>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(_posted_mutex);
+            tasks.swap(_posted);
+        }
+        for (auto& task : tasks)
+            task();
+    }
+
+    void EventLoop::stop() {
+        _stopping = true;
+        u64 value = 1;
+        [[maybe_unused]] auto result = write(_wake_fd, &value, sizeof(value));
+    }
+
+    void EventLoop::post(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(_posted_mutex);
+            _posted.push_back(std::move(task));
+        }
+        u64 value = 1;
+        [[maybe_unused]] auto result = write(_wake_fd, &value, sizeof(value));
+    }
+
+    TimerId EventLoop::add_timer(std::chrono::milliseconds delay, std::function<void()> callback, bool repeat) {
+        auto id = _next_timer_id++;
+        // A repeating timer needs a period, else it would run forever within a single iteration.
+        auto period = repeat ? std::max(delay, std::chrono::milliseconds(1)) : std::chrono::milliseconds(0);
+        _timers.emplace(id, Timer{std::move(callback), period});
+        _deadlines.emplace(std::chrono::steady_clock::now() + delay, id);
+        return id;
+    }
+
+    bool EventLoop::cancel_timer(TimerId timer) {
+        return _timers.erase(timer) != 0;
+    }
+
+    BlockPool& EventLoop::get_block_pool() {
+        return _block_pool;
+    }
+
+    size_t EventLoop::get_source_count() const {
+        return _sources.size();
+    }
+
+    /*
+     * TCP connection
+     */
+
+    TCPConnection::TCPConnection(EventLoop& loop, int fd, Address peer_address) : EventSource(loop, fd), _peer_address(std::move(peer_address)) {
+        set_option(fd, IPPROTO_TCP, TCP_NODELAY, 1);
+    }
+
+    void TCPConnection::connect(EventLoop& loop, const Address& address, ConnectCallback callback) {
+        sockaddr_storage storage{};
+        auto length = address.to_sockaddr(storage);
+        if (length == 0) {
+            callback(nullptr, std::make_error_code(std::errc::invalid_argument));
+            return;
+        }
+
+        int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            callback(nullptr, std::error_code(errno, std::generic_category()));
+            return;
+        }
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&storage), static_cast<socklen_t>(length)) != 0 && errno != EINPROGRESS) {
+            std::error_code error(errno, std::generic_category());
+            ::close(fd);
+            callback(nullptr, error);
+            return;
+        }
+
+        // The socket becomes writable once connected, or once the connection failed.
+        std::shared_ptr<TCPConnection> connection{new TCPConnection(loop, fd, address)};
+        connection->_on_connect = std::move(callback);
+        connection->watch(EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+    }
+
+    void TCPConnection::handle_events(u32 events) {
+        if (_on_connect) {
+            if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+                return;
+            auto callback = std::move(_on_connect);
+            _on_connect = nullptr;
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0)
+                error = errno;
+            if (error != 0) {
+                close_source();
+                callback(nullptr, std::error_code(error, std::generic_category()));
+                return;
+            }
+            callback(std::static_pointer_cast<TCPConnection>(shared_from_this()), {});
+            if (!is_open())
+                return;
+        }
+
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            read(events);
+        if (is_open() && (events & EPOLLOUT))
+            flush();
+    }
+
+    void TCPConnection::read(u32 events) {
+        // In edge-triggered mode the socket must be drained, else its next data wouldn't raise an event.
+        // A short read drains it, unless the peer also closed the connection: the end of the stream must then be read.
+        bool until_end = events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR);
+        BufferChain input{_loop.get_block_pool()};
+        while (is_open()) {
+            auto received = input.read_from(_fd, MAX_READ_SIZE);
+            if (received > 0) {
+                if (_on_data)
+                    _on_data(*this, input);
+                input.clear();
+                if (static_cast<size_t>(received) < MAX_READ_SIZE && !until_end)
+                    return;
+            } else if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                close();
+                return;
+            } else if (errno != EINTR)
+                return;
+        }
+    }
+
+    /*
+     * Sends the first bytes of a chain with a scatter/gather write, without raising SIGPIPE.
+     */
+    inline ssize_t send_chain(int fd, const BufferChain& chain) {
+        iovec parts[MAX_IO_PARTS];
+        msghdr message{};
+        message.msg_iov = parts;
+        message.msg_iovlen = chain.export_iovec(parts, MAX_IO_PARTS);
+        return sendmsg(fd, &message, MSG_NOSIGNAL);
+    }
+
+    void TCPConnection::flush() {
+        while (!_output.empty()) {
+            auto sent = send_chain(_fd, _output);
+            if (sent < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    close();
+                return;
+            }
+            _output.consume(static_cast<size_t>(sent));
+        }
+    }
+
+    void TCPConnection::set_on_data(DataCallback callback) {
+        _on_data = std::move(callback);
+    }
+
+    void TCPConnection::set_on_close(CloseCallback callback) {
+        _on_close = std::move(callback);
+    }
+
+    bool TCPConnection::write(std::string_view data) {
+        return write(&data, 1);
+    }
+
+    bool TCPConnection::write(std::initializer_list<std::string_view> parts) {
+        return write(parts.begin(), parts.size());
+    }
+
+    bool TCPConnection::write(const std::string_view* parts, size_t count) {
+        if (!is_open())
+            return false;
+
+        // Writes directly if nothing is queued, the queue keeps the order of the data.
+        size_t sent = 0;
+        bool blocked = !_output.empty() || _on_connect;
+        if (!blocked) {
+            iovec vectors[MAX_IO_PARTS];
+            size_t vector_count = std::min(count, MAX_IO_PARTS), size = 0;
+            for (size_t i = 0; i < vector_count; i++) {
+                vectors[i].iov_base = const_cast<char*>(parts[i].data());
+                vectors[i].iov_len = parts[i].size();
+                size += parts[i].size();
+            }
+            msghdr message{};
+            message.msg_iov = vectors;
+            message.msg_iovlen = vector_count;
+            auto result = sendmsg(_fd, &message, MSG_NOSIGNAL);
+            if (result < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    close();
+                    return false;
+                }
+                blocked = true;
+            } else {
+                sent = static_cast<size_t>(result);
+                blocked = sent < size;
+            }
+        }
+
+        // Queues the data which was not sent, it is sent once the socket is writable again.
+        for (size_t i = 0; i < count; i++) {
+            if (sent >= parts[i].size()) {
+                sent -= parts[i].size();
+                continue;
+            }
+            _output.append(parts[i].substr(sent));
+            sent = 0;
+        }
+        // A full socket raises an event once writable, the parts beyond the limit of a single write must be sent now.
+        if (!blocked && !_output.empty())
+            flush();
+        return is_open();
+    }
+
+    bool TCPConnection::write(BufferChain data) {
+        if (!is_open())
+            return false;
+        bool blocked = !_output.empty() || _on_connect;
+        _output.append(std::move(data));
+        if (!blocked)
+            flush();
+        return is_open();
+    }
+
+    void TCPConnection::close() {
+        if (!is_open())
+            return;
+        close_source();
+        _output.clear();
+        // The callbacks are released as they may hold the connection.
+        auto on_close = std::move(_on_close);
+        _on_close = nullptr;
+        _on_data = nullptr;
+        if (on_close)
+            on_close(*this);
+    }
+
+    const Address& TCPConnection::get_peer_address() const {
+        return _peer_address;
+    }
+
+    size_t TCPConnection::get_queued_size() const {
+        return _output.size();
+    }
+
+    /*
+     * TCP listener
+     */
+
+    TCPListener::TCPListener(EventLoop& loop, int fd, AcceptCallback on_accept) : EventSource(loop, fd), _on_accept(std::move(on_accept)) {}
+
+    std::shared_ptr<TCPListener> TCPListener::listen(EventLoop& loop, const Address& address, AcceptCallback on_accept, int backlog) {
+        sockaddr_storage storage{};
+        auto length = address.to_sockaddr(storage);
+        if (length == 0)
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "Cannot listen on " + address.to_string());
+
+        int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            throw last_system_error("Cannot create the socket");
+        std::shared_ptr<TCPListener> listener{new TCPListener(loop, fd, std::move(on_accept))};
+        set_option(fd, SOL_SOCKET, SO_REUSEADDR, 1);
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&storage), static_cast<socklen_t>(length)) != 0 || ::listen(fd, backlog) != 0)
+            throw last_system_error("Cannot listen on " + address.to_string());
+        listener->watch(EPOLLIN);
+        return listener;
+    }
+
+    void TCPListener::handle_events(u32) {
+        while (is_open()) {
+            sockaddr_storage storage{};
+            socklen_t length = sizeof(storage);
+            int fd = accept4(_fd, reinterpret_cast<sockaddr*>(&storage), &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                // Also stops on the lack of file descriptors, the pending connections are accepted on the next connection.
+                return;
+            }
+
+            auto peer_address = Address::from_sockaddr(reinterpret_cast<const sockaddr*>(&storage));
+            std::shared_ptr<TCPConnection> connection{new TCPConnection(_loop, fd, peer_address ? *peer_address : Address(IPAddress{}))};
+            // The callbacks are set before watching, so the data already received is not lost.
+            if (_on_accept)
+                _on_accept(connection);
+            if (connection->is_open())
+                connection->watch(EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+        }
+    }
+
+    Address TCPListener::get_local_address() const {
+        auto address = get_socket_address(_fd);
+        return address ? *address : Address(IPAddress{});
+    }
+
+
+    /*
+     * UDP socket
+     */
+
+    UDPSocket::UDPSocket(EventLoop& loop, int fd, DatagramCallback on_datagram) : EventSource(loop, fd), _on_datagram(std::move(on_datagram)) {}
+
+    std::shared_ptr<UDPSocket> UDPSocket::bind(EventLoop& loop, const Address& address, DatagramCallback on_datagram) {
+        sockaddr_storage storage{};
+        auto length = address.to_sockaddr(storage);
+        if (length == 0)
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "Cannot bind " + address.to_string());
+
+        int fd = socket(storage.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            throw last_system_error("Cannot create the socket");
+        std::shared_ptr<UDPSocket> udp_socket{new UDPSocket(loop, fd, std::move(on_datagram))};
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&storage), static_cast<socklen_t>(length)) != 0)
+            throw last_system_error("Cannot bind " + address.to_string());
+        udp_socket->watch(EPOLLIN);
+        return udp_socket;
+    }
+
+    void UDPSocket::handle_events(u32) {
+        BufferChain input{_loop.get_block_pool()};
+        while (is_open()) {
+            sockaddr_storage storage{};
+            iovec parts[MAX_IO_PARTS];
+            msghdr message{};
+            message.msg_name = &storage;
+            message.msg_namelen = sizeof(storage);
+            message.msg_iov = parts;
+            message.msg_iovlen = input.prepare(parts, MAX_IO_PARTS, MAX_READ_SIZE);
+            auto received = recvmsg(_fd, &message, 0);
+            input.commit(received > 0 ? static_cast<size_t>(received) : 0);
+            if (received < 0) {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+            auto sender = Address::from_sockaddr(reinterpret_cast<const sockaddr*>(&storage));
+            // A datagram larger than a block is made contiguous.
+            if (_on_datagram && sender)
+                _on_datagram(*this, input.linearize(), *sender);
+            input.clear();
+        }
+    }
+
+    bool UDPSocket::send_to(const Address& address, std::string_view data) {
+        sockaddr_storage storage{};
+        auto length = address.to_sockaddr(storage);
+        if (!is_open() || length == 0)
+            return false;
+        return sendto(_fd, data.data(), data.size(), MSG_NOSIGNAL, reinterpret_cast<const sockaddr*>(&storage), static_cast<socklen_t>(length)) >= 0;
+    }
+
+    Address UDPSocket::get_local_address() const {
+        auto address = get_socket_address(_fd);
+        return address ? *address : Address(IPAddress{});
+    }
+
+}
+
+#endif //__linux__
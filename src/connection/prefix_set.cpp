@@ -0,0 +1,201 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/lambdacommon/connection/prefix_set.h"
+#include <array>
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+namespace lambdacommon
+{
+    inline u32 popcount(u64 value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return static_cast<u32>(__popcnt64(value));
+#elif defined(_MSC_VER)
+        return static_cast<u32>(__popcnt(static_cast<u32>(value)) + __popcnt(static_cast<u32>(value >> 32)));
+#else
+        return static_cast<u32>(__builtin_popcountll(value));
+#endif
+    }
+
+    inline u64 load_be64(const u8* bytes) {
+        u64 value = 0;
+        for (size_t i = 0; i < 8; i++)
+            value = (value << 8) | bytes[i];
+        return value;
+    }
+
+    /*
+     * The address as a 128-bit key, an IPv4 address is in the most significant bits.
+     */
+    struct PrefixKey
+    {
+        u64 high;
+        u64 low;
+
+        explicit PrefixKey(const IPAddress& address) : high(load_be64(address.get_bytes().data())), low(load_be64(address.get_bytes().data() + 8)) {}
+
+        /*
+         * Gets the STRIDE bits at the offset, the bits after the end of the key are zero.
+         */
+        [[nodiscard]] inline u32 extract(u32 offset) const {
+            constexpr u32 MASK = (1u << IPPrefixSet::STRIDE) - 1;
+            constexpr u32 LAST = 64 - IPPrefixSet::STRIDE;
+            if (offset <= LAST)
+                return static_cast<u32>(high >> (LAST - offset)) & MASK;
+            else if (offset < 64)
+                return static_cast<u32>((high << (offset - LAST)) | (low >> (64 + LAST - offset))) & MASK;
+            else if (offset <= 64 + LAST)
+                return static_cast<u32>(low >> (64 + LAST - offset)) & MASK;
+            return static_cast<u32>(low << (offset - 64 - LAST)) & MASK;
+        }
+    };
+
+    constexpr u32 SLOTS = 1u << IPPrefixSet::STRIDE;
+
+    /*
+     * The uncompressed trie used while building the set, a slot stores the longest network ending at the level of the node.
+     */
+    struct PrefixBuildNode
+    {
+        std::array<u32, SLOTS> values{};
+        std::array<u8, SLOTS> lengths{};
+        std::array<std::unique_ptr<PrefixBuildNode>, SLOTS> children;
+    };
+
+    inline void insert_prefix(PrefixBuildNode* node, const IPNetwork& network, u32 value) {
+        PrefixKey key{network.get_address()};
+        u32 length = network.get_prefix_length(), offset = 0;
+        while (length > offset + IPPrefixSet::STRIDE) {
+            auto& child = node->children[key.extract(offset)];
+            if (!child)
+                child = std::make_unique<PrefixBuildNode>();
+            node = child.get();
+            offset += IPPrefixSet::STRIDE;
+        }
+        // The network covers the slots starting with its remaining bits.
+        u32 free_bits = IPPrefixSet::STRIDE - (length - offset);
+        u32 first = (key.extract(offset) >> free_bits) << free_bits;
+        for (u32 slot = first; slot < first + (1u << free_bits); slot++) {
+            if (length >= node->lengths[slot]) {
+                node->values[slot] = value;
+                node->lengths[slot] = static_cast<u8>(length);
+            }
+        }
+    }
+
+    IPPrefixSet::IPPrefixSet() : IPPrefixSet(std::vector<IPNetwork>{}) {}
+
+    IPPrefixSet::IPPrefixSet(std::vector<IPNetwork> networks) : _networks(std::move(networks)) {
+        // The root of the IPv4 trie is the first node, the root of the IPv6 trie the second one.
+        PrefixBuildNode roots[2];
+        for (size_t i = 0; i < _networks.size(); i++)
+            insert_prefix(&roots[_networks[i].get_address().is_ipv4() ? 0 : 1], _networks[i], static_cast<u32>(i + 1));
+
+        // Converts a node and its children, the slots without network inherit the network of their parent slot.
+        auto convert = [this](const PrefixBuildNode& build_node, u32 inherited, size_t index, const auto& convert) -> void {
+            Node node{0, 0, static_cast<u32>(_leaves.size()), static_cast<u32>(_nodes.size())};
+            std::array<u32, SLOTS> values;
+            u32 child_count = 0;
+            bool first_leaf = true;
+            for (u32 slot = 0; slot < SLOTS; slot++) {
+                values[slot] = build_node.values[slot] ? build_node.values[slot] : inherited;
+                if (build_node.children[slot]) {
+                    node.children |= u64{1} << slot;
+                    child_count++;
+                } else if (first_leaf || values[slot] != _leaves.back()) {
+                    node.leaves |= u64{1} << slot;
+                    _leaves.push_back(values[slot]);
+                    first_leaf = false;
+                }
+            }
+            _nodes[index] = node;
+            _nodes.resize(_nodes.size() + child_count);
+            size_t child_index = node.first_child;
+            for (u32 slot = 0; slot < SLOTS; slot++) {
+                if (build_node.children[slot])
+                    convert(*build_node.children[slot], values[slot], child_index++, convert);
+            }
+        };
+        _nodes.resize(2);
+        convert(roots[0], 0, 0, convert);
+        convert(roots[1], 0, 1, convert);
+        _nodes.shrink_to_fit();
+        _leaves.shrink_to_fit();
+    }
+
+    inline std::vector<IPNetwork> to_networks(const std::vector<std::pair<Address, u8>>& prefixes) {
+        std::vector<IPNetwork> networks;
+        networks.reserve(prefixes.size());
+        for (const auto&[address, prefix_length] : prefixes)
+            networks.emplace_back(address.get_ip(), prefix_length);
+        return networks;
+    }
+
+    IPPrefixSet::IPPrefixSet(const std::vector<std::pair<Address, u8>>& prefixes) : IPPrefixSet(to_networks(prefixes)) {}
+
+    std::optional<size_t> IPPrefixSet::longest_match(const IPAddress& address) const {
+        if (address.get_type() == AddressType::EMPTY)
+            return std::nullopt;
+        PrefixKey key{address};
+        const Node* node = &_nodes[address.is_ipv4() ? 0 : 1];
+        for (u32 offset = 0;; offset += STRIDE) {
+            u32 slot = key.extract(offset);
+            // Counts the set bits up to the slot included.
+            u32 shift = SLOTS - 1 - slot;
+            if (!((node->children >> slot) & 1)) {
+                auto value = _leaves[node->first_leaf + popcount(node->leaves << shift) - 1];
+                if (value == 0)
+                    return std::nullopt;
+                return value - 1;
+            }
+            node = &_nodes[node->first_child + popcount(node->children << shift) - 1];
+        }
+    }
+
+    bool IPPrefixSet::contains(const IPAddress& address) const {
+        return longest_match(address).has_value();
+    }
+
+    bool IPPrefixSet::contains(const Address& address) const {
+        return contains(address.get_ip());
+    }
+
+    const std::vector<IPNetwork>& IPPrefixSet::get_networks() const {
+        return _networks;
+    }
+
+    size_t IPPrefixSet::size() const {
+        return _networks.size();
+    }
+
+    size_t IPPrefixSet::get_memory_usage() const {
+        return _nodes.size() * sizeof(Node) + _leaves.size() * sizeof(u32);
+    }
+
+    AtomicIPPrefixSet::AtomicIPPrefixSet(IPPrefixSet set) : _set(std::make_shared<const IPPrefixSet>(std::move(set))) {}
+
+    std::shared_ptr<const IPPrefixSet> AtomicIPPrefixSet::load() const {
+        return std::atomic_load(&_set);
+    }
+
+    void AtomicIPPrefixSet::store(IPPrefixSet set) {
+        std::atomic_store(&_set, std::shared_ptr<const IPPrefixSet>(std::make_shared<const IPPrefixSet>(std::move(set))));
+    }
+
+    bool AtomicIPPrefixSet::contains(const IPAddress& address) const {
+        return load()->contains(address);
+    }
+
+    bool AtomicIPPrefixSet::contains(const Address& address) const {
+        return load()->contains(address);
+    }
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/lambdacommon/connection/resolver.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#ifdef LAMBDA_WINDOWS
+#  include <WS2tcpip.h>
+#else
+#  include <netdb.h>
+#  include <sys/socket.h>
+#endif
+
+namespace lambdacommon
+{
+    inline std::string to_lower_host(std::string_view host) {
+        std::string result(host);
+        for (auto& c : result) {
+            if (c >= 'A' && c <= 'Z')
+                c = static_cast<char>(c - 'A' + 'a');
+        }
+        return result;
+    }
+
+    /*
+     * Hosts file
+     */
+
+    HostsFile HostsFile::parse(std::string_view content) {
+        HostsFile hosts;
+        size_t start = 0;
+        while (start < content.size()) {
+            auto end = content.find('\n', start);
+            if (end == std::string_view::npos)
+                end = content.size();
+            auto line = content.substr(start, end - start);
+            start = end + 1;
+            line = line.substr(0, line.find('#'));
+
+            // The first field is the address, the next ones are its host names.
+            std::optional<IPAddress> address;
+            size_t i = 0;
+            for (;;) {
+                i = line.find_first_not_of(" \t\r", i);
+                if (i == std::string_view::npos)
+                    break;
+                auto field_end = std::min(line.find_first_of(" \t\r", i), line.size());
+                auto field = line.substr(i, field_end - i);
+                i = field_end;
+                if (!address) {
+                    address = IPAddress::parse(field);
+                    if (!address)
+                        break;
+                } else {
+                    auto& addresses = hosts._hosts[to_lower_host(field)];
+                    if (std::find(addresses.begin(), addresses.end(), *address) == addresses.end())
+                        addresses.push_back(*address);
+                }
+            }
+        }
+        return hosts;
+    }
+
+    HostsFile HostsFile::load(const fs::path& path) {
+        std::ifstream file(path.to_string(), std::ios::binary);
+        if (!file)
+            throw std::runtime_error("Cannot read the hosts file " + path.to_string() + ".");
+        std::string content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        return parse(content);
+    }
+
+    std::vector<IPAddress> HostsFile::lookup(const std::string& host) const {
+        auto it = _hosts.find(to_lower_host(host));
+        if (it == _hosts.end())
+            return {};
+        return it->second;
+    }
+
+    size_t HostsFile::size() const {
+        return _hosts.size();
+    }
+
+    std::vector<IPAddress> LAMBDACOMMON_API lookup_host(const std::string& host) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        // Only one socket type, else every address is returned once per socket type.
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0)
+            return {};
+        std::vector<IPAddress> addresses;
+        for (auto info = result; info; info = info->ai_next) {
+            auto address = IPAddress::from_sockaddr(info->ai_addr);
+            if (address && std::find(addresses.begin(), addresses.end(), *address) == addresses.end())
+                addresses.push_back(*address);
+        }
+        freeaddrinfo(result);
+        return addresses;
+    }
+
+    /*
+     * DNS resolver
+     */
+
+    // The resolver whose lookup runs on the current thread.
+    static thread_local const DNSResolver* current_resolver = nullptr;
+
+    DNSResolver::DNSResolver(size_t threads, std::chrono::milliseconds ttl, std::chrono::milliseconds negative_ttl, size_t cache_capacity, HostLookup lookup)
+            : _lookup(std::move(lookup)), _ttl(ttl), _negative_ttl(negative_ttl), _cache_capacity(std::max<size_t>(cache_capacity, 1)),
+              _pool(std::max<size_t>(threads, 1), 1024) {}
+
+    void DNSResolver::resolve_async(const std::string& host, Callback callback) {
+        if (auto address = IPAddress::parse(host)) {
+            callback({*address});
+            return;
+        }
+
+        auto key = to_lower_host(host);
+        std::unique_lock<std::mutex> lock(_mutex);
+        auto cached = _cache.find(key);
+        if (cached != _cache.end() && std::chrono::steady_clock::now() < cached->second.expiration) {
+            auto addresses = cached->second.addresses;
+            if (addresses.empty())
+                _stats.negative_hits++;
+            else
+                _stats.hits++;
+            lock.unlock();
+            callback(addresses);
+            return;
+        }
+
+        // Waits for the pending lookup of the host if any.
+        auto pending = _pending.find(key);
+        if (pending != _pending.end()) {
+            pending->second.push_back(std::move(callback));
+            _stats.coalesced++;
+            return;
+        }
+        _pending[key].push_back(std::move(callback));
+        _stats.lookups++;
+        lock.unlock();
+
+        // Submitting from a resolver thread could block it on the full queue it is supposed to empty, the lookup is run by this thread instead.
+        if (current_resolver == this) {
+            lookup(key);
+            return;
+        }
+        _pool.submit([this, key]() {
+            auto previous = current_resolver;
+            current_resolver = this;
+            lookup(key);
+            current_resolver = previous;
+        });
+    }
+
+    void DNSResolver::lookup(const std::string& host) {
+        std::vector<IPAddress> addresses;
+        try {
+            addresses = _lookup(host);
+        } catch (...) {
+            // A failing lookup is a failed resolution.
+        }
+        complete(host, addresses);
+    }
+
+    void DNSResolver::complete(const std::string& host, const std::vector<IPAddress>& addresses) {
+        std::vector<Callback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto now = std::chrono::steady_clock::now();
+            if (_cache.size() >= _cache_capacity) {
+                for (auto it = _cache.begin(); it != _cache.end();) {
+                    if (!(now < it->second.expiration))
+                        it = _cache.erase(it);
+                    else
+                        ++it;
+                }
+                if (_cache.size() >= _cache_capacity)
+                    _cache.clear();
+            }
+            _cache[host] = {addresses, now + (addresses.empty() ? _negative_ttl : _ttl)};
+
+            auto pending = _pending.find(host);
+            callbacks = std::move(pending->second);
+            _pending.erase(pending);
+        }
+        for (auto& callback : callbacks) {
+            try {
+                callback(addresses);
+            } catch (...) {
+                // A failing callback must not prevent the other ones.
+            }
+        }
+    }
+
+    std::future<std::vector<IPAddress>> DNSResolver::resolve_async(const std::string& host) {
+        auto promise = std::make_shared<std::promise<std::vector<IPAddress>>>();
+        auto future = promise->get_future();
+        resolve_async(host, [promise](const std::vector<IPAddress>& addresses) { promise->set_value(addresses); });
+        return future;
+    }
+
+    std::vector<IPAddress> DNSResolver::resolve(const std::string& host) {
+        // The lookup waited for may be queued behind the callback calling this.
+        if (current_resolver == this)
+            throw std::logic_error("Cannot wait for a resolution from a thread of the resolver.");
+        return resolve_async(host).get();
+    }
+
+    DNSResolverStats DNSResolver::get_stats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto stats = _stats;
+        stats.entries = _cache.size();
+        return stats;
+    }
+
+    void DNSResolver::clear_cache() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cache.clear();
+    }
+}
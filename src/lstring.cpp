@@ -8,79 +8,421 @@
  */
 
 #include "../include/lambdacommon/lstring.h"
+#include "../include/lambdacommon/unicode.h"
 #include <sstream>
 #include <iterator>
 #include <utility>
 #include <algorithm>
-#include <codecvt>
-#include <locale>
+#include <charconv>
+#include <cctype>
+#include <limits>
+#include <cerrno>
+#include <cstdlib>
+#include <type_traits>
+#include <cstring>
+#include <stdexcept>
 
 #ifdef LAMBDA_WINDOWS
 #  pragma warning(push)
 #  pragma warning(disable:4101)
 #endif
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define LAMBDACOMMON_CASE_SSE2
+#  include <emmintrin.h>
+#  if defined(__GNUC__) || defined(__clang__)
+#    define LAMBDACOMMON_CASE_AVX2
+#    include <immintrin.h>
+#  endif
+#endif
+
 namespace lambdacommon
 {
     namespace lstring
     {
-        template<typename Out>
-        void LAMBDACOMMON_API split(const std::string& s, char delim, Out result) {
-            std::stringstream ss;
-            ss.str(s);
-            std::string item;
-            while (std::getline(ss, item, delim)) {
-                *(result++) = item;
+        /*
+         * ASCII case folding kernels.
+         *
+         * Only the ASCII letters are folded, every other byte (including UTF-8 sequences) is kept as is, which is what the "C" locale does without any locale lookup.
+         * The SIMD versions classify 16 or 32 bytes at once: adding (128 - 'A') maps 'A'..'Z' to the 26 smallest signed bytes, so one signed comparison gives the mask
+         * of the letters to fold.
+         */
+
+        inline char ascii_to_lower(char c) {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+        }
+
+        inline char ascii_to_upper(char c) {
+            return c >= 'a' && c <= 'z' ? static_cast<char>(c & ~0x20) : c;
+        }
+
+        static void to_lower_scalar(const char* in, char* out, size_t size) {
+            for (size_t i = 0; i < size; i++)
+                out[i] = ascii_to_lower(in[i]);
+        }
+
+        static void to_upper_scalar(const char* in, char* out, size_t size) {
+            for (size_t i = 0; i < size; i++)
+                out[i] = ascii_to_upper(in[i]);
+        }
+
+        static bool equals_ignore_case_scalar(const char* a, const char* b, size_t size) {
+            for (size_t i = 0; i < size; i++)
+                if (ascii_to_lower(a[i]) != ascii_to_lower(b[i]))
+                    return false;
+            return true;
+        }
+
+#ifdef LAMBDACOMMON_CASE_SSE2
+
+        inline __m128i fold_case_sse2(__m128i v, char first) {
+            auto shifted = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(128 - first)));
+            auto is_letter = _mm_cmpgt_epi8(_mm_set1_epi8(-128 + 26), shifted);
+            return _mm_xor_si128(v, _mm_and_si128(is_letter, _mm_set1_epi8(0x20)));
+        }
+
+        static void to_lower_sse2(const char* in, char* out, size_t size) {
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16) {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), fold_case_sse2(v, 'A'));
             }
+            to_lower_scalar(in + i, out + i, size - i);
         }
 
-        std::vector<std::string> LAMBDACOMMON_API split(const std::string& s, char delimiter) {
+        static void to_upper_sse2(const char* in, char* out, size_t size) {
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16) {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), fold_case_sse2(v, 'a'));
+            }
+            to_upper_scalar(in + i, out + i, size - i);
+        }
+
+        static bool equals_ignore_case_sse2(const char* a, const char* b, size_t size) {
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16) {
+                auto va = fold_case_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), 'A');
+                auto vb = fold_case_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)), 'A');
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF)
+                    return false;
+            }
+            return equals_ignore_case_scalar(a + i, b + i, size - i);
+        }
+
+#endif
+#ifdef LAMBDACOMMON_CASE_AVX2
+
+        __attribute__((target("avx2"))) inline __m256i fold_case_avx2(__m256i v, char first) {
+            auto shifted = _mm256_add_epi8(v, _mm256_set1_epi8(static_cast<char>(128 - first)));
+            auto is_letter = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+            return _mm256_xor_si256(v, _mm256_and_si256(is_letter, _mm256_set1_epi8(0x20)));
+        }
+
+        __attribute__((target("avx2"))) static void to_lower_avx2(const char* in, char* out, size_t size) {
+            if (size < 32)
+                return to_lower_sse2(in, out, size);
+            size_t i = 0;
+            for (; i + 32 <= size; i += 32) {
+                auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), fold_case_avx2(v, 'A'));
+            }
+            // Leaving the AVX state before running SSE code avoids the transition penalty.
+            _mm256_zeroupper();
+            to_lower_sse2(in + i, out + i, size - i);
+        }
+
+        __attribute__((target("avx2"))) static void to_upper_avx2(const char* in, char* out, size_t size) {
+            if (size < 32)
+                return to_upper_sse2(in, out, size);
+            size_t i = 0;
+            for (; i + 32 <= size; i += 32) {
+                auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), fold_case_avx2(v, 'a'));
+            }
+            // Leaving the AVX state before running SSE code avoids the transition penalty.
+            _mm256_zeroupper();
+            to_upper_sse2(in + i, out + i, size - i);
+        }
+
+        __attribute__((target("avx2"))) static bool equals_ignore_case_avx2(const char* a, const char* b, size_t size) {
+            if (size < 32)
+                return equals_ignore_case_sse2(a, b, size);
+            size_t i = 0;
+            for (; i + 32 <= size; i += 32) {
+                auto va = fold_case_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), 'A');
+                auto vb = fold_case_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)), 'A');
+                if (static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb))) != 0xFFFFFFFFu)
+                    return false;
+            }
+            // Leaving the AVX state before running SSE code avoids the transition penalty.
+            _mm256_zeroupper();
+            return equals_ignore_case_sse2(a + i, b + i, size - i);
+        }
+
+#endif
+
+        struct CaseKernels
+        {
+            void (* to_lower)(const char*, char*, size_t);
+
+            void (* to_upper)(const char*, char*, size_t);
+
+            bool (* equals_ignore_case)(const char*, const char*, size_t);
+        };
+
+        /*
+         * Selects the best kernels for the running CPU, only done once.
+         */
+        static const CaseKernels& get_case_kernels() {
+            static const CaseKernels kernels = []() -> CaseKernels {
+#ifdef LAMBDACOMMON_CASE_AVX2
+                if (__builtin_cpu_supports("avx2"))
+                    return {to_lower_avx2, to_upper_avx2, equals_ignore_case_avx2};
+#endif
+#ifdef LAMBDACOMMON_CASE_SSE2
+                return {to_lower_sse2, to_upper_sse2, equals_ignore_case_sse2};
+#else
+                return {to_lower_scalar, to_upper_scalar, equals_ignore_case_scalar};
+#endif
+            }();
+            return kernels;
+        }
+
+        std::vector<std::string> LAMBDACOMMON_API split(std::string_view s, char delimiter) {
             std::vector<std::string> elems;
             split(s, delimiter, std::back_inserter(elems));
             return elems;
         }
 
         bool LAMBDACOMMON_API equals_ignore_case(const char a, const char b) {
-            return tolower(a) == tolower(b);
+            return ascii_to_lower(a) == ascii_to_lower(b);
         }
 
-        bool LAMBDACOMMON_API equals(std::string const& a, std::string const& b) {
-            if (a.length() == b.length())
-                return a == b;
-            else
-                return false;
+        bool LAMBDACOMMON_API equals(std::string_view a, std::string_view b) {
+            return a == b;
         }
 
-        bool LAMBDACOMMON_API equals_ignore_case(std::string const& a, std::string const& b) {
-            if (a.length() == b.length()) {
-                return std::equal(std::begin(a), std::end(a), std::begin(b), [](const char charA, const char charB) { return equals_ignore_case(charA, charB); });
-            } else
-                return false;
+        bool LAMBDACOMMON_API equals_ignore_case(std::string_view a, std::string_view b) {
+            return a.length() == b.length() && get_case_kernels().equals_ignore_case(a.data(), b.data(), a.length());
         }
 
-        std::string LAMBDACOMMON_API to_lower_case(const std::string& from) {
-            std::string result = from;
-            std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+        std::string LAMBDACOMMON_API to_lower_case(std::string_view from) {
+            std::string result(from.size(), '\0');
+            get_case_kernels().to_lower(from.data(), &result[0], from.size());
             return result;
         }
 
-        std::string LAMBDACOMMON_API to_upper_case(const std::string& from) {
-            std::string result = from;
-            std::transform(result.begin(), result.end(), result.begin(), ::toupper);
+        std::string LAMBDACOMMON_API to_upper_case(std::string_view from) {
+            std::string result(from.size(), '\0');
+            get_case_kernels().to_upper(from.data(), &result[0], from.size());
             return result;
         }
 
+        void LAMBDACOMMON_API to_lower_case_in_place(char* buffer, size_t size) {
+            get_case_kernels().to_lower(buffer, buffer, size);
+        }
+
+        void LAMBDACOMMON_API to_lower_case_in_place(std::string& str) {
+            to_lower_case_in_place(&str[0], str.size());
+        }
+
+        void LAMBDACOMMON_API to_upper_case_in_place(char* buffer, size_t size) {
+            get_case_kernels().to_upper(buffer, buffer, size);
+        }
+
+        void LAMBDACOMMON_API to_upper_case_in_place(std::string& str) {
+            to_upper_case_in_place(&str[0], str.size());
+        }
+
         std::string LAMBDACOMMON_API replace_all(std::string subject, const char& from, const char& to) {
-            return replace_all(std::move(subject), std::to_string(from), std::to_string(to));
+            std::replace(subject.begin(), subject.end(), from, to);
+            return subject;
         }
 
-        std::string LAMBDACOMMON_API replace_all(std::string subject, const std::string& from, const std::string& to) {
-            size_t start_pos = 0;
-            while ((start_pos = subject.find(from, start_pos)) != std::string::npos) {
-                subject.replace(start_pos, from.length(), to);
-                start_pos += to.length(); // Handles case where 'to' is a substring of 'from'
+        std::string LAMBDACOMMON_API replace_all(std::string subject, std::string_view from, std::string_view to) {
+            if (from.empty())
+                return subject;
+
+            size_t pos = subject.find(from);
+            if (pos == std::string::npos)
+                return subject;
+
+            if (to.size() <= from.size()) {
+                // The result isn't longer than the subject: compact it in place, the write head never passes the read head.
+                size_t write = pos;
+                while (pos != std::string::npos) {
+                    to.copy(&subject[write], to.size());
+                    write += to.size();
+                    size_t read = pos + from.size();
+                    pos = subject.find(from, read);
+                    size_t end = pos == std::string::npos ? subject.size() : pos;
+                    std::memmove(&subject[write], subject.data() + read, end - read);
+                    write += end - read;
+                }
+                subject.resize(write);
+                return subject;
             }
-            return subject;
+
+            size_t count = 0;
+            for (size_t i = pos; i != std::string::npos; i = subject.find(from, i + from.size()))
+                count++;
+
+            std::string result;
+            result.reserve(subject.size() + count * (to.size() - from.size()));
+            size_t read = 0;
+            for (; pos != std::string::npos; pos = subject.find(from, read)) {
+                result.append(subject, read, pos - read).append(to);
+                read = pos + from.size();
+            }
+            result.append(subject, read, std::string::npos);
+            return result;
+        }
+
+        /*
+         * Replacer
+         */
+
+        Replacer::Replacer(std::initializer_list<std::pair<std::string_view, std::string_view>> table) {
+            for (const auto&[from, to] : table) {
+                _from.emplace_back(from);
+                _to.emplace_back(to);
+            }
+            compile();
+        }
+
+        Replacer::Replacer(const std::vector<std::pair<std::string, std::string>>& table) {
+            for (const auto&[from, to] : table) {
+                _from.push_back(from);
+                _to.push_back(to);
+            }
+            compile();
+        }
+
+        void Replacer::compile() {
+            for (const auto& from : _from) {
+                if (from.empty())
+                    throw std::invalid_argument("Cannot replace an empty string.");
+                if (from.size() != 1)
+                    _single_bytes = false;
+                _first_bytes[static_cast<u8>(from[0])] = true;
+                for (unsigned char c : from)
+                    if (!_classes[c])
+                        _classes[c] = static_cast<u16>(_class_count++);
+            }
+
+            int first_bytes = 0;
+            for (int c = 0; c < 256; c++)
+                if (_first_bytes[c]) {
+                    first_bytes++;
+                    _single_first_byte = c;
+                }
+            if (first_bytes != 1)
+                _single_first_byte = -1;
+
+            // Root node.
+            _transitions.assign(_class_count, 0);
+            _matches.assign(1, 0);
+            for (size_t rule = 0; rule < _from.size(); rule++) {
+                size_t node = 0;
+                for (unsigned char c : _from[rule]) {
+                    size_t transition = node * _class_count + _classes[c];
+                    if (!_transitions[transition]) {
+                        _transitions[transition] = static_cast<u32>(_matches.size());
+                        _matches.push_back(0);
+                        _transitions.resize(_transitions.size() + _class_count, 0);
+                    }
+                    node = _transitions[transition];
+                }
+                // The first rule of the table wins on duplicates.
+                if (!_matches[node])
+                    _matches[node] = static_cast<u32>(rule + 1);
+            }
+        }
+
+        template<typename Callback>
+        void Replacer::scan(std::string_view subject, Callback callback) const {
+            const auto* data = reinterpret_cast<const u8*>(subject.data());
+            size_t size = subject.size(), i = 0;
+            while (i < size) {
+                // Find the next byte which can start a pattern.
+                if (_single_first_byte >= 0) {
+                    auto next = static_cast<const u8*>(std::memchr(data + i, _single_first_byte, size - i));
+                    if (!next)
+                        return;
+                    i = static_cast<size_t>(next - data);
+                } else {
+                    while (i < size && !_first_bytes[data[i]])
+                        i++;
+                    if (i == size)
+                        return;
+                }
+
+                if (_single_bytes) {
+                    callback(i, _matches[_transitions[_classes[data[i]]]] - 1);
+                    i++;
+                    continue;
+                }
+
+                // Walk the trie to find the longest pattern starting here.
+                size_t node = 0, best_rule = 0, best_length = 0;
+                for (size_t j = i; j < size; j++) {
+                    auto c = _classes[data[j]];
+                    if (!c || !(node = _transitions[node * _class_count + c]))
+                        break;
+                    if (_matches[node]) {
+                        best_rule = _matches[node];
+                        best_length = j - i + 1;
+                    }
+                }
+                if (best_rule) {
+                    callback(i, best_rule - 1);
+                    i += best_length;
+                } else
+                    i++;
+            }
+        }
+
+        size_t Replacer::get_result_size(std::string_view subject) const {
+            size_t size = subject.size();
+            scan(subject, [this, &size](size_t, size_t rule) { size = size - _from[rule].size() + _to[rule].size(); });
+            return size;
+        }
+
+        std::string Replacer::replace_all(std::string_view subject) const {
+            std::string result;
+            replace_all(subject, result);
+            return result;
+        }
+
+        size_t Replacer::replace_all(std::string_view subject, std::string& output) const {
+            size_t count = 0, size = subject.size();
+            scan(subject, [this, &count, &size](size_t, size_t rule) {
+                count++;
+                size = size - _from[rule].size() + _to[rule].size();
+            });
+            if (!count) {
+                output.append(subject);
+                return 0;
+            }
+
+            // Size the output once then write the result directly in it.
+            size_t write = output.size(), read = 0;
+            output.resize(write + size);
+            char* out = &output[0];
+            scan(subject, [&](size_t pos, size_t rule) {
+                std::memcpy(out + write, subject.data() + read, pos - read);
+                write += pos - read;
+                std::memcpy(out + write, _to[rule].data(), _to[rule].size());
+                write += _to[rule].size();
+                read = pos + _from[rule].size();
+            });
+            std::memcpy(out + write, subject.data() + read, subject.size() - read);
+            return count;
+        }
+
+        std::string LAMBDACOMMON_API replace_all(std::string_view subject, std::initializer_list<std::pair<std::string_view, std::string_view>> table) {
+            return Replacer(table).replace_all(subject);
         }
 
         std::string LAMBDACOMMON_API to_string(bool value) {
@@ -107,132 +449,234 @@ namespace lambdacommon
             return result;
         }
 
-        bool LAMBDACOMMON_API starts_with(const std::string& str, const std::string& prefix) {
+        bool LAMBDACOMMON_API starts_with(std::string_view str, std::string_view prefix) {
             return str.size() >= prefix.size() && 0 == str.compare(0, prefix.size(), prefix);
         }
 
-        bool LAMBDACOMMON_API starts_with_ignore_case(const std::string& str, const std::string& prefix) {
-            return starts_with(to_lower_case(str), to_lower_case(prefix));
+        bool LAMBDACOMMON_API starts_with_ignore_case(std::string_view str, std::string_view prefix) {
+            return str.size() >= prefix.size() && equals_ignore_case(str.substr(0, prefix.size()), prefix);
         }
 
-        bool LAMBDACOMMON_API ends_with(const std::string& str, const std::string& suffix) {
+        bool LAMBDACOMMON_API ends_with(std::string_view str, std::string_view suffix) {
             return str.size() >= suffix.size() && 0 == str.compare(str.size() - suffix.size(), suffix.size(), suffix);
         }
 
-        bool LAMBDACOMMON_API ends_with_ignore_case(const std::string& str, const std::string& suffix) {
-            return ends_with(to_lower_case(str), to_lower_case(suffix));
+        bool LAMBDACOMMON_API ends_with_ignore_case(std::string_view str, std::string_view suffix) {
+            return str.size() >= suffix.size() && equals_ignore_case(str.substr(str.size() - suffix.size()), suffix);
         }
 
-        const std::string LAMBDACOMMON_API merge_path(const std::string& parent, const std::string& child) {
-            auto merged = parent;
-            if (ends_with(parent, "/") || starts_with(child, "/"))
-                merged += child;
-            else
-                merged += '/' + child;
+        const std::string LAMBDACOMMON_API merge_path(std::string_view parent, std::string_view child) {
+            std::string merged;
+            merged.reserve(parent.size() + child.size() + 1);
+            merged += parent;
+            if (!(ends_with(parent, "/") || starts_with(child, "/")))
+                merged += '/';
+            merged += child;
             return merged;
         }
 
-        std::optional<int> LAMBDACOMMON_API parse_int(const std::string& integer, int base) {
-            try {
-                return std::stoi(integer, nullptr, base);
-            } catch (const std::invalid_argument& error) {
-                return std::nullopt;
-            } catch (const std::out_of_range& error) {
-                return std::nullopt;
-            }
+        inline bool is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
         }
 
-        std::optional<long> LAMBDACOMMON_API parse_long(const std::string& long_number, int base) {
-            try {
-                return std::stol(long_number, nullptr, base);
-            } catch (const std::invalid_argument& error) {
-                return std::nullopt;
-            } catch (const std::out_of_range& error) {
-                return std::nullopt;
+        struct IntegerSyntax
+        {
+            bool skip_leading_spaces;
+            bool skip_trailing_spaces;
+            bool allow_plus_and_prefix;
+            bool allow_trailing_chars;
+        };
+
+        /*
+         * Parses an integer with std::from_chars, the magnitude is parsed as unsigned so the sign and the base prefix can be handled here.
+         */
+        template<typename T>
+        std::errc parse_integer(std::string_view str, T& value, int base, IntegerSyntax syntax) {
+            size_t i = 0, end = str.size();
+            if (syntax.skip_leading_spaces)
+                while (i < end && is_space(str[i]))
+                    i++;
+            if (syntax.skip_trailing_spaces)
+                while (end > i && is_space(str[end - 1]))
+                    end--;
+
+            bool negative = false;
+            if (i < end && (str[i] == '-' || (syntax.allow_plus_and_prefix && str[i] == '+')))
+                negative = str[i++] == '-';
+            if (negative && std::is_unsigned_v<T>)
+                return std::errc::invalid_argument;
+            if (syntax.allow_plus_and_prefix) {
+                if ((base == 16 || base == 0) && i + 2 < end && str[i] == '0' && (str[i + 1] == 'x' || str[i + 1] == 'X'))
+                    i += 2, base = 16;
+                else if (base == 0)
+                    base = i + 1 < end && str[i] == '0' ? 8 : 10;
             }
+            if (base < 2 || base > 36)
+                return std::errc::invalid_argument;
+
+            using UT = std::make_unsigned_t<T>;
+            UT magnitude = 0;
+            auto first = str.data() + i, last = str.data() + end;
+            auto[ptr, ec] = std::from_chars(first, last, magnitude, base);
+            if (ec != std::errc())
+                return ec;
+            if (ptr != last && !syntax.allow_trailing_chars)
+                return std::errc::invalid_argument;
+
+            if (negative) {
+                if (magnitude > static_cast<UT>(std::numeric_limits<T>::max()) + 1)
+                    return std::errc::result_out_of_range;
+                value = static_cast<T>(0 - magnitude);
+            } else {
+                if (magnitude > static_cast<UT>(std::numeric_limits<T>::max()))
+                    return std::errc::result_out_of_range;
+                value = static_cast<T>(magnitude);
+            }
+            return std::errc();
         }
 
-        namespace utf8
-        {
-            char32_t LAMBDACOMMON_API to_utf32(const std::string& character) {
-                return to_utf32(character.c_str());
+        /*
+         * std::stol-like syntax: leading whitespaces, sign, base prefix and trailing characters are accepted.
+         */
+        static constexpr IntegerSyntax STOL_SYNTAX{true, false, true, true};
+
+        static constexpr IntegerSyntax get_integer_syntax(ParseMode mode) {
+            return mode == PARSE_LENIENT ? IntegerSyntax{true, true, true, false} : IntegerSyntax{false, false, false, false};
+        }
+
+        template<typename T>
+        std::errc parse_float(std::string_view str, T& value, ParseMode mode) {
+            size_t i = 0, end = str.size();
+            if (mode == PARSE_LENIENT) {
+                while (i < end && is_space(str[i]))
+                    i++;
+                while (end > i && is_space(str[end - 1]))
+                    end--;
+                if (i < end && str[i] == '+' && (i + 1 == end || str[i + 1] != '-'))
+                    i++;
             }
+            if (i == end)
+                return std::errc::invalid_argument;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            auto last = str.data() + end;
+            auto[ptr, ec] = std::from_chars(str.data() + i, last, value);
+            if (ec != std::errc())
+                return ec;
+            if (ptr != last)
+                return std::errc::invalid_argument;
+            return std::errc();
+#else
+            // The standard library doesn't provide std::from_chars for floating points, fallback to strtod (which is locale dependent) on a stack copy.
+            char buffer[128];
+            if (end - i >= sizeof(buffer) || is_space(str[i]))
+                return std::errc::invalid_argument;
+            str.copy(buffer, end - i, i);
+            buffer[end - i] = '\0';
+            char* ptr;
+            errno = 0;
+            auto result = std::strtod(buffer, &ptr);
+            if (ptr != buffer + (end - i))
+                return std::errc::invalid_argument;
+            if (errno == ERANGE || result > std::numeric_limits<T>::max() || result < std::numeric_limits<T>::lowest())
+                return std::errc::result_out_of_range;
+            value = static_cast<T>(result);
+            return std::errc();
+#endif
+        }
 
-            char32_t LAMBDACOMMON_API to_utf32(const char* character) {
-                auto result = static_cast<char32_t>(-1);
+        std::errc LAMBDACOMMON_API parse(std::string_view str, i8& value, int base, ParseMode mode) {
+            return parse_integer(str, value, base, get_integer_syntax(mode));
+        }
 
-                if (!character)
-                    return result;
+        std::errc LAMBDACOMMON_API parse(std::string_view str, i16& value, int base, ParseMode mode) {
+            return parse_integer(str, value, base, get_integer_syntax(mode));
+        }
 
-                if ((character[0] & 0x80) == 0x0)
-                    result = (char32_t) character[0];
+        std::errc LAMBDACOMMON_API parse(std::string_view str, i32& value, int base, ParseMode mode) {
+            return parse_integer(str, value, base, get_integer_syntax(mode));
+        }
 
-                if ((character[0] & 0xC0) == 0xC0)
-                    result = static_cast<char32_t>(((character[0] & 0x3F) << 6) | (character[1] & 0x3F));
+        std::errc LAMBDACOMMON_API parse(std::string_view str, i64& value, int base, ParseMode mode) {
+            return parse_integer(str, value, base, get_integer_syntax(mode));
+        }
 
-                if ((character[0] & 0xE0) == 0xE0)
-                    result = static_cast<char32_t>(((character[0] & 0x1F) << (6 + 6)) | ((character[1] & 0x3F) << 6) |
-                                                   (character[2] & 0x3F));
+        std::errc LAMBDACOMMON_API parse(std::string_view str, u8& value, int base, ParseMode mode) {
+            return parse_integer(str, value, base, get_integer_syntax(mode));
+        }
 
-                if ((character[0] & 0xF0) == 0xF0)
-                    result = static_cast<char32_t>(((character[0] & 0x0F) << (6 + 6 + 6)) |
-                                                   ((character[1] & 0x3F) << (6 + 6)) |
-                                                   ((character[2] & 0x3F) << 6) | (character[3] & 0x3F));
+        std::errc LAMBDACOMMON_API parse(std::string_view str, u16& value, int base, ParseMode mode) {
+            return parse_integer(str, value, base, get_integer_syntax(mode));
+        }
 
-                if ((character[0] & 0xF8) == 0xF8)
-                    result = static_cast<char32_t>(((character[0] & 0x07) << (6 + 6 + 6 + 6)) |
-                                                   ((character[1] & 0x3F) << (6 + 6 + 6)) |
-                                                   ((character[2] & 0x3F) << (6 + 6)) | ((character[3] & 0x3F) << 6) |
-                                                   (character[4] & 0x3F));
+        std::errc LAMBDACOMMON_API parse(std::string_view str, u32& value, int base, ParseMode mode) {
+            return parse_integer(str, value, base, get_integer_syntax(mode));
+        }
 
-                return result;
-            }
+        std::errc LAMBDACOMMON_API parse(std::string_view str, u64& value, int base, ParseMode mode) {
+            return parse_integer(str, value, base, get_integer_syntax(mode));
         }
 
-#ifdef LAMBDA_WINDOWS
-#  ifndef __GNUC__
-#    define CONVERT_WSTRING_WINDOWS_WAY
-#  endif
-#endif
+        std::errc LAMBDACOMMON_API parse(std::string_view str, f32& value, ParseMode mode) {
+            return parse_float(str, value, mode);
+        }
 
-#ifdef CONVERT_WSTRING_WINDOWS_WAY
-#  include <Windows.h>
+        std::errc LAMBDACOMMON_API parse(std::string_view str, f64& value, ParseMode mode) {
+            return parse_float(str, value, mode);
+        }
 
-        std::string LAMBDACOMMON_API from_wstring_to_utf8(const std::wstring &wstring)
-        {
-            std::string string;
-            if (!wstring.empty()) {
-                int size = WideCharToMultiByte(CP_UTF8, 0, &wstring[0], (int) wstring.size(), nullptr, 0, nullptr, nullptr);
-                string.resize(size, 0);
-                WideCharToMultiByte(CP_UTF8, 0, &wstring[0], (int) wstring.size(), &string[0], size, nullptr, nullptr);
-            }
-            return string;
+        std::optional<int> LAMBDACOMMON_API parse_int(std::string_view integer, int base) {
+            int value;
+            if (parse_integer(integer, value, base, STOL_SYNTAX) != std::errc())
+                return std::nullopt;
+            return value;
         }
 
-        std::wstring LAMBDACOMMON_API from_utf8_to_wstring(const std::string &string)
-        {
-            int size = MultiByteToWideChar(CP_UTF8, 0, &string[0], (int) string.size(), nullptr, 0);
-            std::wstring result(size, 0);
-            MultiByteToWideChar(CP_UTF8, 0, &string[0], (int) string.size(), &result[0], size);
-            return result;
+        std::optional<long> LAMBDACOMMON_API parse_long(std::string_view long_number, int base) {
+            long value;
+            if (parse_integer(long_number, value, base, STOL_SYNTAX) != std::errc())
+                return std::nullopt;
+            return value;
         }
 
-#else
+        namespace utf8
+        {
+            char32_t LAMBDACOMMON_API to_utf32(std::string_view character) {
+                // Decodes only the first code point, the conversion stops with OUTPUT_TOO_SMALL right after it.
+                char32_t result;
+                auto status = unicode::convert_utf8_to_utf32(character, &result, 1);
+                if (status.written != 1)
+                    return static_cast<char32_t>(-1);
+                return result;
+            }
 
-        std::string LAMBDACOMMON_API from_wstring_to_utf8(const std::wstring& wstring) {
+            char32_t LAMBDACOMMON_API to_utf32(const char* character) {
+                if (!character)
+                    return static_cast<char32_t>(-1);
+                return to_utf32(std::string_view{character, strnlen(character, 4)});
+            }
+        }
+
+        std::string LAMBDACOMMON_API from_wstring_to_utf8(std::wstring_view wstring) {
+            if (auto result = unicode::wstring_to_utf8(wstring))
+                return std::move(*result);
+            // Invalid input (unpaired surrogates for example), keep the low byte of each code unit like previous versions.
             std::string out;
+            out.reserve(wstring.size());
             std::copy(wstring.begin(), wstring.end(), std::back_inserter(out));
             return out;
         }
 
-        std::wstring LAMBDACOMMON_API from_utf8_to_wstring(const std::string& string) {
+        std::wstring LAMBDACOMMON_API from_utf8_to_wstring(std::string_view string) {
+            if (auto result = unicode::utf8_to_wstring(string))
+                return std::move(*result);
+            // Invalid UTF-8, widen each byte like previous versions.
             std::wstring out;
-            std::copy(string.begin(), string.end(), std::back_inserter(out));
+            out.reserve(string.size());
+            for (char c : string)
+                out.push_back(static_cast<wchar_t>(static_cast<u8>(c)));
             return out;
         }
 
-#endif
-
         namespace stream
         {
             std::ostream LAMBDACOMMON_API& operator<<(std::ostream& stream, const Object& object) {
@@ -240,5 +684,79 @@ namespace lambdacommon
                 return stream;
             }
         }
+
+        /*
+         * Legacy std::string entry points.
+         *
+         * They are not declared in the header anymore (the std::string_view overloads accept std::string, C strings and views without ambiguity),
+         * they are only kept exported so binaries linked against older versions of λcommon still resolve them.
+         */
+
+        std::vector<std::string> LAMBDACOMMON_API split(const std::string& s, char delimiter) {
+            return split(std::string_view{s}, delimiter);
+        }
+
+        bool LAMBDACOMMON_API equals(const std::string& a, const std::string& b) {
+            return equals(std::string_view{a}, std::string_view{b});
+        }
+
+        bool LAMBDACOMMON_API equals_ignore_case(const std::string& a, const std::string& b) {
+            return equals_ignore_case(std::string_view{a}, std::string_view{b});
+        }
+
+        std::string LAMBDACOMMON_API to_lower_case(const std::string& from) {
+            return to_lower_case(std::string_view{from});
+        }
+
+        std::string LAMBDACOMMON_API to_upper_case(const std::string& from) {
+            return to_upper_case(std::string_view{from});
+        }
+
+        std::string LAMBDACOMMON_API replace_all(std::string subject, const std::string& from, const std::string& to) {
+            return replace_all(std::move(subject), std::string_view{from}, std::string_view{to});
+        }
+
+        bool LAMBDACOMMON_API starts_with(const std::string& str, const std::string& prefix) {
+            return starts_with(std::string_view{str}, std::string_view{prefix});
+        }
+
+        bool LAMBDACOMMON_API starts_with_ignore_case(const std::string& str, const std::string& prefix) {
+            return starts_with_ignore_case(std::string_view{str}, std::string_view{prefix});
+        }
+
+        bool LAMBDACOMMON_API ends_with(const std::string& str, const std::string& suffix) {
+            return ends_with(std::string_view{str}, std::string_view{suffix});
+        }
+
+        bool LAMBDACOMMON_API ends_with_ignore_case(const std::string& str, const std::string& suffix) {
+            return ends_with_ignore_case(std::string_view{str}, std::string_view{suffix});
+        }
+
+        const std::string LAMBDACOMMON_API merge_path(const std::string& parent, const std::string& child) {
+            return merge_path(std::string_view{parent}, std::string_view{child});
+        }
+
+        std::optional<int> LAMBDACOMMON_API parse_int(const std::string& integer, int base) {
+            return parse_int(std::string_view{integer}, base);
+        }
+
+        std::optional<long> LAMBDACOMMON_API parse_long(const std::string& long_number, int base) {
+            return parse_long(std::string_view{long_number}, base);
+        }
+
+        std::string LAMBDACOMMON_API from_wstring_to_utf8(const std::wstring& wstring) {
+            return from_wstring_to_utf8(std::wstring_view{wstring});
+        }
+
+        std::wstring LAMBDACOMMON_API from_utf8_to_wstring(const std::string& string) {
+            return from_utf8_to_wstring(std::string_view{string});
+        }
+
+        namespace utf8
+        {
+            char32_t LAMBDACOMMON_API to_utf32(const std::string& character) {
+                return to_utf32(std::string_view{character});
+            }
+        }
     }
 }
@@ -8,7 +8,17 @@
  */
 
 #include "../include/lambdacommon/resources.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
+#include <unordered_map>
 #include <tuple>
 #include <fstream>
 #include <sstream>
@@ -17,6 +27,12 @@
 #ifdef LAMBDA_WINDOWS
 #  pragma warning(push)
 #  pragma warning(disable:4101)
+#  include <Windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
 #endif
 
 namespace lambdacommon
@@ -77,6 +93,448 @@ namespace lambdacommon
         return std::tie(_namespace, _name) < std::tie(other._namespace, other._name);
     }
 
+    /*
+     * InternedIdentifier
+     */
+
+    /*
+     * Global symbol table of the interned identifiers.
+     *
+     * Symbols are stored in fixed-size chunks which are never moved nor freed, so resolving a handle doesn't need any lock.
+     * The lookup by string is split into shards, each guarded by a shared mutex, so concurrent interning of existing identifiers rarely contends.
+     */
+    class SymbolTable
+    {
+    public:
+        struct Symbol
+        {
+            std::string value;
+            size_t separator;
+        };
+
+    private:
+        static constexpr u32 CHUNK_BITS = 12;
+        static constexpr u32 CHUNK_SIZE = 1u << CHUNK_BITS;
+        static constexpr u32 CHUNK_COUNT = 1u << 14;
+        static constexpr u32 SHARD_COUNT = 64;
+        static constexpr u32 MAX_SYMBOLS = CHUNK_SIZE * CHUNK_COUNT;
+
+        struct Shard
+        {
+            std::shared_mutex mutex;
+            // Hash to handles, the strings are compared with the symbols so they are stored only once.
+            std::unordered_multimap<u32, u32> handles;
+        };
+
+        std::array<std::atomic<Symbol*>, CHUNK_COUNT> _chunks{};
+        std::mutex _append_mutex;
+        u32 _size = 0;
+        std::array<Shard, SHARD_COUNT> _shards;
+
+        u32 find(const Shard& shard, std::string_view value, u32 hash) const {
+            auto range = shard.handles.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it)
+                if (get(it->second).value == value)
+                    return it->second;
+            return MAX_SYMBOLS;
+        }
+
+        u32 append(std::string_view value, size_t separator) {
+            std::lock_guard<std::mutex> lock(_append_mutex);
+            u32 handle = _size;
+            if (handle == MAX_SYMBOLS)
+                throw std::length_error("Too many interned identifiers.");
+            auto& chunk = _chunks[handle >> CHUNK_BITS];
+            auto symbols = chunk.load(std::memory_order_relaxed);
+            if (!symbols) {
+                symbols = new Symbol[CHUNK_SIZE];
+                chunk.store(symbols, std::memory_order_release);
+            }
+            symbols[handle & (CHUNK_SIZE - 1)] = {std::string(value), separator};
+            _size++;
+            return handle;
+        }
+
+    public:
+        u32 intern(std::string_view value, size_t separator, u32 hash) {
+            auto& shard = _shards[hash % SHARD_COUNT];
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                if (auto handle = find(shard, value, hash); handle != MAX_SYMBOLS)
+                    return handle;
+            }
+
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            // Another thread may have interned it between the two locks.
+            if (auto handle = find(shard, value, hash); handle != MAX_SYMBOLS)
+                return handle;
+            auto handle = append(value, separator);
+            shard.handles.emplace(hash, handle);
+            return handle;
+        }
+
+        const Symbol& get(u32 handle) const {
+            return _chunks[handle >> CHUNK_BITS].load(std::memory_order_acquire)[handle & (CHUNK_SIZE - 1)];
+        }
+
+        static SymbolTable& get_instance() {
+            // Never destroyed so interned identifiers stay valid in static destructors.
+            static auto* table = new SymbolTable();
+            return *table;
+        }
+    };
+
+    InternedIdentifier::InternedIdentifier(const IdentifierLiteral& literal)
+            : _handle(SymbolTable::get_instance().intern(literal.value, literal.separator, literal.hash)), _hash(literal.hash) {}
+
+    InternedIdentifier::InternedIdentifier(std::string_view name) : _hash(detail::fnv1a_32(name)) {
+        auto separator = name.find(':');
+        if (separator == 0 || separator == std::string_view::npos)
+            throw std::invalid_argument("The resource name '" + std::string(name) + "' is invalid.");
+        _handle = SymbolTable::get_instance().intern(name, separator, _hash);
+    }
+
+    InternedIdentifier::InternedIdentifier(std::string_view domain, std::string_view name) : _handle(0), _hash(0) {
+        if (domain.empty() || domain.find(':') != std::string_view::npos)
+            throw std::invalid_argument("The resource namespace '" + std::string(domain) + "' is invalid.");
+        std::string value;
+        value.reserve(domain.size() + 1 + name.size());
+        value.append(domain).append(1, ':').append(name);
+        _hash = detail::fnv1a_32(value);
+        _handle = SymbolTable::get_instance().intern(value, domain.size(), _hash);
+    }
+
+    InternedIdentifier::InternedIdentifier(const Identifier& identifier) : InternedIdentifier(identifier.get_domain(), identifier.get_name()) {}
+
+    std::string_view InternedIdentifier::get_domain() const {
+        auto& symbol = SymbolTable::get_instance().get(_handle);
+        return std::string_view{symbol.value}.substr(0, symbol.separator);
+    }
+
+    std::string_view InternedIdentifier::get_name() const {
+        auto& symbol = SymbolTable::get_instance().get(_handle);
+        return std::string_view{symbol.value}.substr(symbol.separator + 1);
+    }
+
+    std::string_view InternedIdentifier::to_string_view() const {
+        return SymbolTable::get_instance().get(_handle).value;
+    }
+
+    std::string InternedIdentifier::to_string() const {
+        return std::string(to_string_view());
+    }
+
+    Identifier InternedIdentifier::to_identifier() const {
+        return {std::string(get_domain()), std::string(get_name())};
+    }
+
+    InternedIdentifier::operator Identifier() const {
+        return to_identifier();
+    }
+
+    /*
+     * ResourceView
+     */
+
+    ResourceView::ResourceView(std::shared_ptr<const void> owner, std::string_view bytes) noexcept : _owner(std::move(owner)), _bytes(bytes) {}
+
+    ResourceView ResourceView::from_string(std::string content) {
+        auto owner = std::make_shared<const std::string>(std::move(content));
+        return {owner, *owner};
+    }
+
+    /*
+     * ResourceViewReader
+     */
+
+    ResourceViewReader::ResourceViewReader(ResourceView view) : _view(std::move(view)) {}
+
+    size_t ResourceViewReader::read(char* buffer, size_t size) {
+        auto count = std::min(size, _view.size() - _position);
+        std::memcpy(buffer, _view.data() + _position, count);
+        _position += count;
+        return count;
+    }
+
+    bool ResourceViewReader::seek(u64 offset) {
+        if (offset > _view.size())
+            return false;
+        _position = static_cast<size_t>(offset);
+        return true;
+    }
+
+    u64 ResourceViewReader::tell() const {
+        return _position;
+    }
+
+    std::optional<u64> ResourceViewReader::size_hint() const {
+        return _view.size();
+    }
+
+    /*
+     * Files smaller than this are read into memory, memory-mapping them would waste most of a page and cost more syscalls.
+     */
+    constexpr size_t MMAP_THRESHOLD = 16 * 1024;
+
+    /*
+     * Identifies a version of a file by its modification time and its size.
+     */
+    struct FileVersion
+    {
+        u64 modification_time = 0;
+        u64 size = 0;
+
+        bool operator==(const FileVersion& other) const {
+            return modification_time == other.modification_time && size == other.size;
+        }
+    };
+
+#ifndef LAMBDA_WINDOWS
+    inline FileVersion get_file_version(const struct ::stat& st) {
+#  ifdef __APPLE__
+        auto time = st.st_mtimespec;
+#  else
+        auto time = st.st_mtim;
+#  endif
+        return {static_cast<u64>(time.tv_sec) * 1000000000ull + static_cast<u64>(time.tv_nsec), static_cast<u64>(st.st_size)};
+    }
+#endif
+
+    /*
+     * Gets the version of a file with a single system call.
+     */
+    bool get_file_version(const fs::path& path, FileVersion& version) {
+#ifdef LAMBDA_WINDOWS
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+            return false;
+        version.modification_time = (static_cast<u64>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+        version.size = (static_cast<u64>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        return true;
+#else
+        struct ::stat st{};
+        if (::stat(path.c_str(), &st) != 0)
+            return false;
+        version = get_file_version(st);
+        return true;
+#endif
+    }
+
+    /*
+     * Loads the content of a file, memory-mapped if the file is large enough.
+     */
+    ResourceView map_file(const fs::path& path, FileVersion* version = nullptr) {
+#ifdef LAMBDA_WINDOWS
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return {};
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size)) {
+            CloseHandle(file);
+            return {};
+        }
+        auto size = static_cast<size_t>(file_size.QuadPart);
+        if (version) {
+            FILETIME write_time;
+            GetFileTime(file, nullptr, nullptr, &write_time);
+            version->modification_time = (static_cast<u64>(write_time.dwHighDateTime) << 32) | write_time.dwLowDateTime;
+            version->size = size;
+        }
+        if (size >= MMAP_THRESHOLD) {
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file);
+            if (!mapping)
+                return {};
+            auto address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+            if (!address)
+                return {};
+            std::shared_ptr<const void> owner(address, [](const void* p) { UnmapViewOfFile(p); });
+            return {owner, {static_cast<const char*>(address), size}};
+        }
+        std::shared_ptr<char> buffer(new char[size > 0 ? size : 1], std::default_delete<char[]>());
+        size_t read = 0;
+        while (read < size) {
+            DWORD count;
+            if (!ReadFile(file, buffer.get() + read, static_cast<DWORD>(size - read), &count, nullptr) || count == 0)
+                break;
+            read += count;
+        }
+        CloseHandle(file);
+        return {buffer, {buffer.get(), read}};
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return {};
+        struct ::stat st{};
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            return {};
+        }
+        auto size = static_cast<size_t>(st.st_size);
+        if (version)
+            *version = get_file_version(st);
+        if (size >= MMAP_THRESHOLD) {
+            auto address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (address == MAP_FAILED)
+                return {};
+            std::shared_ptr<const void> owner(address, [size](const void* p) { ::munmap(const_cast<void*>(p), size); });
+            return {owner, {static_cast<const char*>(address), size}};
+        }
+        std::shared_ptr<char> buffer(new char[size > 0 ? size : 1], std::default_delete<char[]>());
+        size_t read = 0;
+        while (read < size) {
+            auto count = ::read(fd, buffer.get() + read, size - read);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count <= 0)
+                break;
+            read += static_cast<size_t>(count);
+        }
+        ::close(fd);
+        return {buffer, {buffer.get(), read}};
+#endif
+    }
+
+    /*
+     * Reads a file with unbuffered system calls, the buffer of the caller is the only buffer.
+     */
+    class FileResourceReader : public ResourceReader
+    {
+    private:
+#ifdef LAMBDA_WINDOWS
+        HANDLE _file;
+#else
+        int _fd;
+#endif
+        u64 _size;
+        u64 _position = 0;
+
+    public:
+#ifdef LAMBDA_WINDOWS
+        FileResourceReader(HANDLE file, u64 size) : _file(file), _size(size) {}
+
+        ~FileResourceReader() override {
+            CloseHandle(_file);
+        }
+#else
+        FileResourceReader(int fd, u64 size) : _fd(fd), _size(size) {}
+
+        ~FileResourceReader() override {
+            ::close(_fd);
+        }
+#endif
+
+        FileResourceReader(const FileResourceReader& other) = delete;
+
+        FileResourceReader& operator=(const FileResourceReader& other) = delete;
+
+        static std::unique_ptr<ResourceReader> open(const fs::path& path) {
+#ifdef LAMBDA_WINDOWS
+            HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return nullptr;
+            LARGE_INTEGER file_size;
+            if (!GetFileSizeEx(file, &file_size)) {
+                CloseHandle(file);
+                return nullptr;
+            }
+            return std::make_unique<FileResourceReader>(file, static_cast<u64>(file_size.QuadPart));
+#else
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return nullptr;
+            struct ::stat st{};
+            if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+                ::close(fd);
+                return nullptr;
+            }
+#  ifdef POSIX_FADV_SEQUENTIAL
+            // Larger read-ahead, the resource is read from the beginning to the end.
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#  endif
+            return std::make_unique<FileResourceReader>(fd, static_cast<u64>(st.st_size));
+#endif
+        }
+
+        size_t read(char* buffer, size_t size) override {
+            size_t read = 0;
+            while (read < size) {
+#ifdef LAMBDA_WINDOWS
+                DWORD count;
+                auto chunk = static_cast<DWORD>(std::min<size_t>(size - read, 1u << 30));
+                if (!ReadFile(_file, buffer + read, chunk, &count, nullptr) || count == 0)
+                    break;
+#else
+                auto count = ::read(_fd, buffer + read, size - read);
+                if (count < 0 && errno == EINTR)
+                    continue;
+                if (count <= 0)
+                    break;
+#endif
+                read += static_cast<size_t>(count);
+            }
+            _position += read;
+            return read;
+        }
+
+        bool seek(u64 offset) override {
+#ifdef LAMBDA_WINDOWS
+            LARGE_INTEGER distance;
+            distance.QuadPart = static_cast<LONGLONG>(offset);
+            if (!SetFilePointerEx(_file, distance, nullptr, FILE_BEGIN))
+                return false;
+#else
+            if (::lseek(_fd, static_cast<off_t>(offset), SEEK_SET) < 0)
+                return false;
+#endif
+            _position = offset;
+            return true;
+        }
+
+        [[nodiscard]] u64 tell() const override {
+            return _position;
+        }
+
+        [[nodiscard]] std::optional<u64> size_hint() const override {
+            return _size;
+        }
+    };
+
+    /*
+     * Gets the key of a resource, formatted as "namespace:path.extension".
+     */
+    inline std::string make_resource_key(const Identifier& resource, const std::string& extension) {
+        std::string key;
+        key.reserve(resource.get_domain().size() + resource.get_name().size() + extension.size() + 2);
+        key.append(resource.get_domain()).append(1, ':').append(resource.get_name());
+        if (!extension.empty())
+            key.append(1, '.').append(extension);
+        return key;
+    }
+
+    /*
+     * Lists the regular files of a directory tree, with their path relative to the root.
+     */
+    void list_resource_files(const fs::path& directory, const std::string& relative, std::vector<std::pair<std::string, fs::path>>& files) {
+        std::error_code ec;
+        for (auto it = fs::directory_iterator(directory, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            const fs::path& path = *it;
+            auto name = path.get_filename().to_generic_string();
+            auto status = it->status(ec);
+            if (ec)
+                break;
+            if (fs::is_directory(status))
+                list_resource_files(path, relative.empty() ? name : relative + '/' + name, files);
+            else if (fs::is_file(status) && !relative.empty())
+                files.emplace_back(relative + '/' + name, path);
+        }
+        if (ec)
+            throw std::runtime_error("Cannot list the resources of " + directory.to_string() + ": " + ec.message() + ".");
+    }
+
     /*
      * ResourcesManager
      */
@@ -96,6 +554,27 @@ namespace lambdacommon
         return _id == other._id;
     }
 
+    ResourceView ResourcesManager::load_resource_view(const Identifier& resource, const std::string& extension) const {
+        if (!has_resource(resource, extension))
+            return {};
+        return ResourceView::from_string(load_resource(resource, extension));
+    }
+
+    u64 ResourcesManager::get_locality_key(const Identifier&, const std::string&) const {
+        return 0;
+    }
+
+    bool ResourcesManager::list_resources(std::vector<std::string>&) const {
+        return false;
+    }
+
+    std::unique_ptr<ResourceReader> ResourcesManager::open_resource(const Identifier& resource, const std::string& extension) const {
+        auto view = load_resource_view(resource, extension);
+        if (!view.is_loaded())
+            return nullptr;
+        return std::make_unique<ResourceViewReader>(std::move(view));
+    }
+
     /*
      * FileResourcesManager
      */
@@ -132,19 +611,41 @@ namespace lambdacommon
     }
 
     std::string FileResourcesManager::load_resource(const Identifier& resource, const std::string& extension) const {
-        auto resource_path = get_resource_path(resource, extension);
-        if (!resource_path.exists())
-            return "";
+        return this->load_resource_view(resource, extension).to_string();
+    }
+
+    ResourceView FileResourcesManager::load_resource_view(const Identifier& resource, const std::string& extension) const {
+        return map_file(get_resource_path(resource, extension));
+    }
+
+    u64 FileResourcesManager::get_locality_key(const Identifier& resource, const std::string& extension) const {
+#ifdef LAMBDA_WINDOWS
+        return 0;
+#else
+        struct ::stat st{};
+        if (::stat(get_resource_path(resource, extension).c_str(), &st) != 0)
+            return 0;
+        return static_cast<u64>(st.st_ino);
+#endif
+    }
+
+    bool FileResourcesManager::list_resources(std::vector<std::string>& keys) const {
+        std::vector<std::pair<std::string, fs::path>> files;
         try {
-            std::ifstream file_stream{resource_path.to_string()};
-            std::stringstream output_stream;
-            output_stream << file_stream.rdbuf();
-            file_stream.close();
-            return output_stream.str();
+            list_resource_files(_working_directory, "", files);
+        } catch (const std::runtime_error&) {
+            return false;
         }
-        catch (std::exception& e) {
-            return "";
+        for (auto& file : files) {
+            // The first directory level is the namespace.
+            file.first[file.first.find('/')] = ':';
+            keys.push_back(std::move(file.first));
         }
+        return true;
+    }
+
+    std::unique_ptr<ResourceReader> FileResourcesManager::open_resource(const Identifier& resource, const std::string& extension) const {
+        return FileResourceReader::open(get_resource_path(resource, extension));
     }
 
     FileResourcesManager& FileResourcesManager::operator=(const FileResourcesManager& other) {
@@ -168,4 +669,671 @@ namespace lambdacommon
     bool FileResourcesManager::operator==(const FileResourcesManager& other) const {
         return _id == other._id && _working_directory == other._working_directory;
     }
+
+    /*
+     * ResourceLoader
+     */
+
+    double ResourceBatchReport::get_bytes_per_second() const {
+        if (elapsed.count() <= 0)
+            return 0.0;
+        return static_cast<double>(bytes) / std::chrono::duration<double>(elapsed).count();
+    }
+
+    std::chrono::nanoseconds ResourceBatchReport::get_mean_latency() const {
+        if (results.empty())
+            return std::chrono::nanoseconds{0};
+        return total_latency / results.size();
+    }
+
+    /*
+     * The shared state of a batch: the workers first compute the locality keys, the last one sorts the resources,
+     * then every worker takes the next resource in the sorted order until none is left.
+     */
+    struct ResourceBatch
+    {
+        struct SortKey
+        {
+            std::string_view domain;
+            std::string_view directory;
+            u64 locality;
+        };
+
+        std::vector<Identifier> resources;
+        std::vector<SortKey> keys;
+        std::vector<size_t> order;
+        std::string extension;
+        std::function<void(size_t, const ResourceLoadResult&)> on_loaded;
+        ResourceBatchReport report;
+        std::atomic<size_t> next_key{0};
+        std::atomic<size_t> pending_keys{0};
+        std::mutex order_mutex;
+        std::condition_variable order_ready;
+        bool sorted = false;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> remaining{0};
+        std::promise<ResourceBatchReport> promise;
+        std::chrono::steady_clock::time_point start;
+
+        /*
+         * Computes the locality keys not taken by another worker, the worker computing the last key sorts the resources.
+         * Waits until the resources are sorted: the keys left are computed by running workers, so the wait is short.
+         */
+        void sort(const ResourcesManager& manager) {
+            auto count = resources.size();
+            size_t index;
+            while ((index = next_key.fetch_add(1, std::memory_order_relaxed)) < count) {
+                const auto& resource = resources[index];
+                std::string_view name = resource.get_name();
+                auto separator = name.find_last_of('/');
+                u64 locality = 0;
+                try {
+                    locality = manager.get_locality_key(resource, extension);
+                } catch (...) {
+                    // The resource fails later when loaded, its position doesn't matter.
+                }
+                keys[index] = {resource.get_domain(), separator == std::string_view::npos ? std::string_view{} : name.substr(0, separator), locality};
+                if (pending_keys.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    // Group the resources by directory, then by locality key.
+                    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+                        return std::tie(keys[a].domain, keys[a].directory, keys[a].locality) <
+                               std::tie(keys[b].domain, keys[b].directory, keys[b].locality);
+                    });
+                    {
+                        std::lock_guard<std::mutex> lock(order_mutex);
+                        sorted = true;
+                    }
+                    order_ready.notify_all();
+                }
+            }
+            std::unique_lock<std::mutex> lock(order_mutex);
+            order_ready.wait(lock, [this]() { return sorted; });
+        }
+
+        void finish() {
+            report.elapsed = std::chrono::steady_clock::now() - start;
+            for (const auto& result : report.results) {
+                if (result.view.is_loaded()) {
+                    report.loaded++;
+                    report.bytes += result.view.size();
+                } else
+                    report.failed++;
+                report.total_latency += result.latency;
+                report.max_latency = std::max(report.max_latency, result.latency);
+            }
+            promise.set_value(std::move(report));
+        }
+    };
+
+    // The loader whose task runs on the current thread, used to reject the submissions from its own I/O threads.
+    static thread_local const ResourceLoader* current_loader = nullptr;
+
+    /*
+     * Marks the current thread as running a task of a loader.
+     */
+    class LoaderTaskScope
+    {
+    private:
+        const ResourceLoader* _previous;
+
+    public:
+        explicit LoaderTaskScope(const ResourceLoader* loader) : _previous(current_loader) {
+            current_loader = loader;
+        }
+
+        LoaderTaskScope(const LoaderTaskScope& other) = delete;
+
+        ~LoaderTaskScope() {
+            current_loader = _previous;
+        }
+
+        LoaderTaskScope& operator=(const LoaderTaskScope& other) = delete;
+    };
+
+    ResourceLoader::ResourceLoader(const ResourcesManager& manager, size_t threads) : _manager(manager), _pool(threads) {}
+
+    void ResourceLoader::check_caller_thread() const {
+        if (current_loader == this)
+            throw std::logic_error("Cannot submit loads to a resource loader from one of its own I/O threads.");
+    }
+
+    std::future<ResourceView> ResourceLoader::load_resource_async(const Identifier& resource, const std::string& extension) {
+        check_caller_thread();
+        return _pool.submit_future([this, resource, extension]() {
+            LoaderTaskScope scope(this);
+            return _manager.load_resource_view(resource, extension);
+        });
+    }
+
+    std::future<ResourceBatchReport> ResourceLoader::load_resources_async(std::vector<Identifier> resources, const std::string& extension,
+                                                                          std::function<void(size_t, const ResourceLoadResult&)> on_loaded) {
+        check_caller_thread();
+        auto batch = std::make_shared<ResourceBatch>();
+        batch->start = std::chrono::steady_clock::now();
+        batch->resources = std::move(resources);
+        batch->extension = extension;
+        batch->on_loaded = std::move(on_loaded);
+        auto count = batch->resources.size();
+        batch->report.results.resize(count);
+        batch->remaining = count;
+        auto future = batch->promise.get_future();
+        if (count == 0) {
+            batch->finish();
+            return future;
+        }
+
+        // The locality keys may require a system call each, they are computed by the workers instead of the calling thread.
+        batch->keys.resize(count);
+        batch->pending_keys = count;
+        batch->order.resize(count);
+        for (size_t i = 0; i < count; i++)
+            batch->order[i] = i;
+
+        auto workers = std::min(count, _pool.get_thread_count());
+        for (size_t i = 0; i < workers; i++)
+            _pool.submit([this, batch]() {
+                LoaderTaskScope scope(this);
+                batch->sort(_manager);
+                size_t next;
+                while ((next = batch->next.fetch_add(1, std::memory_order_relaxed)) < batch->order.size()) {
+                    auto index = batch->order[next];
+                    auto& result = batch->report.results[index];
+                    auto start = std::chrono::steady_clock::now();
+                    try {
+                        result.view = _manager.load_resource_view(batch->resources[index], batch->extension);
+                    } catch (...) {
+                        result.view = {};
+                    }
+                    result.latency = std::chrono::steady_clock::now() - start;
+                    if (batch->on_loaded) {
+                        try {
+                            batch->on_loaded(index, result);
+                        } catch (...) {
+                            // The batch must complete even if the callback fails.
+                        }
+                    }
+                    if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        batch->finish();
+                }
+            });
+        return future;
+    }
+
+    /*
+     * CachingFileResourcesManager
+     */
+
+    CachingFileResourcesManager::CachingFileResourcesManager(fs::path working_directory, size_t capacity)
+            : FileResourcesManager(std::move(working_directory)), _capacity(capacity) {}
+
+    size_t CachingFileResourcesManager::get_capacity() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _capacity;
+    }
+
+    void CachingFileResourcesManager::set_capacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _capacity = capacity;
+        evict(capacity);
+    }
+
+    void CachingFileResourcesManager::set_check_modifications(bool check_modifications) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _check_modifications = check_modifications;
+    }
+
+    void CachingFileResourcesManager::evict(size_t target_bytes) const {
+        while (_stats.bytes > target_bytes && !_entries.empty()) {
+            auto& entry = _entries.back();
+            _stats.bytes -= entry.view.size();
+            _index.erase(entry.key);
+            _entries.pop_back();
+            _stats.evictions++;
+        }
+        _stats.entries = _entries.size();
+    }
+
+    ResourceView CachingFileResourcesManager::load_resource_view(const Identifier& resource, const std::string& extension) const {
+        auto key = make_resource_key(resource, extension);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (auto it = _index.find(key); it != _index.end()) {
+            auto entry = it->second;
+            bool valid = true;
+            if (_check_modifications) {
+                FileVersion version;
+                valid = get_file_version(entry->path, version) && version == FileVersion{entry->modification_time, entry->file_size};
+            }
+            if (valid) {
+                _entries.splice(_entries.begin(), _entries, entry);
+                _stats.hits++;
+                return entry->view;
+            }
+            _stats.bytes -= entry->view.size();
+            _index.erase(it);
+            _entries.erase(entry);
+            _stats.entries = _entries.size();
+            _stats.invalidations++;
+        }
+        _stats.misses++;
+        lock.unlock();
+
+        // The file is loaded without holding the lock so other resources can be served meanwhile.
+        auto path = get_resource_path(resource, extension);
+        FileVersion version;
+        auto view = map_file(path, &version);
+        if (!view.is_loaded())
+            return view;
+
+        lock.lock();
+        // Don't cache resources larger than the cache, or loaded by another thread meanwhile.
+        if (view.size() > _capacity || _index.find(key) != _index.end())
+            return view;
+        _entries.push_front({std::move(key), std::move(path), view, version.modification_time, version.size});
+        _index.emplace(_entries.front().key, _entries.begin());
+        _stats.bytes += view.size();
+        evict(_capacity);
+        return view;
+    }
+
+    void CachingFileResourcesManager::invalidate(const Identifier& resource, const std::string& extension) {
+        auto key = make_resource_key(resource, extension);
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (auto it = _index.find(key); it != _index.end()) {
+            _stats.bytes -= it->second->view.size();
+            _entries.erase(it->second);
+            _index.erase(it);
+            _stats.entries = _entries.size();
+        }
+    }
+
+    void CachingFileResourcesManager::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _index.clear();
+        _entries.clear();
+        _stats.bytes = 0;
+        _stats.entries = 0;
+    }
+
+    ResourcesCacheStats CachingFileResourcesManager::get_stats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    /*
+     * ArchiveResourcesManager
+     */
+
+    constexpr char ARCHIVE_MAGIC[4] = {'L', 'C', 'R', 'A'};
+    constexpr u32 ARCHIVE_VERSION = 1;
+    constexpr size_t ARCHIVE_HEADER_SIZE = 32;
+    constexpr size_t ARCHIVE_BUCKET_SIZE = 32;
+    constexpr size_t ARCHIVE_DATA_ALIGNMENT = 16;
+    constexpr u8 ARCHIVE_STORED = 0;
+
+    template<typename T>
+    inline T load_le(const char* p) {
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            value |= static_cast<T>(static_cast<u8>(p[i])) << (8 * i);
+        return value;
+    }
+
+    template<typename T>
+    inline void store_le(char* p, T value) {
+        for (size_t i = 0; i < sizeof(T); i++)
+            p[i] = static_cast<char>(static_cast<u8>(value >> (8 * i)));
+    }
+
+    /*
+     * Hashes an archive key, 0 marks the empty buckets.
+     */
+    inline u64 hash_archive_key(std::string_view key) {
+        auto hash = hashing::hash_string(key);
+        return hash == 0 ? 1 : hash;
+    }
+
+    ArchiveResourcesManager::ArchiveResourcesManager(fs::path archive_path) : ResourcesManager(), _archive_path(std::move(archive_path)) {
+        _archive = map_file(_archive_path);
+        if (!_archive.is_loaded())
+            throw std::runtime_error("Cannot open the resources archive " + _archive_path.to_string() + ".");
+        auto header = _archive.data();
+        if (_archive.size() < ARCHIVE_HEADER_SIZE || std::memcmp(header, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0)
+            throw std::runtime_error("The file " + _archive_path.to_string() + " is not a resources archive.");
+        if (load_le<u32>(header + 4) != ARCHIVE_VERSION)
+            throw std::runtime_error("The resources archive " + _archive_path.to_string() + " has an unsupported version.");
+        _count = load_le<u32>(header + 8);
+        auto buckets = load_le<u32>(header + 12);
+        auto index_offset = load_le<u64>(header + 16);
+        auto keys_offset = load_le<u64>(header + 24);
+        if (buckets == 0 || (buckets & (buckets - 1)) != 0 || _count > buckets || index_offset > _archive.size()
+            || (_archive.size() - index_offset) / ARCHIVE_BUCKET_SIZE < buckets || keys_offset > _archive.size())
+            throw std::runtime_error("The resources archive " + _archive_path.to_string() + " is corrupted.");
+        _bucket_mask = buckets - 1;
+        _index_offset = static_cast<size_t>(index_offset);
+        _keys_offset = static_cast<size_t>(keys_offset);
+    }
+
+    std::optional<std::pair<u64, u64>> ArchiveResourcesManager::find(std::string_view key) const {
+        auto hash = hash_archive_key(key);
+        auto archive = _archive.view();
+        for (u32 i = static_cast<u32>(hash) & _bucket_mask, probes = 0; probes <= _bucket_mask; i = (i + 1) & _bucket_mask, probes++) {
+            auto bucket = archive.data() + _index_offset + static_cast<size_t>(i) * ARCHIVE_BUCKET_SIZE;
+            auto bucket_hash = load_le<u64>(bucket);
+            if (bucket_hash == 0)
+                break;
+            if (bucket_hash != hash)
+                continue;
+            auto key_offset = _keys_offset + load_le<u32>(bucket + 24);
+            auto key_length = load_le<u16>(bucket + 28);
+            if (key_length != key.size() || key_offset > archive.size() || archive.compare(key_offset, key_length, key) != 0)
+                continue;
+            auto offset = load_le<u64>(bucket + 8), size = load_le<u64>(bucket + 16);
+            if (static_cast<u8>(bucket[30]) != ARCHIVE_STORED || offset > archive.size() || archive.size() - offset < size)
+                return std::nullopt;
+            return std::make_pair(offset, size);
+        }
+        return std::nullopt;
+    }
+
+    std::optional<std::pair<u64, u64>> ArchiveResourcesManager::find(const Identifier& resource, const std::string& extension) const {
+        return find(make_resource_key(resource, extension));
+    }
+
+    const fs::path& ArchiveResourcesManager::get_archive_path() const {
+        return _archive_path;
+    }
+
+    size_t ArchiveResourcesManager::get_resource_count() const {
+        return _count;
+    }
+
+    bool ArchiveResourcesManager::has_resource(const Identifier& resource) const {
+        return has_resource(resource, "");
+    }
+
+    bool ArchiveResourcesManager::has_resource(const Identifier& resource, const std::string& extension) const {
+        return find(resource, extension).has_value();
+    }
+
+    std::string ArchiveResourcesManager::load_resource(const Identifier& resource) const {
+        return load_resource(resource, "");
+    }
+
+    std::string ArchiveResourcesManager::load_resource(const Identifier& resource, const std::string& extension) const {
+        return load_resource_view(resource, extension).to_string();
+    }
+
+    ResourceView ArchiveResourcesManager::load_resource_view(const Identifier& resource, const std::string& extension) const {
+        auto entry = find(resource, extension);
+        if (!entry)
+            return {};
+        return _archive.subview(static_cast<size_t>(entry->first), static_cast<size_t>(entry->second));
+    }
+
+    u64 ArchiveResourcesManager::get_locality_key(const Identifier& resource, const std::string& extension) const {
+        auto entry = find(resource, extension);
+        return entry ? entry->first : 0;
+    }
+
+    bool ArchiveResourcesManager::list_resources(std::vector<std::string>& keys) const {
+        auto archive = _archive.view();
+        for (size_t i = 0; i <= _bucket_mask; i++) {
+            auto bucket = archive.data() + _index_offset + i * ARCHIVE_BUCKET_SIZE;
+            if (load_le<u64>(bucket) == 0)
+                continue;
+            auto key_offset = _keys_offset + load_le<u32>(bucket + 24);
+            if (key_offset <= archive.size())
+                keys.emplace_back(archive.substr(key_offset, load_le<u16>(bucket + 28)));
+        }
+        return true;
+    }
+
+    size_t pack_resources_archive(const fs::path& directory, const fs::path& archive_path) {
+        std::vector<std::pair<std::string, fs::path>> files;
+        list_resource_files(directory, "", files);
+        // The archive doesn't depend on the order of the directory entries.
+        std::sort(files.begin(), files.end());
+
+        // The first directory level is the namespace.
+        std::vector<std::string> keys;
+        std::vector<u64> sizes;
+        keys.reserve(files.size());
+        sizes.reserve(files.size());
+        size_t keys_size = 0;
+        for (auto& [relative, path] : files) {
+            auto key = relative;
+            key[key.find('/')] = ':';
+            if (key.size() > std::numeric_limits<u16>::max())
+                throw std::runtime_error("The resource name " + key + " is too long to be packed.");
+            FileVersion version;
+            if (!get_file_version(path, version))
+                throw std::runtime_error("Cannot read the resource " + path.to_string() + ".");
+            keys_size += key.size();
+            keys.push_back(std::move(key));
+            sizes.push_back(version.size);
+        }
+        if (keys_size > std::numeric_limits<u32>::max() || files.size() > std::numeric_limits<u32>::max() / 2)
+            throw std::runtime_error("Too many resources to pack in a single archive.");
+
+        // The load factor is kept under 0.5 so missing resources are rejected after a few probes.
+        u32 buckets = 16;
+        while (buckets < files.size() * 2)
+            buckets <<= 1;
+        auto keys_offset = ARCHIVE_HEADER_SIZE + static_cast<size_t>(buckets) * ARCHIVE_BUCKET_SIZE;
+        auto align = [](u64 offset) { return (offset + ARCHIVE_DATA_ALIGNMENT - 1) & ~static_cast<u64>(ARCHIVE_DATA_ALIGNMENT - 1); };
+
+        std::string head(keys_offset + keys_size, '\0');
+        std::memcpy(head.data(), ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        store_le<u32>(head.data() + 4, ARCHIVE_VERSION);
+        store_le<u32>(head.data() + 8, static_cast<u32>(files.size()));
+        store_le<u32>(head.data() + 12, buckets);
+        store_le<u64>(head.data() + 16, ARCHIVE_HEADER_SIZE);
+        store_le<u64>(head.data() + 24, keys_offset);
+        u64 key_offset = 0, data_offset = align(head.size());
+        std::vector<u64> offsets(files.size());
+        for (size_t i = 0; i < files.size(); i++) {
+            auto hash = hash_archive_key(keys[i]);
+            auto bucket_index = static_cast<u32>(hash) & (buckets - 1);
+            while (load_le<u64>(head.data() + ARCHIVE_HEADER_SIZE + static_cast<size_t>(bucket_index) * ARCHIVE_BUCKET_SIZE) != 0)
+                bucket_index = (bucket_index + 1) & (buckets - 1);
+            auto bucket = head.data() + ARCHIVE_HEADER_SIZE + static_cast<size_t>(bucket_index) * ARCHIVE_BUCKET_SIZE;
+            offsets[i] = data_offset;
+            store_le<u64>(bucket, hash);
+            store_le<u64>(bucket + 8, data_offset);
+            store_le<u64>(bucket + 16, sizes[i]);
+            store_le<u32>(bucket + 24, static_cast<u32>(key_offset));
+            store_le<u16>(bucket + 28, static_cast<u16>(keys[i].size()));
+            bucket[30] = static_cast<char>(ARCHIVE_STORED);
+            std::memcpy(head.data() + keys_offset + key_offset, keys[i].data(), keys[i].size());
+            key_offset += keys[i].size();
+            data_offset = align(data_offset + sizes[i]);
+        }
+
+        std::ofstream out(archive_path.to_string(), std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("Cannot write the resources archive " + archive_path.to_string() + ".");
+        out.write(head.data(), static_cast<std::streamsize>(head.size()));
+        u64 written = head.size();
+        static const char padding[ARCHIVE_DATA_ALIGNMENT] = {};
+        for (size_t i = 0; i < files.size(); i++) {
+            out.write(padding, static_cast<std::streamsize>(offsets[i] - written));
+            auto content = map_file(files[i].second);
+            if (!content.is_loaded() || content.size() != sizes[i])
+                throw std::runtime_error("The resource " + files[i].second.to_string() + " changed while being packed.");
+            out.write(content.data(), static_cast<std::streamsize>(content.size()));
+            written = offsets[i] + sizes[i];
+        }
+        if (!out.flush())
+            throw std::runtime_error("Cannot write the resources archive " + archive_path.to_string() + ".");
+        return files.size();
+    }
+
+    /*
+     * LayeredResourcesManager
+     */
+
+    LayeredResourcesManager::LayeredResourcesManager(std::vector<std::shared_ptr<const ResourcesManager>> layers) : ResourcesManager() {
+        for (auto& layer : layers)
+            add_layer(std::move(layer));
+    }
+
+    size_t LayeredResourcesManager::add_layer(std::shared_ptr<const ResourcesManager> layer) {
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+        if (_layers.size() >= MAX_LAYERS)
+            throw std::length_error("A layered resources manager cannot have more than 64 layers.");
+        _layers.push_back(std::move(layer));
+        _pending_scan |= 1ull << (_layers.size() - 1);
+        _generation++;
+        return _layers.size() - 1;
+    }
+
+    size_t LayeredResourcesManager::get_layer_count() const {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        return _layers.size();
+    }
+
+    void LayeredResourcesManager::scan() const {
+        std::vector<std::string> keys;
+        for (size_t layer = 0; layer < _layers.size(); layer++) {
+            auto bit = 1ull << layer;
+            if (!(_pending_scan & bit))
+                continue;
+            keys.clear();
+            if (_layers[layer]->list_resources(keys)) {
+                for (auto& key : keys)
+                    _index[std::move(key)].present |= bit;
+                _scanned |= bit;
+            }
+        }
+        _pending_scan = 0;
+    }
+
+    int LayeredResourcesManager::find_layer_index(const Identifier& resource, const std::string& extension) const {
+        auto key = make_resource_key(resource, extension);
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        if (_pending_scan) {
+            lock.unlock();
+            {
+                std::unique_lock<std::shared_mutex> scan_lock(_mutex);
+                if (_pending_scan) {
+                    scan();
+                    _generation++;
+                }
+            }
+            lock.lock();
+        }
+
+        IndexEntry entry;
+        if (auto it = _index.find(key); it != _index.end())
+            entry = it->second;
+        entry.known |= _scanned;
+        // The layers without an index are probed, from the top-most layer.
+        u64 probed = 0, found = 0;
+        int result = -1;
+        for (auto layer = static_cast<int>(_layers.size()) - 1; layer >= 0; layer--) {
+            auto bit = 1ull << layer;
+            if (!(entry.known & bit)) {
+                probed |= bit;
+                if (_layers[layer]->has_resource(resource, extension))
+                    found |= bit;
+                else
+                    continue;
+            } else if (!(entry.present & bit))
+                continue;
+            result = layer;
+            break;
+        }
+        if (!probed)
+            return result;
+
+        auto generation = _generation;
+        lock.unlock();
+        std::unique_lock<std::shared_mutex> write_lock(_mutex);
+        // Don't remember the probes if a layer changed meanwhile.
+        if (generation == _generation) {
+            auto& stored = _index[std::move(key)];
+            stored.known |= probed;
+            stored.present = (stored.present & ~probed) | found;
+        }
+        return result;
+    }
+
+    std::shared_ptr<const ResourcesManager> LayeredResourcesManager::get_layer(const Identifier& resource, const std::string& extension) const {
+        auto layer = find_layer_index(resource, extension);
+        if (layer < 0)
+            return nullptr;
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        return _layers[layer];
+    }
+
+    void LayeredResourcesManager::invalidate_layer(size_t layer) {
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+        if (layer >= _layers.size())
+            return;
+        auto bit = 1ull << layer;
+        for (auto it = _index.begin(); it != _index.end();) {
+            it->second.known &= ~bit;
+            it->second.present &= ~bit;
+            if (it->second.known == 0 && it->second.present == 0)
+                it = _index.erase(it);
+            else
+                ++it;
+        }
+        _scanned &= ~bit;
+        _pending_scan |= bit;
+        _generation++;
+    }
+
+    void LayeredResourcesManager::invalidate() {
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+        _index.clear();
+        _scanned = 0;
+        _pending_scan = _layers.empty() ? 0 : (~0ull >> (MAX_LAYERS - _layers.size()));
+        _generation++;
+    }
+
+    bool LayeredResourcesManager::has_resource(const Identifier& resource) const {
+        return has_resource(resource, "");
+    }
+
+    bool LayeredResourcesManager::has_resource(const Identifier& resource, const std::string& extension) const {
+        return find_layer_index(resource, extension) >= 0;
+    }
+
+    std::string LayeredResourcesManager::load_resource(const Identifier& resource) const {
+        return load_resource(resource, "");
+    }
+
+    std::string LayeredResourcesManager::load_resource(const Identifier& resource, const std::string& extension) const {
+        auto layer = get_layer(resource, extension);
+        return layer ? layer->load_resource(resource, extension) : std::string{};
+    }
+
+    ResourceView LayeredResourcesManager::load_resource_view(const Identifier& resource, const std::string& extension) const {
+        auto layer = get_layer(resource, extension);
+        return layer ? layer->load_resource_view(resource, extension) : ResourceView{};
+    }
+
+    u64 LayeredResourcesManager::get_locality_key(const Identifier& resource, const std::string& extension) const {
+        auto layer = get_layer(resource, extension);
+        return layer ? layer->get_locality_key(resource, extension) : 0;
+    }
+
+    std::unique_ptr<ResourceReader> LayeredResourcesManager::open_resource(const Identifier& resource, const std::string& extension) const {
+        auto layer = get_layer(resource, extension);
+        return layer ? layer->open_resource(resource, extension) : nullptr;
+    }
+
+    bool LayeredResourcesManager::list_resources(std::vector<std::string>& keys) const {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        std::vector<std::string> layer_keys;
+        for (auto& layer : _layers)
+            if (!layer->list_resources(layer_keys))
+                return false;
+        std::sort(layer_keys.begin(), layer_keys.end());
+        layer_keys.erase(std::unique(layer_keys.begin(), layer_keys.end()), layer_keys.end());
+        keys.insert(keys.end(), std::make_move_iterator(layer_keys.begin()), std::make_move_iterator(layer_keys.end()));
+        return true;
+    }
 }
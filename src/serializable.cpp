@@ -8,24 +8,23 @@
  */
 
 #include "../include/lambdacommon/serializable.h"
+#include "../include/lambdacommon/lstring.h"
+#include <array>
 
 namespace lambdacommon
 {
     namespace serializable
     {
         std::vector<std::string> LAMBDACOMMON_API tokenize(const std::string& _string, const std::string& delim) {
-            std::string::size_type last_pos = 0;
-            std::string::size_type pos = _string.find_first_of(delim, last_pos);
-            std::vector<std::string> tokens;
+            // Lookup table of the delimiter chars, avoids scanning the delimiter string for every char.
+            std::array<bool, 256> is_delimiter{};
+            for (unsigned char c : delim)
+                is_delimiter[c] = true;
 
-            while (last_pos != std::string::npos) {
-                if (pos != last_pos)
-                    tokens.push_back(_string.substr(last_pos, pos - last_pos));
-                last_pos = pos;
-                if (last_pos == std::string::npos || last_pos + 1 == _string.length())
-                    break;
-                pos = _string.find_first_of(delim, ++last_pos);
-            }
+            std::vector<std::string> tokens;
+            for (auto token : lstring::split_view(_string, [&is_delimiter](char c) { return is_delimiter[static_cast<unsigned char>(c)]; }))
+                if (!token.empty())
+                    tokens.emplace_back(token);
 
             return tokens;
         }
@@ -10,14 +10,26 @@
 #include "../../include/lambdacommon/system/uri.h"
 #include "../../include/lambdacommon/system/system.h"
 #include "../../include/lambdacommon/exceptions/exceptions.h"
-#include <sstream>
-#include <regex>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define LAMBDACOMMON_URI_SSE2
+#  include <emmintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#endif
 
 namespace lambdacommon
 {
     namespace uri
     {
-        SchemeType LAMBDACOMMON_API get_scheme_type_by_string(const std::string& scheme) {
+        SchemeType LAMBDACOMMON_API get_scheme_type_by_string(std::string_view scheme) {
             if (lstring::equals_ignore_case(scheme, "file"))
                 return FILE;
             else if (lstring::equals_ignore_case(scheme, "ftp"))
@@ -63,25 +75,414 @@ namespace lambdacommon
             return scheme != FILE && scheme != OTHER;
         }
 
+        constexpr u8 CHAR_USERINFO = 1, CHAR_HOST = 2, CHAR_PATH = 4, CHAR_QUERY = 8, CHAR_SCHEME = 16;
+        // The characters which end the authority, the path and the query.
+        constexpr u8 END_AUTHORITY = 32, END_PATH = 64, END_QUERY = 128;
+
+        constexpr std::array<u8, 256> make_uri_char_classes() {
+            std::array<u8, 256> classes{};
+            auto add = [&classes](std::string_view chars, u8 flags) {
+                for (char c : chars)
+                    classes[static_cast<u8>(c)] |= flags;
+            };
+            constexpr u8 COMPONENTS = CHAR_USERINFO | CHAR_HOST | CHAR_PATH | CHAR_QUERY;
+            add("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz", COMPONENTS | CHAR_SCHEME);
+            add("0123456789", COMPONENTS | CHAR_SCHEME);
+            add("+.", CHAR_SCHEME);
+            add("-", CHAR_SCHEME);
+            // Unreserved characters then sub-delimiters (RFC 3986, section 2).
+            add("-._~", COMPONENTS);
+            add("!$&'()*+,;=", COMPONENTS);
+            add(":", CHAR_USERINFO | CHAR_PATH | CHAR_QUERY);
+            add("@/", CHAR_PATH | CHAR_QUERY);
+            add("?", CHAR_QUERY);
+            add("/?#", END_AUTHORITY);
+            add("?#", END_PATH);
+            add("#", END_QUERY);
+            return classes;
+        }
+
+        constexpr std::array<u8, 256> URI_CHAR_CLASSES = make_uri_char_classes();
+
+        inline bool is_hex_digit(char c) {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+        }
+
+        inline u8 hex_digit_value(char c) {
+            if (c <= '9')
+                return static_cast<u8>(c - '0');
+            return static_cast<u8>((c | 0x20) - 'a' + 10);
+        }
+
         /*
-         * URI
+         * Decodes the percent-encoded sequence at the specified index if there is one, else returns the character.
          */
+        inline char next_decoded(std::string_view encoded, size_t& i) {
+            if (encoded[i] == '%' && encoded.size() - i >= 3 && is_hex_digit(encoded[i + 1]) && is_hex_digit(encoded[i + 2])) {
+                i += 3;
+                return static_cast<char>((hex_digit_value(encoded[i - 2]) << 4) | hex_digit_value(encoded[i - 1]));
+            }
+            return encoded[i++];
+        }
 
-        std::map<std::string, std::string> fix_queries(const std::map<std::string, std::string>& queries) {
-            std::map<std::string, std::string> new_queries;
-            for (const auto& query : queries)
-                new_queries[lstring::replace_all(query.first, " ", "%20")] = lstring::replace_all(query.second, " ", "%20");
-            return new_queries;
-        };
+        inline bool equals_decoded(std::string_view encoded, std::string_view decoded) {
+            if (encoded.size() < decoded.size())
+                return false;
+            size_t i = 0, j = 0;
+            while (i < encoded.size() && j < decoded.size())
+                if (next_decoded(encoded, i) != decoded[j++])
+                    return false;
+            return i == encoded.size() && j == decoded.size();
+        }
+
+        /*
+         * Percent-encoding
+         */
+
+        constexpr std::array<u8, 256> make_percent_encode_sets() {
+            std::array<u8, 256> sets{};
+            auto allow = [&sets](std::string_view chars, std::initializer_list<URIComponent> components) {
+                for (char c : chars)
+                    for (auto component : components)
+                        sets[static_cast<u8>(c)] |= static_cast<u8>(1u << component);
+            };
+            auto all = {COMPONENT_PATH, COMPONENT_PATH_SEGMENT, COMPONENT_QUERY, COMPONENT_QUERY_PARAMETER, COMPONENT_FRAGMENT, COMPONENT_USERINFO};
+            allow("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-._~", all);
+            allow("!$'()*,;", all);
+            allow("&=+", {COMPONENT_PATH, COMPONENT_PATH_SEGMENT, COMPONENT_QUERY, COMPONENT_FRAGMENT, COMPONENT_USERINFO});
+            allow(":", all);
+            allow("@", {COMPONENT_PATH, COMPONENT_PATH_SEGMENT, COMPONENT_QUERY, COMPONENT_QUERY_PARAMETER, COMPONENT_FRAGMENT});
+            allow("/", {COMPONENT_PATH, COMPONENT_QUERY, COMPONENT_QUERY_PARAMETER, COMPONENT_FRAGMENT});
+            allow("?", {COMPONENT_QUERY, COMPONENT_QUERY_PARAMETER, COMPONENT_FRAGMENT});
+            return sets;
+        }
+
+        /*
+         * For each character, one bit per component which allows the character without percent-encoding.
+         */
+        constexpr std::array<u8, 256> PERCENT_ENCODE_SETS = make_percent_encode_sets();
+
+        constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+
+        inline bool needs_encoding(char c, URIComponent component) {
+            return !(PERCENT_ENCODE_SETS[static_cast<u8>(c)] & (1u << component));
+        }
+
+#ifdef LAMBDACOMMON_URI_SSE2
+        inline u32 count_trailing_zeros(u32 mask) {
+#  ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return index;
+#  else
+            return static_cast<u32>(__builtin_ctz(mask));
+#  endif
+        }
+
+        /*
+         * Gets the mask of the 16 bytes which are unreserved characters, or '/' if the component allows it.
+         * Every component allows the unreserved characters, the other characters are checked with the table.
+         */
+        inline int unreserved_mask_16(const char* data, bool allow_slash) {
+            auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            // x - lo <= hi - lo as unsigned, with a saturated subtraction.
+            auto in_range = [](__m128i x, char lo, char length) {
+                auto shifted = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+                return _mm_cmpeq_epi8(_mm_subs_epu8(shifted, _mm_set1_epi8(length)), _mm_setzero_si128());
+            };
+            auto letters = in_range(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 25);
+            auto digits = in_range(bytes, '0', 9);
+            auto marks = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('-')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('.'))),
+                                      _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('~'))));
+            if (allow_slash)
+                marks = _mm_or_si128(marks, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('/')));
+            return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letters, digits), marks));
+        }
+#endif
+
+        size_t LAMBDACOMMON_API percent_encoded_size(std::string_view str, URIComponent component) {
+            size_t size = str.size(), i = 0;
+#ifdef LAMBDACOMMON_URI_SSE2
+            bool allow_slash = !needs_encoding('/', component);
+            for (; i + 16 <= str.size(); i += 16) {
+                if (unreserved_mask_16(str.data() + i, allow_slash) == 0xFFFF)
+                    continue;
+                for (size_t j = i; j < i + 16; j++)
+                    if (needs_encoding(str[j], component))
+                        size += 2;
+            }
+#endif
+            for (; i < str.size(); i++)
+                if (needs_encoding(str[i], component))
+                    size += 2;
+            return size;
+        }
+
+        size_t LAMBDACOMMON_API percent_encode(std::string_view str, URIComponent component, char* output) {
+            auto start = output;
+            size_t i = 0;
+            auto encode = [&output, component](char c) {
+                if (needs_encoding(c, component)) {
+                    output[0] = '%';
+                    output[1] = HEX_DIGITS[static_cast<u8>(c) >> 4];
+                    output[2] = HEX_DIGITS[static_cast<u8>(c) & 0xF];
+                    output += 3;
+                } else
+                    *output++ = c;
+            };
+#ifdef LAMBDACOMMON_URI_SSE2
+            bool allow_slash = !needs_encoding('/', component);
+            for (; i + 16 <= str.size(); i += 16) {
+                if (unreserved_mask_16(str.data() + i, allow_slash) == 0xFFFF) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_loadu_si128(reinterpret_cast<const __m128i*>(str.data() + i)));
+                    output += 16;
+                    continue;
+                }
+                for (size_t j = i; j < i + 16; j++)
+                    encode(str[j]);
+            }
+#endif
+            for (; i < str.size(); i++)
+                encode(str[i]);
+            return static_cast<size_t>(output - start);
+        }
+
+        std::string LAMBDACOMMON_API percent_encode(std::string_view str, URIComponent component) {
+            std::string encoded(percent_encoded_size(str, component), '\0');
+            percent_encode(str, component, encoded.data());
+            return encoded;
+        }
+
+        size_t LAMBDACOMMON_API percent_decode(char* data, size_t size) {
+            size_t read = 0, written = 0;
+            while (read < size) {
+#ifdef LAMBDACOMMON_URI_SSE2
+                // Moves the blocks without '%' at once.
+                if (read + 16 <= size) {
+                    auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + read));
+                    auto percents = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('%')));
+                    if (percents == 0) {
+                        if (written != read)
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + written), bytes);
+                        read += 16;
+                        written += 16;
+                        continue;
+                    }
+                    // Moves the bytes before the first '%'.
+                    auto count = static_cast<size_t>(count_trailing_zeros(static_cast<u32>(percents)));
+                    if (written != read)
+                        std::memmove(data + written, data + read, count);
+                    read += count;
+                    written += count;
+                }
+#endif
+                data[written++] = next_decoded({data, size}, read);
+            }
+            return written;
+        }
+
+        std::string LAMBDACOMMON_API percent_decode(std::string_view str) {
+            std::string decoded{str};
+            decoded.resize(percent_decode(decoded.data(), decoded.size()));
+            return decoded;
+        }
+
+        /*
+         * Appends a decoded query key or value, percent-encoding the characters not allowed in a query, '%' and the separators of the parameters.
+         */
+        inline void append_query_component(std::string& out, std::string_view component) {
+            auto offset = out.size();
+            out.resize(offset + percent_encoded_size(component, COMPONENT_QUERY_PARAMETER));
+            percent_encode(component, COMPONENT_QUERY_PARAMETER, &out[offset]);
+        }
+
+        /*
+         * QueryParameters
+         */
+
+        QueryParameters::QueryParameters(std::initializer_list<std::pair<std::string_view, std::string_view>> parameters) {
+            _entries.reserve(parameters.size());
+            for (const auto&[key, value] : parameters)
+                add(key, value);
+        }
+
+        QueryParameters::QueryParameters(const std::map<std::string, std::string>& parameters) {
+            _entries.reserve(parameters.size());
+            for (const auto&[key, value] : parameters)
+                add(key, value);
+        }
+
+        QueryParameters QueryParameters::parse(std::string_view query) {
+            QueryParameters parameters;
+            parameters._buffer = query;
+            for (size_t start = 0; start < query.size();) {
+                auto end = std::min(query.find('&', start), query.size());
+                if (end > start) {
+                    auto equal = query.substr(start, end - start).find('=');
+                    auto key_end = equal == std::string_view::npos ? end : start + equal;
+                    auto value_start = equal == std::string_view::npos ? end : key_end + 1;
+                    parameters._entries.push_back({static_cast<u32>(start), static_cast<u32>(key_end - start),
+                                                   static_cast<u32>(value_start), static_cast<u32>(end - value_start)});
+                }
+                start = end + 1;
+            }
+            return parameters;
+        }
+
+        std::vector<QueryParameters::Entry>::const_iterator QueryParameters::find(std::string_view key) const {
+            return std::find_if(_entries.begin(), _entries.end(), [this, key](const Entry& entry) { return equals_decoded(get_key(entry), key); });
+        }
+
+        QueryParameters::Entry QueryParameters::append(std::string_view key, std::string_view value, bool encode) {
+            Entry entry{};
+            entry.key_offset = static_cast<u32>(_buffer.size());
+            if (encode)
+                append_query_component(_buffer, key);
+            else
+                _buffer += key;
+            entry.key_size = static_cast<u32>(_buffer.size() - entry.key_offset);
+            entry.value_offset = static_cast<u32>(_buffer.size());
+            if (encode)
+                append_query_component(_buffer, value);
+            else
+                _buffer += value;
+            entry.value_size = static_cast<u32>(_buffer.size() - entry.value_offset);
+            return entry;
+        }
+
+        void QueryParameters::compact() {
+            if (_unused <= _buffer.size() / 2)
+                return;
+            std::string buffer;
+            buffer.reserve(_buffer.size() - _unused);
+            for (auto& entry : _entries) {
+                auto key_offset = static_cast<u32>(buffer.size());
+                buffer += get_key(entry);
+                auto value_offset = static_cast<u32>(buffer.size());
+                buffer += get_value(entry);
+                entry.key_offset = key_offset;
+                entry.value_offset = value_offset;
+            }
+            _buffer = std::move(buffer);
+            _unused = 0;
+        }
+
+        bool QueryParameters::contains(std::string_view key) const {
+            return find(key) != _entries.end();
+        }
+
+        size_t QueryParameters::count(std::string_view key) const {
+            return static_cast<size_t>(std::count_if(_entries.begin(), _entries.end(), [this, key](const Entry& entry) {
+                return equals_decoded(get_key(entry), key);
+            }));
+        }
+
+        std::optional<std::string_view> QueryParameters::get_raw(std::string_view key) const {
+            auto it = find(key);
+            if (it == _entries.end())
+                return std::nullopt;
+            return get_value(*it);
+        }
+
+        std::optional<std::string> QueryParameters::get(std::string_view key) const {
+            auto it = find(key);
+            if (it == _entries.end())
+                return std::nullopt;
+            return percent_decode(get_value(*it));
+        }
+
+        std::vector<std::string> QueryParameters::get_all(std::string_view key) const {
+            std::vector<std::string> values;
+            for (const auto& entry : _entries)
+                if (equals_decoded(get_key(entry), key))
+                    values.push_back(percent_decode(get_value(entry)));
+            return values;
+        }
+
+        void QueryParameters::add(std::string_view key, std::string_view value) {
+            _entries.push_back(append(key, value, true));
+        }
+
+        void QueryParameters::add_raw(std::string_view key, std::string_view value) {
+            _entries.push_back(append(key, value, false));
+        }
+
+        void QueryParameters::set(std::string_view key, std::string_view value) {
+            auto it = find(key);
+            if (it == _entries.end()) {
+                add(key, value);
+                return;
+            }
+            auto index = static_cast<size_t>(it - _entries.begin());
+            auto& entry = _entries[index];
+            _unused += entry.value_size;
+            auto value_offset = static_cast<u32>(_buffer.size());
+            append_query_component(_buffer, value);
+            entry.value_offset = value_offset;
+            entry.value_size = static_cast<u32>(_buffer.size() - value_offset);
+            // Removes the next parameters with the same key.
+            auto first_removed = std::remove_if(_entries.begin() + index + 1, _entries.end(), [this, key](const Entry& other) {
+                if (!equals_decoded(get_key(other), key))
+                    return false;
+                _unused += other.key_size + other.value_size;
+                return true;
+            });
+            _entries.erase(first_removed, _entries.end());
+            compact();
+        }
 
-        URI::URI(std::string scheme, std::string username, std::string password, Address address, std::string path, const std::map<std::string, std::string>& queries,
+        size_t QueryParameters::remove(std::string_view key) {
+            auto first_removed = std::remove_if(_entries.begin(), _entries.end(), [this, key](const Entry& entry) {
+                if (!equals_decoded(get_key(entry), key))
+                    return false;
+                _unused += entry.key_size + entry.value_size;
+                return true;
+            });
+            auto removed = static_cast<size_t>(_entries.end() - first_removed);
+            _entries.erase(first_removed, _entries.end());
+            compact();
+            return removed;
+        }
+
+        void QueryParameters::clear() noexcept {
+            _buffer.clear();
+            _entries.clear();
+            _unused = 0;
+        }
+
+        std::string QueryParameters::to_string() const {
+            std::string query;
+            query.reserve(_buffer.size() - _unused + _entries.size() * 2);
+            for (const auto& entry : _entries) {
+                if (!query.empty())
+                    query += '&';
+                query += get_key(entry);
+                if (entry.value_size != 0)
+                    query.append(1, '=').append(get_value(entry));
+            }
+            return query;
+        }
+
+        bool QueryParameters::operator==(const QueryParameters& other) const {
+            return std::equal(begin(), end(), other.begin(), other.end());
+        }
+
+        bool QueryParameters::operator!=(const QueryParameters& other) const {
+            return !(*this == other);
+        }
+
+        /*
+         * URI
+         */
+
+        URI::URI(std::string scheme, std::string username, std::string password, Address address, std::string path, QueryParameters queries,
                  std::string fragment)
                 : AbstractPath(std::move(path)),
                   _scheme(std::move(scheme)),
                   _username(std::move(username)),
                   _password(std::move(password)),
                   _address(std::move(address)),
-                  _queries(std::move(fix_queries(queries))),
+                  _queries(std::move(queries)),
                   _fragment(std::move(fragment)) {}
 
         URI::URI(const URI& url) = default;
@@ -122,20 +523,27 @@ namespace lambdacommon
             _address = std::move(address);
         }
 
-        std::map<std::string, std::string> URI::get_queries() const {
+        const QueryParameters& URI::get_queries() const {
+            return _queries;
+        }
+
+        QueryParameters& URI::get_queries() {
             return _queries;
         }
 
-        void URI::set_queries(const std::map<std::string, std::string>& queries) {
-            _queries = std::move(fix_queries(queries));
+        void URI::set_queries(QueryParameters queries) {
+            _queries = std::move(queries);
         }
 
-        bool URI::has_query(const std::string& query) const {
-            return _queries.count(query) > 0;
+        bool URI::has_query(std::string_view query) const {
+            return _queries.contains(query);
         }
 
-        std::string URI::get_query(const std::string& query) const {
-            return _queries.at(query);
+        std::string URI::get_query(std::string_view query) const {
+            auto value = _queries.get(query);
+            if (!value)
+                throw std::out_of_range("The URI has no query parameter " + std::string(query) + ".");
+            return std::move(*value);
         }
 
         const std::string& URI::get_fragment() const {
@@ -146,46 +554,88 @@ namespace lambdacommon
             _fragment = std::move(fragment);
         }
 
-        std::string URI::to_string(char delimiter) const {
-            std::ostringstream oss;
-
+        template<typename Output>
+        void URI::write(Output& output, char delimiter) const {
             // Write the scheme.
-            if (!_scheme.empty())
-                oss << _scheme << ':';
+            if (!_scheme.empty()) {
+                output.append(std::string_view{_scheme});
+                output.append(std::string_view{":"});
+            }
 
             if (!_address.is_empty()) {
-                oss << "//";
+                output.append(std::string_view{"//"});
                 // Write the username and the password.
-                if (!_username.empty() && !_password.empty())
-                    oss << _username << ':' << _password << '@';
+                if (!_username.empty() && !_password.empty()) {
+                    output.append(std::string_view{_username});
+                    output.append(std::string_view{":"});
+                    output.append(std::string_view{_password});
+                    output.append(std::string_view{"@"});
+                }
 
-                // Write the address.
-                oss << _address.to_string();
+                // Write the address, as Address::to_string does.
+                switch (_address.get_type()) {
+                    case IPv6:
+                        output.append(std::string_view{"["});
+                        output.append(std::string_view{_address.get_host()});
+                        output.append(std::string_view{"]"});
+                        break;
+                    case INVALID:
+                        output.append(std::string_view{"INVALID_DOMAIN"});
+                        break;
+                    default:
+                        output.append(std::string_view{_address.get_host()});
+                        break;
+                }
+                if (_address.get_port() != 0) {
+                    char port[8] = {':'};
+                    auto end = std::to_chars(port + 1, port + sizeof(port), _address.get_port()).ptr;
+                    output.append(std::string_view{port, static_cast<size_t>(end - port)});
+                }
             } else if (_scheme == "file")
-                oss << "//";
+                output.append(std::string_view{"//"});
 
-            // Write the path.
-            if (!_path.empty())
-                oss << (!this->is_absolute() ? "/" : "") << AbstractPath::to_string(delimiter);
+            // Write the path, with the specified delimiter.
+            if (!_path.empty()) {
+                if (_path.front() != '/')
+                    output.append(std::string_view{"/"});
+                std::string_view path = _path;
+                for (size_t start = 0;;) {
+                    auto separator = path.find('/', start);
+                    output.append(path.substr(start, separator - start));
+                    if (separator == std::string_view::npos)
+                        break;
+                    output.append(std::string_view{&delimiter, 1});
+                    start = separator + 1;
+                }
+            }
 
             // Write the queries.
-            if (!_queries.empty()) {
-                oss << '?';
-                std::string tmp_separator;
-                for (const auto& query : _queries) {
-                    oss << tmp_separator << query.first;
-                    if (!query.second.empty())
-                        oss << '=' << query.second;
-
-                    tmp_separator = "&";
+            bool first = true;
+            for (const auto&[key, value] : _queries) {
+                output.append(std::string_view{first ? "?" : "&"});
+                output.append(key);
+                if (!value.empty()) {
+                    output.append(std::string_view{"="});
+                    output.append(value);
                 }
+                first = false;
             }
 
             // Write the fragment.
-            if (!_fragment.empty())
-                oss << '#' << _fragment;
+            if (!_fragment.empty()) {
+                output.append(std::string_view{"#"});
+                output.append(std::string_view{_fragment});
+            }
+        }
 
-            return oss.str();
+        std::string URI::to_string(char delimiter) const {
+            std::string result;
+            write(result, delimiter);
+            return result;
+        }
+
+        void URI::serialize(BufferChain& output, char delimiter) const {
+            write(output, delimiter);
         }
 
         void URI::open_in_system() const {
@@ -225,12 +675,24 @@ namespace lambdacommon
             return *this;
         }
 
-        bool URI::operator==(const URI& url) {
+        size_t URI::hash() const {
+            using namespace hashing;
+            u64 hash = hash_string(_scheme);
+            hash = hash_string(_username, hash);
+            hash = hash_string(_password, hash);
+            hash = hash_int(std::hash<Address>()(_address), hash);
+            hash = hash_string(_path, hash);
+            for (const auto&[key, value] : _queries)
+                hash = hash_string(value, hash_string(key, hash));
+            return static_cast<size_t>(hash_string(_fragment, hash));
+        }
+
+        bool URI::operator==(const URI& url) const {
             return _scheme == url._scheme && _username == url._username && _password == url._password && _address == url._address && _path == url._path &&
                    _queries == url._queries && _fragment == url._fragment;
         }
 
-        bool URI::operator!=(const URI& url) {
+        bool URI::operator!=(const URI& url) const {
             return _scheme != url._scheme || _username != url._username || _password != url._password || _address != url._address || _path != url._path ||
                    _queries != url._queries || _fragment != url._fragment;
         }
@@ -254,112 +716,634 @@ namespace lambdacommon
             return {"file", "", "", Address::EMPTY, path.to_generic_string()};
         }
 
+        /*
+         * URI parsing
+         */
+
+        /*
+         * Scans a component until a character of the end class, the characters are checked against the class of the component if validating.
+         */
+        template<bool Validate>
+        inline bool scan_component(std::string_view uri, size_t& i, u8 char_class, u8 end_class) {
+            while (i < uri.size()) {
+                auto c = uri[i];
+                auto classes = URI_CHAR_CLASSES[static_cast<u8>(c)];
+                if (classes & end_class)
+                    break;
+                if constexpr (Validate) {
+                    if (!(classes & char_class)) {
+                        if (c != '%' || uri.size() - i < 3 || !is_hex_digit(uri[i + 1]) || !is_hex_digit(uri[i + 2]))
+                            return false;
+                        i += 2;
+                    }
+                }
+                i++;
+            }
+            return true;
+        }
+
+        template<bool Validate>
+        inline bool is_valid_component(std::string_view component, u8 char_class) {
+            size_t i = 0;
+            return scan_component<Validate>(component, i, char_class, 0);
+        }
+
+        /*
+         * Parses the authority into the userinfo, the host and the port of the view.
+         */
+        template<bool Validate>
+        const char* parse_authority(std::string_view authority, URIView& view) {
+            auto at = authority.rfind('@');
+            if (at != std::string_view::npos) {
+                view.has_userinfo = true;
+                view.userinfo = authority.substr(0, at);
+                authority.remove_prefix(at + 1);
+                if (!is_valid_component<Validate>(view.userinfo, CHAR_USERINFO))
+                    return "invalid userinfo";
+            }
+
+            size_t host_end;
+            if (!authority.empty() && authority[0] == '[') {
+                host_end = authority.find(']');
+                if (host_end == std::string_view::npos)
+                    return "unclosed IP literal";
+                host_end++;
+                if (!is_valid_component<Validate>(authority.substr(1, host_end - 2), CHAR_USERINFO))
+                    return "invalid IP literal";
+            } else {
+                host_end = std::min(authority.find(':'), authority.size());
+                if (!is_valid_component<Validate>(authority.substr(0, host_end), CHAR_HOST))
+                    return "invalid host";
+            }
+            view.host = authority.substr(0, host_end);
+
+            if (host_end < authority.size()) {
+                if (authority[host_end] != ':')
+                    return "invalid host";
+                view.port = authority.substr(host_end + 1);
+                if (view.port.size() > 5)
+                    return "invalid port!";
+                u32 port = 0;
+                for (char c : view.port) {
+                    if (c < '0' || c > '9')
+                        return "invalid port!";
+                    port = port * 10 + static_cast<u32>(c - '0');
+                }
+                if (port > 65535)
+                    return "invalid port!";
+                view.port_number = static_cast<port_t>(port);
+            }
+            return nullptr;
+        }
+
+        /*
+         * Parses an URI in a single pass, the lenient mode only splits the components.
+         * Returns nullptr on success, else the error.
+         */
+        template<bool Validate, bool Relative = false>
+        const char* parse_components(std::string_view uri, URIView& view) {
+            view.source = uri;
+            size_t i = 0;
+            if constexpr (Validate) {
+                if (!uri.empty() && std::isalpha(static_cast<unsigned char>(uri[0])))
+                    while (i < uri.size() && (URI_CHAR_CLASSES[static_cast<u8>(uri[i])] & CHAR_SCHEME))
+                        i++;
+            } else {
+                while (i < uri.size() && uri[i] != ':' && !(URI_CHAR_CLASSES[static_cast<u8>(uri[i])] & END_AUTHORITY))
+                    i++;
+            }
+            if (i == 0 || i == uri.size() || uri[i] != ':') {
+                if constexpr (!Relative)
+                    return "cannot find the scheme separator (':' or '://')!";
+                // A relative reference.
+                i = 0;
+            } else
+                view.scheme = uri.substr(0, i++);
+
+            if (uri.size() - i >= 2 && uri[i] == '/' && uri[i + 1] == '/') {
+                i += 2;
+                view.has_authority = true;
+                auto start = i;
+                scan_component<false>(uri, i, 0, END_AUTHORITY);
+                if (auto error = parse_authority<Validate>(uri.substr(start, i - start), view))
+                    return error;
+            }
+
+            auto start = i;
+            if (!scan_component<Validate>(uri, i, CHAR_PATH, END_PATH))
+                return "invalid path";
+            view.path = uri.substr(start, i - start);
+
+            if (i < uri.size() && uri[i] == '?') {
+                start = ++i;
+                if (!scan_component<Validate>(uri, i, CHAR_QUERY, END_QUERY))
+                    return "invalid query";
+                view.has_query = true;
+                view.query = uri.substr(start, i - start);
+            }
+
+            if (i < uri.size()) {
+                start = ++i;
+                if (!scan_component<Validate>(uri, i, CHAR_QUERY, 0))
+                    return "invalid fragment";
+                view.has_fragment = true;
+                view.fragment = uri.substr(start);
+            }
+            return nullptr;
+        }
+
+        std::string_view URIView::get_username() const {
+            return userinfo.substr(0, userinfo.find(':'));
+        }
+
+        std::string_view URIView::get_password() const {
+            auto separator = userinfo.find(':');
+            return separator == std::string_view::npos ? std::string_view{} : userinfo.substr(separator + 1);
+        }
+
+        std::string_view URIView::get_host_name() const {
+            if (host.size() >= 2 && host.front() == '[')
+                return host.substr(1, host.size() - 2);
+            return host;
+        }
+
+        port_t URIView::get_port_or_default() const {
+            return port.empty() ? get_scheme_default_port(get_scheme_type()) : port_number;
+        }
+
+        URI URIView::to_uri() const {
+            std::string username, password;
+            if (has_userinfo) {
+                if (userinfo.find(':') == std::string_view::npos)
+                    throw ParseException("Cannot parse uri '" + std::string(source) + "': missing username or password!");
+                username = get_username();
+                password = get_password();
+            }
+
+            Address address = Address::EMPTY;
+            if (!host.empty())
+                address = {std::string(get_host_name()), port_number};
+
+            URI result{std::string(scheme), std::move(username), std::move(password), std::move(address), std::string(path), QueryParameters::parse(query),
+                       std::string(fragment)};
+            if (result.get_address().is_empty() && is_scheme_type_non_file_special(result.get_scheme_type()))
+                throw ParseException("Cannot parse uri '" + std::string(source) + "': the scheme doesn't support empty address!");
+            return result;
+        }
+
+        std::optional<URIView> LAMBDACOMMON_API parse_view(std::string_view uri) {
+            URIView view;
+            if (parse_components<true>(uri, view))
+                return std::nullopt;
+            return view;
+        }
+
+        std::optional<URIView> LAMBDACOMMON_API parse_reference_view(std::string_view reference) {
+            URIView view;
+            if (parse_components<true, true>(reference, view))
+                return std::nullopt;
+            return view;
+        }
+
         URI LAMBDACOMMON_API from_string(const std::string& url) {
             if (url.empty())
                 throw std::invalid_argument("URI cannot be empty.");
 
-            auto scheme_separator = url.find_first_of("://");
-            if (scheme_separator == std::string::npos) {
-                scheme_separator = url.find_first_of(':');
-                if (scheme_separator == std::string::npos)
-                    throw ParseException("Cannot parse uri '" + url + "': cannot find the scheme separator (':' or '://')!");
-            }
-            auto scheme = url.substr(0, scheme_separator);
-            auto tmp_uri = url.substr(scheme_separator + 3, url.size());
-
-            auto auth_separator = tmp_uri.find_first_of('@');
-            std::string username;
-            std::string password;
-            if (auth_separator != std::string::npos) {
-                auto user_and_pwd = tmp_uri.substr(0, auth_separator);
-                auto split = lstring::split(user_and_pwd, ':');
-                if (split.size() == 1)
-                    throw ParseException("Cannot parse uri '" + url + "': missing username or password!");
-                username = split[0];
-                password = split[1];
-
-                tmp_uri = tmp_uri.substr(auth_separator + 1, url.size());
-            }
-
-            auto path_separator = tmp_uri.find_first_of('/');
-            auto query_separator = tmp_uri.find_first_of('?');
-            auto fragment_separator = tmp_uri.find_first_of('#');
-
-            if ((query_separator != std::string::npos && path_separator > query_separator) || (fragment_separator != std::string::npos && path_separator > fragment_separator))
-                throw ParseException("Cannot parse uri '" + url + "', malformed URI: path is before query and fragment!");
-
-            std::string tmp_address;
-
-            std::string path;
-            if (path_separator != std::string::npos) {
-                tmp_address = tmp_uri.substr(0, path_separator);
-                if (query_separator != std::string::npos || fragment_separator != std::string::npos) {
-                    if (query_separator < fragment_separator || fragment_separator == std::string::npos)
-                        path = tmp_uri.substr(path_separator + 1, (query_separator - path_separator - 1));
-                    else
-                        path = tmp_uri.substr(path_separator + 1, (fragment_separator - path_separator - 1));
+            URIView view;
+            if (auto error = parse_components<false>(url, view))
+                throw ParseException("Cannot parse uri '" + url + "': " + error);
+            return view.to_uri();
+        }
+
+        /*
+         * Normalization and resolution
+         */
+
+        inline bool is_unreserved(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' || c == '~';
+        }
+
+        /*
+         * Appends a component with its percent-encoded sequences normalized: unreserved characters are decoded, the others are uppercased.
+         */
+        void append_percent_normalized(std::string& out, std::string_view component, bool lowercase) {
+            for (size_t i = 0; i < component.size(); i++) {
+                auto c = component[i];
+                if (c == '%' && component.size() - i >= 3 && is_hex_digit(component[i + 1]) && is_hex_digit(component[i + 2])) {
+                    auto decoded = static_cast<char>((hex_digit_value(component[i + 1]) << 4) | hex_digit_value(component[i + 2]));
+                    if (is_unreserved(decoded))
+                        out += lowercase ? static_cast<char>(std::tolower(static_cast<unsigned char>(decoded))) : decoded;
+                    else {
+                        out += '%';
+                        out += static_cast<char>(std::toupper(static_cast<unsigned char>(component[i + 1])));
+                        out += static_cast<char>(std::toupper(static_cast<unsigned char>(component[i + 2])));
+                    }
+                    i += 2;
                 } else
-                    path = tmp_uri.substr(path_separator);
+                    out += lowercase ? static_cast<char>(std::tolower(static_cast<unsigned char>(c))) : c;
+            }
+        }
+
+        size_t LAMBDACOMMON_API remove_dot_segments(char* path, size_t size) {
+            // The output is never longer than the input, so it is written over the input.
+            size_t read = 0, written = 0;
+            auto remaining = [&]() { return std::string_view{path + read, size - read}; };
+            auto remove_last_segment = [&]() {
+                while (written > 0 && path[written - 1] != '/')
+                    written--;
+                if (written > 0)
+                    written--;
+            };
+            while (read < size) {
+                auto input = remaining();
+                if (lstring::starts_with(input, "../"))
+                    read += 3;
+                else if (lstring::starts_with(input, "./"))
+                    read += 2;
+                else if (lstring::starts_with(input, "/./"))
+                    read += 2;
+                else if (input == "/.") {
+                    read += 1;
+                    path[read] = '/';
+                } else if (lstring::starts_with(input, "/../")) {
+                    read += 3;
+                    remove_last_segment();
+                } else if (input == "/..") {
+                    read += 2;
+                    path[read] = '/';
+                    remove_last_segment();
+                } else if (input == "." || input == "..")
+                    read = size;
+                else {
+                    // Moves the first segment, with its leading '/'.
+                    do
+                        path[written++] = path[read++];
+                    while (read < size && path[read] != '/');
+                }
             }
+            return written;
+        }
 
-            std::map<std::string, std::string> queries;
-            if (query_separator != std::string::npos) {
-                std::string str_queries;
-                if (fragment_separator > query_separator) {
-                    str_queries = tmp_uri.substr(query_separator + 1, (fragment_separator - query_separator - 1));
-                    if (tmp_address.empty())
-                        tmp_address = tmp_uri.substr(0, query_separator);
-                } else
-                    str_queries = tmp_uri.substr(query_separator + 1, tmp_uri.size());
-
-                if (!str_queries.empty()) {
-                    auto splitted_queries = lstring::split(str_queries, '&');
-                    for (const auto& query : splitted_queries) {
-                        size_t j;
-                        if ((j = query.find_first_of('=')) != std::string::npos)
-                            queries[query.substr(0, j)] = query.substr(j + 1, query.size());
-                        else
-                            queries[query] = "";
+        std::string LAMBDACOMMON_API remove_dot_segments(std::string_view path) {
+            std::string result{path};
+            result.resize(remove_dot_segments(result.data(), result.size()));
+            return result;
+        }
+
+        /*
+         * Appends the normalized form of the components of an URI, the scheme and the authority are copied as is if already normalized.
+         */
+        void append_normalized(std::string& out, const URIView& view, bool authority_normalized = false) {
+            if (authority_normalized)
+                out.append(view.scheme);
+            else
+                append_percent_normalized(out, view.scheme, true);
+            out += ':';
+            if (view.has_authority) {
+                out += "//";
+                if (authority_normalized) {
+                    // The authority of a normalized URI is contiguous.
+                    auto start = view.has_userinfo ? view.userinfo.data() : view.host.data();
+                    auto end = view.port.empty() ? view.host.data() + view.host.size() : view.port.data() + view.port.size();
+                    out.append(start, static_cast<size_t>(end - start));
+                } else {
+                    if (view.has_userinfo) {
+                        append_percent_normalized(out, view.userinfo, false);
+                        out += '@';
+                    }
+                    append_percent_normalized(out, view.host, true);
+                    if (!view.port.empty() && view.port_number != get_scheme_default_port(view.get_scheme_type())) {
+                        out += ':';
+                        out += std::to_string(view.port_number);
                     }
                 }
             }
 
-            std::string fragment;
-            if (fragment_separator != std::string::npos) {
-                if (query_separator > fragment_separator) {
-                    fragment = tmp_uri.substr(fragment_separator + 1, (query_separator - fragment_separator - 1));
-                    if (tmp_address.empty())
-                        tmp_address = tmp_uri.substr(0, fragment_separator);
-                } else
-                    fragment = tmp_uri.substr(fragment_separator + 1, tmp_uri.size());
+            auto path_start = out.size();
+            if (view.has_authority && view.path.empty())
+                out += '/';
+            else
+                append_percent_normalized(out, view.path, false);
+            out.resize(path_start + remove_dot_segments(out.data() + path_start, out.size() - path_start));
+
+            if (view.has_query) {
+                out += '?';
+                append_percent_normalized(out, view.query, false);
             }
+            if (view.has_fragment) {
+                out += '#';
+                append_percent_normalized(out, view.fragment, false);
+            }
+        }
 
-            Address address = Address::EMPTY;
-            if (!tmp_address.empty()) {
-                auto address_separator = tmp_address.find_last_of(':');
-                auto end_ipv6 = tmp_address.find_last_of(']');
-                std::string host;
-                if (end_ipv6 != std::string::npos && end_ipv6 > address_separator)
-                    host = tmp_address;
-                else
-                    host = tmp_address.substr(0, address_separator);
-                host = lstring::replace_all(lstring::replace_all(host, "[", ""), "]", "");
-                port_t port = 0;
-                if (address_separator != std::string::npos && address_separator > end_ipv6) {
-                    auto opt_port = lstring::parse_int(tmp_address.substr(address_separator + 1, tmp_address.size()));
-                    if (!opt_port)
-                        throw ParseException("Cannot parse uri '" + url + "': invalid port!");
-                    else port = static_cast<port_t>(*opt_port);
+        std::optional<std::string> LAMBDACOMMON_API normalize(std::string_view uri) {
+            auto view = parse_view(uri);
+            if (!view)
+                return std::nullopt;
+            std::string result;
+            result.reserve(uri.size() + 1);
+            append_normalized(result, *view);
+            return result;
+        }
+
+        /*
+         * Resolves a reference against a parsed base (RFC 3986, section 5.2.2), the merged path is stored in the specified string.
+         */
+        URIView resolve_view(const URIView& base, const URIView& reference, std::string& merged_path) {
+            if (!reference.scheme.empty())
+                return reference;
+
+            URIView target = reference;
+            target.scheme = base.scheme;
+            if (reference.has_authority)
+                return target;
+
+            target.has_authority = base.has_authority;
+            target.has_userinfo = base.has_userinfo;
+            target.userinfo = base.userinfo;
+            target.host = base.host;
+            target.port = base.port;
+            target.port_number = base.port_number;
+            if (reference.path.empty()) {
+                target.path = base.path;
+                if (!reference.has_query) {
+                    target.has_query = base.has_query;
+                    target.query = base.query;
+                }
+            } else if (reference.path.front() != '/') {
+                // Merges the paths (RFC 3986, section 5.2.3).
+                if (base.has_authority && base.path.empty())
+                    merged_path = "/";
+                else {
+                    auto last_slash = base.path.rfind('/');
+                    if (last_slash != std::string_view::npos)
+                        merged_path = base.path.substr(0, last_slash + 1);
                 }
-                address = {std::move(host), port};
+                merged_path += reference.path;
+                target.path = merged_path;
+            }
+            return target;
+        }
+
+        std::optional<std::string> LAMBDACOMMON_API resolve(std::string_view base, std::string_view reference) {
+            auto base_view = parse_view(base);
+            auto reference_view = parse_reference_view(reference);
+            if (!base_view || !reference_view)
+                return std::nullopt;
+            std::string merged_path, result;
+            result.reserve(base.size() + reference.size());
+            append_normalized(result, resolve_view(*base_view, *reference_view, merged_path));
+            return result;
+        }
+
+        URIResolver::URIResolver(size_t capacity) : _capacity(std::max<size_t>(capacity, 1)) {}
+
+        std::optional<std::string> URIResolver::resolve(std::string_view base, std::string_view reference) {
+            auto reference_view = parse_reference_view(reference);
+            if (!reference_view)
+                return std::nullopt;
+
+            // No heterogeneous lookup in C++17, the key is copied into a reused buffer.
+            _key.assign(base);
+            auto it = _bases.find(_key);
+            if (it == _bases.end()) {
+                _misses++;
+                auto normalized = normalize(base);
+                if (!normalized)
+                    return std::nullopt;
+                if (_bases.size() >= _capacity)
+                    _bases.clear();
+                it = _bases.emplace(_key, Base{std::move(*normalized), {}}).first;
+                it->second.view = *parse_view(it->second.normalized);
+            } else
+                _hits++;
+
+            const auto& base_view = it->second.view;
+            std::string merged_path, result;
+            result.reserve(it->second.normalized.size() + reference.size());
+            auto target = resolve_view(base_view, *reference_view, merged_path);
+            // The scheme and the authority of the target come from the normalized base unless the reference has its own.
+            append_normalized(result, target, reference_view->scheme.empty() && !reference_view->has_authority);
+            return result;
+        }
+
+        u64 URIResolver::get_hits() const {
+            return _hits;
+        }
+
+        u64 URIResolver::get_misses() const {
+            return _misses;
+        }
+
+        void URIResolver::clear() {
+            _bases.clear();
+        }
+
+        URI URI::normalize() const {
+            auto normalized = uri::normalize(to_string());
+            if (!normalized)
+                throw ParseException("Cannot normalize uri '" + to_string() + "'.");
+            return parse_view(*normalized)->to_uri();
+        }
+
+        URI URI::resolve(std::string_view reference) const {
+            auto target = uri::resolve(to_string(), reference);
+            if (!target)
+                throw ParseException("Cannot resolve '" + std::string(reference) + "' against '" + to_string() + "'.");
+            return parse_view(*target)->to_uri();
+        }
+
+        /*
+         * Compact URI
+         */
+
+        enum CompactURIFlag : u8
+        {
+            COMPACT_AUTHORITY = 1,
+            COMPACT_USERINFO = 2,
+            COMPACT_QUERY = 4,
+            COMPACT_FRAGMENT = 8
+        };
+
+        CompactURI::CompactURI(std::string serialization, const URIView& view) : _serialization(std::move(serialization)), _port_number(view.port_number) {
+            // The offsets are relative to the parsed string, which has the same content as the serialization.
+            auto offset_of = [&view](std::string_view component) { return static_cast<u16>(component.data() - view.source.data()); };
+            _scheme_end = static_cast<u16>(view.scheme.size());
+            _path_start = offset_of(view.path);
+            _path_end = static_cast<u16>(_path_start + view.path.size());
+            if (view.has_authority) {
+                _host_start = offset_of(view.host);
+                _host_end = static_cast<u16>(_host_start + view.host.size());
+                _flags |= COMPACT_AUTHORITY;
+            } else
+                _host_start = _host_end = _path_start;
+            if (view.has_userinfo)
+                _flags |= COMPACT_USERINFO;
+            _query_end = _path_end;
+            if (view.has_query) {
+                _query_end = static_cast<u16>(offset_of(view.query) + view.query.size());
+                _flags |= COMPACT_QUERY;
             }
+            if (view.has_fragment)
+                _flags |= COMPACT_FRAGMENT;
+        }
+
+        CompactURI::CompactURI(const CompactURI& other, size_t capacity)
+                : _scheme_end(other._scheme_end), _host_start(other._host_start), _host_end(other._host_end), _path_start(other._path_start),
+                  _path_end(other._path_end), _query_end(other._query_end), _port_number(other._port_number), _flags(other._flags) {
+            _serialization.reserve(capacity);
+        }
+
+        CompactURI::CompactURI(const URI& uri) {
+            auto serialization = uri.to_string();
+            auto parsed = parse(serialization);
+            if (!parsed)
+                throw ParseException("Cannot represent uri '" + serialization + "' as a compact URI.");
+            *this = std::move(*parsed);
+        }
+
+        std::optional<CompactURI> CompactURI::parse(std::string_view uri) {
+            if (uri.size() > MAX_SIZE)
+                return std::nullopt;
+            auto view = parse_view(uri);
+            if (!view)
+                return std::nullopt;
+            return CompactURI{std::string(uri), *view};
+        }
+
+        std::string_view CompactURI::get_scheme() const {
+            return std::string_view{_serialization}.substr(0, _scheme_end);
+        }
+
+        std::string_view CompactURI::get_userinfo() const {
+            if (!(_flags & COMPACT_USERINFO))
+                return {};
+            // The userinfo is between "scheme://" and '@'.
+            return std::string_view{_serialization}.substr(_scheme_end + 3, _host_start - _scheme_end - 4);
+        }
+
+        std::string_view CompactURI::get_username() const {
+            auto userinfo = get_userinfo();
+            return userinfo.substr(0, userinfo.find(':'));
+        }
 
-            URI result_uri{std::move(scheme), std::move(username), std::move(password), std::move(address), std::move(path), queries, std::move(fragment)};
+        std::string_view CompactURI::get_password() const {
+            auto userinfo = get_userinfo();
+            auto separator = userinfo.find(':');
+            return separator == std::string_view::npos ? std::string_view{} : userinfo.substr(separator + 1);
+        }
+
+        std::string_view CompactURI::get_host() const {
+            return std::string_view{_serialization}.substr(_host_start, _host_end - _host_start);
+        }
+
+        std::string_view CompactURI::get_host_name() const {
+            auto host = get_host();
+            if (host.size() >= 2 && host.front() == '[')
+                return host.substr(1, host.size() - 2);
+            return host;
+        }
+
+        port_t CompactURI::get_port() const {
+            return _port_number;
+        }
+
+        port_t CompactURI::get_port_or_default() const {
+            // The port is between the host and the path, after ':'.
+            return _path_start - _host_end <= 1 ? get_scheme_default_port(get_scheme_type()) : _port_number;
+        }
+
+        std::string_view CompactURI::get_path() const {
+            return std::string_view{_serialization}.substr(_path_start, _path_end - _path_start);
+        }
+
+        std::string_view CompactURI::get_query() const {
+            if (!(_flags & COMPACT_QUERY))
+                return {};
+            return std::string_view{_serialization}.substr(_path_end + 1, _query_end - _path_end - 1);
+        }
+
+        std::string_view CompactURI::get_fragment() const {
+            if (!(_flags & COMPACT_FRAGMENT))
+                return {};
+            return std::string_view{_serialization}.substr(_query_end + 1);
+        }
+
+        bool CompactURI::has_authority() const {
+            return _flags & COMPACT_AUTHORITY;
+        }
+
+        bool CompactURI::has_query() const {
+            return _flags & COMPACT_QUERY;
+        }
+
+        bool CompactURI::has_fragment() const {
+            return _flags & COMPACT_FRAGMENT;
+        }
+
+        URIView CompactURI::get_view() const {
+            URIView view;
+            view.source = _serialization;
+            view.scheme = get_scheme();
+            view.userinfo = get_userinfo();
+            view.host = get_host();
+            if (_path_start - _host_end > 1)
+                view.port = view.source.substr(_host_end + 1, _path_start - _host_end - 1);
+            view.path = get_path();
+            view.query = get_query();
+            view.fragment = get_fragment();
+            view.port_number = _port_number;
+            view.has_authority = has_authority();
+            view.has_userinfo = _flags & COMPACT_USERINFO;
+            view.has_query = has_query();
+            view.has_fragment = has_fragment();
+            return view;
+        }
+
+        URI CompactURI::to_uri() const {
+            return get_view().to_uri();
+        }
+
+        const std::string& CompactURI::to_string() const {
+            return _serialization;
+        }
+
+        size_t CompactURI::size() const {
+            return _serialization.size();
+        }
+
+        size_t CompactURI::hash() const {
+            return static_cast<size_t>(hashing::hash_string(_serialization));
+        }
+
+        bool CompactURI::operator==(const CompactURI& other) const {
+            // The offsets are derived from the serialization.
+            return _serialization == other._serialization;
+        }
+
+        bool CompactURI::operator!=(const CompactURI& other) const {
+            return _serialization != other._serialization;
+        }
 
-            if (result_uri.get_address().is_empty() && is_scheme_type_non_file_special(result_uri.get_scheme_type()))
-                throw ParseException("Cannot parse uri '" + url + "': the scheme doesn't support empty address!");
+        CompactURI CompactURI::operator/(std::string_view segment) const {
+            auto path = get_path();
+            size_t separator = path.empty() || path.back() != '/' ? 1 : 0;
+            size_t inserted = separator + percent_encoded_size(segment, COMPONENT_PATH_SEGMENT);
+            if (_serialization.size() + inserted > MAX_SIZE)
+                throw std::length_error("The compact URI cannot be longer than " + std::to_string(MAX_SIZE) + " characters.");
 
-            return result_uri;
+            CompactURI result{*this, _serialization.size() + inserted};
+            auto& serialization = result._serialization;
+            serialization.append(_serialization, 0, _path_end);
+            if (separator)
+                serialization += '/';
+            size_t start = serialization.size();
+            serialization.resize(start + inserted - separator);
+            percent_encode(segment, COMPONENT_PATH_SEGMENT, &serialization[start]);
+            serialization.append(_serialization, _path_end, std::string::npos);
+            result._path_end += static_cast<u16>(inserted);
+            result._query_end += static_cast<u16>(inserted);
+            return result;
         }
     }
 }
@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../include/lambdacommon/thread_pool.h"
+#include <algorithm>
+
+namespace lambdacommon
+{
+    ThreadPool::ThreadPool(size_t threads, size_t max_pending) : _max_pending(std::max<size_t>(max_pending, 1)) {
+        if (threads == 0)
+            threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        _threads.reserve(threads);
+        for (size_t i = 0; i < threads; i++)
+            _threads.emplace_back(&ThreadPool::work, this);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _task_available.notify_all();
+        for (auto& thread : _threads)
+            thread.join();
+    }
+
+    void ThreadPool::work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _task_available.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+                // The pending tasks are still executed when stopping.
+                if (_tasks.empty())
+                    return;
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            _space_available.notify_one();
+            try {
+                task();
+            } catch (...) {
+                // A failing task must not kill the worker.
+            }
+        }
+    }
+
+    size_t ThreadPool::get_thread_count() const {
+        return _threads.size();
+    }
+
+    size_t ThreadPool::get_pending_count() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _tasks.size();
+    }
+
+    void ThreadPool::submit(std::function<void()> task) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _space_available.wait(lock, [this]() { return _tasks.size() < _max_pending; });
+            _tasks.push_back(std::move(task));
+        }
+        _task_available.notify_one();
+    }
+}
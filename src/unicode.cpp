@@ -0,0 +1,714 @@
+/*
+ * Copyright © 2019 LambdAurora <aurora42lambda@gmail.com>
+ *
+ * This file is part of λcommon.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../include/lambdacommon/unicode.h"
+#include "../include/lambdacommon/lstring.h"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define LAMBDACOMMON_UNICODE_SSE2
+#  include <emmintrin.h>
+#endif
+
+namespace lambdacommon::unicode
+{
+    /*
+     * ASCII fast path helpers.
+     */
+
+    /*
+     * Checks whether the 16 bytes at the specified address are all ASCII.
+     */
+    inline bool is_ascii_16(const u8* data) {
+#ifdef LAMBDACOMMON_UNICODE_SSE2
+        return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data))) == 0;
+#else
+        u8 mask = 0;
+        for (size_t i = 0; i < 16; i++)
+            mask |= data[i];
+        return (mask & 0x80) == 0;
+#endif
+    }
+
+    /*
+     * Widens 16 ASCII bytes to 16 code units of the output type.
+     */
+    template<typename CharT>
+    inline void widen_ascii_16(const u8* data, CharT* output) {
+#ifdef LAMBDACOMMON_UNICODE_SSE2
+        auto zero = _mm_setzero_si128();
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        auto low = _mm_unpacklo_epi8(bytes, zero), high = _mm_unpackhi_epi8(bytes, zero);
+        if constexpr (sizeof(CharT) == 2) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 8), high);
+            return;
+        } else if constexpr (sizeof(CharT) == 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 8), _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 12), _mm_unpackhi_epi16(high, zero));
+            return;
+        }
+#endif
+        for (size_t i = 0; i < 16; i++)
+            output[i] = static_cast<CharT>(data[i]);
+    }
+
+    /*
+     * Narrows 8 UTF-16 code units to 8 bytes if they are all ASCII.
+     */
+    template<typename CharT>
+    inline bool narrow_ascii_8(const CharT* input, char* output) {
+#ifdef LAMBDACOMMON_UNICODE_SSE2
+        auto units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16(static_cast<short>(0xFF80))), _mm_setzero_si128())) != 0xFFFF)
+            return false;
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm_packus_epi16(units, units));
+        return true;
+#else
+        for (size_t i = 0; i < 8; i++)
+            if (static_cast<u32>(input[i]) >= 0x80)
+                return false;
+        for (size_t i = 0; i < 8; i++)
+            output[i] = static_cast<char>(input[i]);
+        return true;
+#endif
+    }
+
+    /*
+     * Narrows 4 UTF-32 code units to 4 bytes if they are all ASCII.
+     */
+    template<typename CharT>
+    inline bool narrow_ascii_4(const CharT* input, char* output) {
+#ifdef LAMBDACOMMON_UNICODE_SSE2
+        auto units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(units, _mm_set1_epi32(static_cast<int>(0xFFFFFF80))), _mm_setzero_si128())) != 0xFFFF)
+            return false;
+        auto packed = _mm_packus_epi16(_mm_packs_epi32(units, units), units);
+        auto value = _mm_cvtsi128_si32(packed);
+        for (size_t i = 0; i < 4; i++)
+            output[i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+        return true;
+#else
+        for (size_t i = 0; i < 4; i++)
+            if (static_cast<u32>(input[i]) >= 0x80)
+                return false;
+        for (size_t i = 0; i < 4; i++)
+            output[i] = static_cast<char>(input[i]);
+        return true;
+#endif
+    }
+
+    /*
+     * Output sinks.
+     *
+     * ascii() writes 16 ASCII bytes at once and returns false if there isn't enough room (the slow path then reports the exact position),
+     * put() writes one code point and returns false if there isn't enough room.
+     */
+
+    struct NullSink
+    {
+        size_t written = 0;
+
+        bool ascii(const u8*) {
+            return true;
+        }
+
+        bool put(char32_t) {
+            return true;
+        }
+    };
+
+    template<typename CharT>
+    struct Utf32Sink
+    {
+        CharT* output;
+        size_t capacity;
+        size_t written = 0;
+
+        bool ascii(const u8* data) {
+            if (capacity - written < 16)
+                return false;
+            widen_ascii_16(data, output + written);
+            written += 16;
+            return true;
+        }
+
+        bool put(char32_t c) {
+            if (written == capacity)
+                return false;
+            output[written++] = static_cast<CharT>(c);
+            return true;
+        }
+    };
+
+    template<typename CharT>
+    struct Utf16Sink
+    {
+        CharT* output;
+        size_t capacity;
+        size_t written = 0;
+
+        bool ascii(const u8* data) {
+            if (capacity - written < 16)
+                return false;
+            widen_ascii_16(data, output + written);
+            written += 16;
+            return true;
+        }
+
+        bool put(char32_t c) {
+            if (c < 0x10000) {
+                if (written == capacity)
+                    return false;
+                output[written++] = static_cast<CharT>(c);
+            } else {
+                if (capacity - written < 2)
+                    return false;
+                c -= 0x10000;
+                output[written++] = static_cast<CharT>(0xD800 + (c >> 10));
+                output[written++] = static_cast<CharT>(0xDC00 + (c & 0x3FF));
+            }
+            return true;
+        }
+    };
+
+    struct Utf8Sink
+    {
+        char* output;
+        size_t capacity;
+        size_t written = 0;
+
+        bool put(char32_t c) {
+            if (c < 0x80) {
+                if (written == capacity)
+                    return false;
+                output[written++] = static_cast<char>(c);
+            } else if (c < 0x800) {
+                if (capacity - written < 2)
+                    return false;
+                output[written++] = static_cast<char>(0xC0 | (c >> 6));
+                output[written++] = static_cast<char>(0x80 | (c & 0x3F));
+            } else if (c < 0x10000) {
+                if (capacity - written < 3)
+                    return false;
+                output[written++] = static_cast<char>(0xE0 | (c >> 12));
+                output[written++] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+                output[written++] = static_cast<char>(0x80 | (c & 0x3F));
+            } else {
+                if (capacity - written < 4)
+                    return false;
+                output[written++] = static_cast<char>(0xF0 | (c >> 18));
+                output[written++] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+                output[written++] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+                output[written++] = static_cast<char>(0x80 | (c & 0x3F));
+            }
+            return true;
+        }
+    };
+
+    /*
+     * Decoders.
+     */
+
+    /*
+     * Decodes a non-ASCII UTF-8 sequence starting at the specified position.
+     */
+    inline ErrorType decode_utf8_sequence(const u8* data, size_t size, size_t i, char32_t& code_point, size_t& length) {
+        u8 lead = data[i];
+        char32_t min;
+        if (lead < 0xC0)
+            return ErrorType::INVALID_SEQUENCE; // Continuation byte without leading byte.
+        else if (lead < 0xE0) {
+            length = 2;
+            code_point = lead & 0x1F;
+            min = 0x80;
+        } else if (lead < 0xF0) {
+            length = 3;
+            code_point = lead & 0x0F;
+            min = 0x800;
+        } else if (lead < 0xF8) {
+            length = 4;
+            code_point = lead & 0x07;
+            min = 0x10000;
+        } else
+            return ErrorType::INVALID_SEQUENCE;
+
+        for (size_t j = 1; j < length; j++) {
+            if (i + j >= size)
+                return ErrorType::TRUNCATED;
+            if ((data[i + j] & 0xC0) != 0x80)
+                return ErrorType::INVALID_SEQUENCE;
+            code_point = (code_point << 6) | (data[i + j] & 0x3F);
+        }
+
+        if (code_point < min)
+            return ErrorType::OVERLONG;
+        if (code_point > 0x10FFFF)
+            return ErrorType::TOO_LARGE;
+        if (code_point >= 0xD800 && code_point <= 0xDFFF)
+            return ErrorType::SURROGATE;
+        return ErrorType::NONE;
+    }
+
+    template<typename Sink>
+    TranscodeResult decode_utf8(std::string_view input, Sink& sink) {
+        const auto* data = reinterpret_cast<const u8*>(input.data());
+        size_t size = input.size(), i = 0;
+        while (i < size) {
+            if (i + 16 <= size && is_ascii_16(data + i) && sink.ascii(data + i)) {
+                i += 16;
+                continue;
+            }
+
+            char32_t code_point = data[i];
+            size_t length = 1;
+            if (code_point >= 0x80) {
+                auto error = decode_utf8_sequence(data, size, i, code_point, length);
+                if (error != ErrorType::NONE)
+                    return {error, i, sink.written};
+            }
+            if (!sink.put(code_point))
+                return {ErrorType::OUTPUT_TOO_SMALL, i, sink.written};
+            i += length;
+        }
+        return {ErrorType::NONE, size, sink.written};
+    }
+
+    template<typename CharT>
+    TranscodeResult decode_utf16(std::basic_string_view<CharT> input, Utf8Sink* sink) {
+        size_t size = input.size(), i = 0;
+        while (i < size) {
+            if (sink && i + 8 <= size && sink->capacity - sink->written >= 8 && narrow_ascii_8(input.data() + i, sink->output + sink->written)) {
+                sink->written += 8;
+                i += 8;
+                continue;
+            }
+
+            char32_t code_point = static_cast<u16>(input[i]);
+            size_t length = 1;
+            if (code_point >= 0xD800 && code_point <= 0xDFFF) {
+                // A high surrogate must be followed by a low surrogate.
+                if (code_point >= 0xDC00)
+                    return {ErrorType::INVALID_SEQUENCE, i, sink ? sink->written : 0};
+                if (i + 1 >= size)
+                    return {ErrorType::TRUNCATED, i, sink ? sink->written : 0};
+                char32_t low = static_cast<u16>(input[i + 1]);
+                if (low < 0xDC00 || low > 0xDFFF)
+                    return {ErrorType::INVALID_SEQUENCE, i, sink ? sink->written : 0};
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                length = 2;
+            }
+            if (sink && !sink->put(code_point))
+                return {ErrorType::OUTPUT_TOO_SMALL, i, sink->written};
+            i += length;
+        }
+        return {ErrorType::NONE, size, sink ? sink->written : 0};
+    }
+
+    template<typename CharT>
+    TranscodeResult decode_utf32(std::basic_string_view<CharT> input, Utf8Sink* sink) {
+        size_t size = input.size(), i = 0;
+        while (i < size) {
+            if (sink && i + 4 <= size && sink->capacity - sink->written >= 4 && narrow_ascii_4(input.data() + i, sink->output + sink->written)) {
+                sink->written += 4;
+                i += 4;
+                continue;
+            }
+
+            auto code_point = static_cast<char32_t>(input[i]);
+            if (code_point > 0x10FFFF)
+                return {ErrorType::TOO_LARGE, i, sink ? sink->written : 0};
+            if (code_point >= 0xD800 && code_point <= 0xDFFF)
+                return {ErrorType::SURROGATE, i, sink ? sink->written : 0};
+            if (sink && !sink->put(code_point))
+                return {ErrorType::OUTPUT_TOO_SMALL, i, sink->written};
+            i++;
+        }
+        return {ErrorType::NONE, size, sink ? sink->written : 0};
+    }
+
+    /*
+     * Validation
+     */
+
+    TranscodeResult LAMBDACOMMON_API validate_utf8(std::string_view input) {
+        NullSink sink;
+        return decode_utf8(input, sink);
+    }
+
+    TranscodeResult LAMBDACOMMON_API validate_utf16(std::u16string_view input) {
+        return decode_utf16<char16_t>(input, nullptr);
+    }
+
+    TranscodeResult LAMBDACOMMON_API validate_utf32(std::u32string_view input) {
+        return decode_utf32<char32_t>(input, nullptr);
+    }
+
+    /*
+     * Length precomputation
+     */
+
+    size_t LAMBDACOMMON_API utf32_length_from_utf8(std::string_view input) {
+        const auto* data = reinterpret_cast<const u8*>(input.data());
+        size_t size = input.size(), i = 0, count = 0;
+#ifdef LAMBDACOMMON_UNICODE_SSE2
+        // Every byte which isn't a continuation byte (0x80 to 0xBF, so -128 to -65 as signed) starts a code point.
+        for (; i + 16 <= size; i += 16) {
+            auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            auto starts = _mm_cmpgt_epi8(bytes, _mm_set1_epi8(-65));
+            count += std::bitset<16>(static_cast<unsigned>(_mm_movemask_epi8(starts))).count();
+        }
+#endif
+        for (; i < size; i++)
+            if ((data[i] & 0xC0) != 0x80)
+                count++;
+        return count;
+    }
+
+    size_t LAMBDACOMMON_API utf16_length_from_utf8(std::string_view input) {
+        // The 4-byte sequences need a surrogate pair.
+        const auto* data = reinterpret_cast<const u8*>(input.data());
+        size_t count = utf32_length_from_utf8(input);
+        for (size_t i = 0; i < input.size(); i++)
+            if (data[i] >= 0xF0)
+                count++;
+        return count;
+    }
+
+    size_t LAMBDACOMMON_API utf8_length_from_utf16(std::u16string_view input) {
+        size_t count = 0;
+        for (size_t i = 0; i < input.size(); i++) {
+            char16_t unit = input[i];
+            if (unit < 0x80)
+                count++;
+            else if (unit < 0x800)
+                count += 2;
+            else if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < input.size()) {
+                count += 4;
+                i++;
+            } else
+                count += 3;
+        }
+        return count;
+    }
+
+    size_t LAMBDACOMMON_API utf8_length_from_utf32(std::u32string_view input) {
+        size_t count = 0;
+        for (char32_t c : input)
+            count += c < 0x80 ? 1 : (c < 0x800 ? 2 : (c < 0x10000 ? 3 : 4));
+        return count;
+    }
+
+    /*
+     * Conversions into caller buffers
+     */
+
+    TranscodeResult LAMBDACOMMON_API convert_utf8_to_utf32(std::string_view input, char32_t* output, size_t capacity) {
+        Utf32Sink<char32_t> sink{output, capacity};
+        return decode_utf8(input, sink);
+    }
+
+    TranscodeResult LAMBDACOMMON_API convert_utf8_to_utf16(std::string_view input, char16_t* output, size_t capacity) {
+        Utf16Sink<char16_t> sink{output, capacity};
+        return decode_utf8(input, sink);
+    }
+
+    TranscodeResult LAMBDACOMMON_API convert_utf16_to_utf8(std::u16string_view input, char* output, size_t capacity) {
+        Utf8Sink sink{output, capacity};
+        return decode_utf16(input, &sink);
+    }
+
+    TranscodeResult LAMBDACOMMON_API convert_utf32_to_utf8(std::u32string_view input, char* output, size_t capacity) {
+        Utf8Sink sink{output, capacity};
+        return decode_utf32(input, &sink);
+    }
+
+    /*
+     * Allocating conversions
+     */
+
+    std::optional<std::u32string> LAMBDACOMMON_API utf8_to_utf32(std::string_view input) {
+        std::u32string result(utf32_length_from_utf8(input), U'\0');
+        if (!convert_utf8_to_utf32(input, result.data(), result.size()).ok())
+            return std::nullopt;
+        return result;
+    }
+
+    std::optional<std::u16string> LAMBDACOMMON_API utf8_to_utf16(std::string_view input) {
+        std::u16string result(utf16_length_from_utf8(input), u'\0');
+        if (!convert_utf8_to_utf16(input, result.data(), result.size()).ok())
+            return std::nullopt;
+        return result;
+    }
+
+    std::optional<std::string> LAMBDACOMMON_API utf16_to_utf8(std::u16string_view input) {
+        std::string result(utf8_length_from_utf16(input), '\0');
+        if (!convert_utf16_to_utf8(input, result.data(), result.size()).ok())
+            return std::nullopt;
+        return result;
+    }
+
+    std::optional<std::string> LAMBDACOMMON_API utf32_to_utf8(std::u32string_view input) {
+        std::string result(utf8_length_from_utf32(input), '\0');
+        if (!convert_utf32_to_utf8(input, result.data(), result.size()).ok())
+            return std::nullopt;
+        return result;
+    }
+
+    std::optional<std::wstring> LAMBDACOMMON_API utf8_to_wstring(std::string_view input) {
+        TranscodeResult result{};
+        std::wstring output;
+        if constexpr (sizeof(wchar_t) == 2) {
+            output.resize(utf16_length_from_utf8(input));
+            Utf16Sink<wchar_t> sink{output.data(), output.size()};
+            result = decode_utf8(input, sink);
+        } else {
+            output.resize(utf32_length_from_utf8(input));
+            Utf32Sink<wchar_t> sink{output.data(), output.size()};
+            result = decode_utf8(input, sink);
+        }
+        if (!result.ok())
+            return std::nullopt;
+        return output;
+    }
+
+    std::optional<std::string> LAMBDACOMMON_API wstring_to_utf8(std::wstring_view input) {
+        TranscodeResult result{};
+        std::string output;
+        if constexpr (sizeof(wchar_t) == 2) {
+            size_t length = 0;
+            for (size_t i = 0; i < input.size(); i++) {
+                auto unit = static_cast<u16>(input[i]);
+                length += unit < 0x80 ? 1 : (unit < 0x800 ? 2 : (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < input.size() ? (i++, 4) : 3));
+            }
+            output.resize(length);
+            Utf8Sink sink{output.data(), output.size()};
+            result = decode_utf16(input, &sink);
+        } else {
+            size_t length = 0;
+            for (wchar_t c : input) {
+                auto code_point = static_cast<u32>(c);
+                length += code_point < 0x80 ? 1 : (code_point < 0x800 ? 2 : (code_point < 0x10000 ? 3 : 4));
+            }
+            output.resize(length);
+            Utf8Sink sink{output.data(), output.size()};
+            result = decode_utf32(input, &sink);
+        }
+        if (!result.ok())
+            return std::nullopt;
+        return output;
+    }
+}
+
+/*
+ * Display width
+ */
+namespace lambdacommon::lstring::utf8
+{
+    struct CodePointRange
+    {
+        char32_t first;
+        char32_t last;
+    };
+
+    /*
+     * Combining marks, zero-width and format characters (sorted, non-overlapping).
+     */
+    static constexpr CodePointRange ZERO_WIDTH[] = {
+            {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7},
+            {0x0610, 0x061A}, {0x061C, 0x061C}, {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8},
+            {0x06EA, 0x06ED}, {0x0711, 0x0711}, {0x0730, 0x074A}, {0x07A6, 0x07B0}, {0x07EB, 0x07F3}, {0x0816, 0x0819}, {0x081B, 0x0823},
+            {0x0825, 0x0827}, {0x0829, 0x082D}, {0x0859, 0x085B}, {0x08D3, 0x08E1}, {0x08E3, 0x0902}, {0x093A, 0x093A}, {0x093C, 0x093C},
+            {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0962, 0x0963}, {0x0981, 0x0981}, {0x09BC, 0x09BC}, {0x09C1, 0x09C4},
+            {0x09CD, 0x09CD}, {0x09E2, 0x09E3}, {0x0A01, 0x0A02}, {0x0A3C, 0x0A3C}, {0x0A41, 0x0A42}, {0x0A47, 0x0A48}, {0x0A4B, 0x0A4D},
+            {0x0A51, 0x0A51}, {0x0A70, 0x0A71}, {0x0A75, 0x0A75}, {0x0A81, 0x0A82}, {0x0ABC, 0x0ABC}, {0x0AC1, 0x0AC5}, {0x0AC7, 0x0AC8},
+            {0x0ACD, 0x0ACD}, {0x0AE2, 0x0AE3}, {0x0B01, 0x0B01}, {0x0B3C, 0x0B3C}, {0x0B3F, 0x0B3F}, {0x0B41, 0x0B44}, {0x0B4D, 0x0B4D},
+            {0x0B56, 0x0B56}, {0x0B62, 0x0B63}, {0x0B82, 0x0B82}, {0x0BC0, 0x0BC0}, {0x0BCD, 0x0BCD}, {0x0C00, 0x0C00}, {0x0C3E, 0x0C40},
+            {0x0C46, 0x0C48}, {0x0C4A, 0x0C4D}, {0x0C55, 0x0C56}, {0x0C62, 0x0C63}, {0x0CBC, 0x0CBC}, {0x0CCC, 0x0CCD}, {0x0CE2, 0x0CE3},
+            {0x0D00, 0x0D01}, {0x0D41, 0x0D44}, {0x0D4D, 0x0D4D}, {0x0D62, 0x0D63}, {0x0DCA, 0x0DCA}, {0x0DD2, 0x0DD4}, {0x0DD6, 0x0DD6},
+            {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x0EB1, 0x0EB1}, {0x0EB4, 0x0EBC}, {0x0EC8, 0x0ECD}, {0x0F18, 0x0F19},
+            {0x0F35, 0x0F35}, {0x0F37, 0x0F37}, {0x0F39, 0x0F39}, {0x0F71, 0x0F7E}, {0x0F80, 0x0F84}, {0x0F86, 0x0F87}, {0x0F8D, 0x0FBC},
+            {0x0FC6, 0x0FC6}, {0x102D, 0x1030}, {0x1032, 0x1037}, {0x1039, 0x103A}, {0x103D, 0x103E}, {0x1058, 0x1059}, {0x105E, 0x1060},
+            {0x1071, 0x1074}, {0x1082, 0x1082}, {0x1085, 0x1086}, {0x108D, 0x108D}, {0x109D, 0x109D}, {0x1160, 0x11FF}, {0x135D, 0x135F},
+            {0x1712, 0x1714}, {0x1732, 0x1734}, {0x1752, 0x1753}, {0x1772, 0x1773}, {0x17B4, 0x17B5}, {0x17B7, 0x17BD}, {0x17C6, 0x17C6},
+            {0x17C9, 0x17D3}, {0x17DD, 0x17DD}, {0x180B, 0x180E}, {0x1885, 0x1886}, {0x18A9, 0x18A9}, {0x1920, 0x1922}, {0x1927, 0x1928},
+            {0x1932, 0x1932}, {0x1939, 0x193B}, {0x1A17, 0x1A18}, {0x1A1B, 0x1A1B}, {0x1A56, 0x1A56}, {0x1A58, 0x1A60}, {0x1A62, 0x1A62},
+            {0x1A65, 0x1A6C}, {0x1A73, 0x1A7F}, {0x1AB0, 0x1AFF}, {0x1B00, 0x1B03}, {0x1B34, 0x1B34}, {0x1B36, 0x1B3A}, {0x1B3C, 0x1B3C},
+            {0x1B42, 0x1B42}, {0x1B6B, 0x1B73}, {0x1B80, 0x1B81}, {0x1BA2, 0x1BA5}, {0x1BA8, 0x1BA9}, {0x1BAB, 0x1BAD}, {0x1BE6, 0x1BE6},
+            {0x1BE8, 0x1BE9}, {0x1BED, 0x1BED}, {0x1BEF, 0x1BF1}, {0x1C2C, 0x1C33}, {0x1C36, 0x1C37}, {0x1CD0, 0x1CD2}, {0x1CD4, 0x1CE0},
+            {0x1CE2, 0x1CE8}, {0x1CED, 0x1CED}, {0x1CF4, 0x1CF4}, {0x1CF8, 0x1CF9}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x2028, 0x202E},
+            {0x2060, 0x2064}, {0x206A, 0x206F}, {0x20D0, 0x20F0}, {0x2CEF, 0x2CF1}, {0x2D7F, 0x2D7F}, {0x2DE0, 0x2DFF}, {0x302A, 0x302D},
+            {0x3099, 0x309A}, {0xA66F, 0xA672}, {0xA674, 0xA67D}, {0xA69E, 0xA69F}, {0xA6F0, 0xA6F1}, {0xA802, 0xA802}, {0xA806, 0xA806},
+            {0xA80B, 0xA80B}, {0xA825, 0xA826}, {0xA8C4, 0xA8C5}, {0xA8E0, 0xA8F1}, {0xA926, 0xA92D}, {0xA947, 0xA951}, {0xA980, 0xA982},
+            {0xA9B3, 0xA9B3}, {0xA9B6, 0xA9B9}, {0xA9BC, 0xA9BC}, {0xAA29, 0xAA2E}, {0xAA31, 0xAA32}, {0xAA35, 0xAA36}, {0xAA43, 0xAA43},
+            {0xAA4C, 0xAA4C}, {0xAAB0, 0xAAB0}, {0xAAB2, 0xAAB4}, {0xAAB7, 0xAAB8}, {0xAABE, 0xAABF}, {0xAAC1, 0xAAC1}, {0xAAEC, 0xAAED},
+            {0xAAF6, 0xAAF6}, {0xABE5, 0xABE5}, {0xABE8, 0xABE8}, {0xABED, 0xABED}, {0xD7B0, 0xD7FF}, {0xFB1E, 0xFB1E}, {0xFE00, 0xFE0F},
+            {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF}, {0xFFF9, 0xFFFB}, {0x101FD, 0x101FD}, {0x102E0, 0x102E0}, {0x10376, 0x1037A},
+            {0x10A01, 0x10A03}, {0x10A05, 0x10A06}, {0x10A0C, 0x10A0F}, {0x10A38, 0x10A3A}, {0x10A3F, 0x10A3F}, {0x11001, 0x11001},
+            {0x11038, 0x11046}, {0x1107F, 0x11081}, {0x110B3, 0x110B6}, {0x110B9, 0x110BA}, {0x110BD, 0x110BD}, {0x11100, 0x11102},
+            {0x11127, 0x1112B}, {0x1112D, 0x11134}, {0x1D167, 0x1D169}, {0x1D173, 0x1D182}, {0x1D185, 0x1D18B}, {0x1D1AA, 0x1D1AD},
+            {0x1D242, 0x1D244}, {0x1E8D0, 0x1E8D6}, {0x1E944, 0x1E94A}, {0x1F3FB, 0x1F3FF}, {0xE0001, 0xE0001}, {0xE0020, 0xE007F},
+            {0xE0100, 0xE01EF}
+    };
+
+    /*
+     * East Asian wide and fullwidth characters, and emoji with default emoji presentation (sorted, non-overlapping).
+     */
+    static constexpr CodePointRange WIDE[] = {
+            {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE},
+            {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE},
+            {0x26C4, 0x26C5}, {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5}, {0x26FA, 0x26FA},
+            {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+            {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+            {0x2E80, 0x2E99}, {0x2E9B, 0x2EF3}, {0x2F00, 0x2FD5}, {0x2FF0, 0x2FFB}, {0x3000, 0x3029}, {0x302E, 0x303E}, {0x3041, 0x3096},
+            {0x309B, 0x30FF}, {0x3105, 0x312F}, {0x3131, 0x318E}, {0x3190, 0x31E3}, {0x31F0, 0x321E}, {0x3220, 0x3247}, {0x3250, 0x4DBF},
+            {0x4E00, 0xA48C}, {0xA490, 0xA4C6}, {0xA960, 0xA97C}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE52},
+            {0xFE54, 0xFE66}, {0xFE68, 0xFE6B}, {0xFF01, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4}, {0x17000, 0x187F7},
+            {0x18800, 0x18CD5}, {0x1B000, 0x1B2FB}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A},
+            {0x1F200, 0x1F202}, {0x1F210, 0x1F23B}, {0x1F240, 0x1F248}, {0x1F250, 0x1F251}, {0x1F260, 0x1F265}, {0x1F300, 0x1F320},
+            {0x1F32D, 0x1F335}, {0x1F337, 0x1F37C}, {0x1F37E, 0x1F393}, {0x1F3A0, 0x1F3CA}, {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0},
+            {0x1F3F4, 0x1F3F4}, {0x1F3F8, 0x1F3FA}, {0x1F400, 0x1F43E}, {0x1F440, 0x1F440}, {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D},
+            {0x1F54B, 0x1F54E}, {0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596}, {0x1F5A4, 0x1F5A4}, {0x1F5FB, 0x1F64F},
+            {0x1F680, 0x1F6C5}, {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2}, {0x1F6D5, 0x1F6D7}, {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC},
+            {0x1F7E0, 0x1F7EB}, {0x1F90C, 0x1F93A}, {0x1F93C, 0x1F945}, {0x1F947, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD},
+            {0x30000, 0x3FFFD}
+    };
+
+    template<size_t N>
+    constexpr bool is_valid_table(const CodePointRange (& table)[N]) {
+        for (size_t i = 0; i < N; i++)
+            if (table[i].first > table[i].last || (i > 0 && table[i - 1].last >= table[i].first))
+                return false;
+        return true;
+    }
+
+    static_assert(is_valid_table(ZERO_WIDTH) && is_valid_table(WIDE), "The width tables must be sorted and must not overlap.");
+
+    template<size_t N>
+    inline bool in_table(const CodePointRange (& table)[N], char32_t code_point) {
+        if (code_point < table[0].first || code_point > table[N - 1].last)
+            return false;
+        auto it = std::upper_bound(std::begin(table), std::end(table), code_point, [](char32_t c, const CodePointRange& range) {
+            return c < range.first;
+        });
+        return it != std::begin(table) && code_point <= (it - 1)->last;
+    }
+
+    /*
+     * Computes the width of a code point from the range tables.
+     */
+    inline u8 compute_width(char32_t code_point) {
+        if (code_point < 0x7F)
+            return code_point >= 0x20 ? 1 : 0;
+        if (code_point < 0xA0)
+            return 0; // DEL and C1 controls.
+        if (code_point < 0x300)
+            return code_point == 0xAD ? 0 : 1; // SOFT HYPHEN is a format character.
+        if (in_table(ZERO_WIDTH, code_point))
+            return 0;
+        if (code_point >= 0x1100 && in_table(WIDE, code_point))
+            return 2;
+        return 1;
+    }
+
+    /*
+     * Two-stage lookup table of the widths of the planes 0 and 1, derived once from the range tables:
+     * the first stage maps each block of 256 code points to a deduplicated block of 2-bit widths.
+     * Most blocks are uniform so the whole table stays under 5KB.
+     */
+    struct WidthLookup
+    {
+        static constexpr char32_t LIMIT = 0x20000;
+
+        std::array<u8, LIMIT / 256> index{};
+        std::vector<std::array<u8, 64>> blocks;
+
+        WidthLookup() {
+            for (char32_t block_start = 0; block_start < LIMIT; block_start += 256) {
+                std::array<u8, 64> block{};
+                for (char32_t i = 0; i < 256; i++)
+                    block[i / 4] |= compute_width(block_start + i) << ((i % 4) * 2);
+                auto it = std::find(blocks.begin(), blocks.end(), block);
+                index[block_start / 256] = static_cast<u8>(it - blocks.begin());
+                if (it == blocks.end())
+                    blocks.push_back(block);
+            }
+        }
+
+        [[nodiscard]] inline u8 get(char32_t code_point) const {
+            if (code_point >= LIMIT)
+                return compute_width(code_point);
+            return (blocks[index[code_point >> 8]][(code_point & 0xFF) >> 2] >> ((code_point & 3) * 2)) & 3;
+        }
+    };
+
+    static const WidthLookup& get_width_lookup() {
+        static const WidthLookup lookup;
+        return lookup;
+    }
+
+    u8 LAMBDACOMMON_API code_point_width(char32_t code_point) {
+        return get_width_lookup().get(code_point);
+    }
+
+    size_t LAMBDACOMMON_API display_width(std::string_view str) {
+        const char* it = str.data();
+        const char* end = it + str.size();
+        const auto& lookup = get_width_lookup();
+        size_t width = 0;
+        bool after_zwj = false;
+        while (it != end) {
+#ifdef LAMBDACOMMON_UNICODE_SSE2
+            // Printable ASCII is 1 column wide, controls are 0 column wide.
+            if (end - it >= 16) {
+                auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+                auto non_ascii = static_cast<unsigned>(_mm_movemask_epi8(bytes));
+                // Only the ASCII bytes before the first non-ASCII byte are handled here.
+                unsigned ascii_count = non_ascii == 0 ? 16 : 0;
+                while (!(non_ascii & (1u << ascii_count)) && ascii_count < 16)
+                    ascii_count++;
+                if (ascii_count > 0) {
+                    auto printable = _mm_andnot_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(0x7F)), _mm_cmpgt_epi8(bytes, _mm_set1_epi8(0x1F)));
+                    auto printable_mask = static_cast<unsigned>(_mm_movemask_epi8(printable)) & ((1u << ascii_count) - 1u);
+                    width += std::bitset<16>(printable_mask).count();
+                    it += ascii_count;
+                    after_zwj = false;
+                    continue;
+                }
+            }
+#endif
+            auto byte = static_cast<u8>(*it);
+            if (byte < 0x80) {
+                width += byte >= 0x20 && byte != 0x7F;
+                after_zwj = false;
+                it++;
+                continue;
+            }
+
+            char32_t code_point;
+            it += detail::decode(it, end, code_point);
+            if (code_point == 0x200D) {
+                after_zwj = true;
+                continue;
+            }
+            auto cp_width = lookup.get(code_point);
+            // The emoji following a ZERO WIDTH JOINER is rendered in the same cell as the previous one.
+            if (!(after_zwj && cp_width == 2))
+                width += cp_width;
+            after_zwj = false;
+        }
+        return width;
+    }
+}